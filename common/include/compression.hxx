@@ -0,0 +1,213 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#ifndef COMPRESSION_HXX
+#define COMPRESSION_HXX
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <array>
+#include <algorithm>
+
+/*!
+ * A byte oriented LZ77 scheme for compressing data on the wire between flashprog and the programmer,
+ * cheap enough for the programmer to decode and encode at USB line rate. A stream is made of tokens:
+ * - 0b0nnnnnnn: n + 1 literal bytes follow the token
+ * - 0b1nnnnnnn: copy n + minMatch bytes from offset + 1 bytes back in the output, with the
+ *   offset following the token as a little endian uint16_t
+ * Matches are copied forwards a byte at a time, so a match that overlaps its own output repeats
+ * it - a run of a single byte value is just that byte followed by a match one byte back, which
+ * makes this RLE as well as LZ.
+ */
+namespace compression
+{
+	constexpr static size_t maxLiteralRun{128U};
+	constexpr static size_t minMatch{4U};
+	constexpr static size_t maxMatch{127U + minMatch};
+	constexpr static size_t maxOffset{65536U};
+	constexpr static uint8_t matchToken{0x80U};
+	constexpr static uint8_t tokenLengthMask{0x7FU};
+
+	/*!
+	 * Greedy single probe hash chain encoder, as in LZ4's fast mode. Holds the table of where each
+	 * hashed 4 byte sequence was last seen, so is kept around rather than built per block.
+	 * Blocks must be no more than 64KiB long so positions fit the table.
+	 */
+	template<size_t hashBits> struct encoder_t final
+	{
+	private:
+		std::array<uint16_t, 1U << hashBits> table{};
+
+		[[nodiscard]] static uint32_t hash(const uint8_t *const data) noexcept
+		{
+			uint32_t value{};
+			std::memcpy(&value, data, sizeof(value));
+			return (value * 2654435761U) >> (32U - hashBits);
+		}
+
+	public:
+		/*!
+		 * Encode length bytes of input into at most capacity bytes of output, returning how many bytes of
+		 * output that took. Returns 0 if the encoding did not fit, in which case the data should be sent raw.
+		 */
+		[[nodiscard]] size_t encode(const uint8_t *const input, const size_t length,
+			uint8_t *const output, const size_t capacity) noexcept
+		{
+			table.fill(0U);
+			size_t offset{};
+			size_t literalStart{};
+			size_t outputLength{};
+
+			const auto writeLiterals
+			{
+				[&](const size_t end) noexcept
+				{
+					while (literalStart < end)
+					{
+						const auto count{std::min(end - literalStart, maxLiteralRun)};
+						if (outputLength + 1U + count > capacity)
+							return false;
+						output[outputLength++] = static_cast<uint8_t>(count - 1U);
+						std::memcpy(output + outputLength, input + literalStart, count);
+						outputLength += count;
+						literalStart += count;
+					}
+					return true;
+				}
+			};
+
+			while (offset + minMatch <= length)
+			{
+				const auto bucket{hash(input + offset)};
+				const size_t candidate{table[bucket]};
+				table[bucket] = static_cast<uint16_t>(offset);
+				if (candidate >= offset || offset - candidate > maxOffset ||
+					std::memcmp(input + candidate, input + offset, minMatch) != 0)
+				{
+					++offset;
+					continue;
+				}
+
+				auto matchLength{minMatch};
+				while (offset + matchLength < length && matchLength < maxMatch &&
+					input[candidate + matchLength] == input[offset + matchLength])
+					++matchLength;
+				if (!writeLiterals(offset) || outputLength + 3U > capacity)
+					return 0U;
+				const auto distance{offset - candidate - 1U};
+				output[outputLength++] = static_cast<uint8_t>(matchToken | (matchLength - minMatch));
+				output[outputLength++] = static_cast<uint8_t>(distance);
+				output[outputLength++] = static_cast<uint8_t>(distance >> 8U);
+				offset += matchLength;
+				literalStart = offset;
+			}
+			if (!writeLiterals(length))
+				return 0U;
+			return outputLength;
+		}
+	};
+
+	/*!
+	 * Streaming decoder, which can be fed the encoded data in whatever size pieces it arrives in
+	 * (such as USB packets) and decodes each piece straight into the output buffer.
+	 */
+	struct decoder_t final
+	{
+	private:
+		enum class state_t : uint8_t
+		{
+			token,
+			literal,
+			offsetLow,
+			offsetHigh
+		};
+
+		uint8_t *output{nullptr};
+		size_t capacity{};
+		size_t produced_{};
+		size_t remaining{};
+		size_t distance{};
+		state_t state{state_t::token};
+		bool failed{false};
+
+	public:
+		constexpr decoder_t() noexcept = default;
+
+		void reset(uint8_t *const buffer, const size_t length) noexcept
+		{
+			output = buffer;
+			capacity = length;
+			produced_ = 0U;
+			state = state_t::token;
+			failed = false;
+		}
+
+		// Decode another piece of the stream, returning false if the stream is found to be corrupt
+		[[nodiscard]] bool feed(const uint8_t *const data, const size_t length) noexcept
+		{
+			for (size_t offset{}; offset < length && !failed;)
+			{
+				switch (state)
+				{
+					case state_t::token:
+					{
+						const auto token{data[offset++]};
+						if (token & matchToken)
+						{
+							remaining = size_t{uint8_t(token & tokenLengthMask)} + minMatch;
+							state = state_t::offsetLow;
+						}
+						else
+						{
+							remaining = size_t{token} + 1U;
+							state = state_t::literal;
+						}
+						break;
+					}
+					case state_t::literal:
+					{
+						// Copy as much of the literal run as this piece holds in one go
+						const auto count{std::min(remaining, length - offset)};
+						if (count > capacity - produced_)
+						{
+							failed = true;
+							break;
+						}
+						std::memcpy(output + produced_, data + offset, count);
+						produced_ += count;
+						offset += count;
+						remaining -= count;
+						if (!remaining)
+							state = state_t::token;
+						break;
+					}
+					case state_t::offsetLow:
+						distance = data[offset++];
+						state = state_t::offsetHigh;
+						break;
+					case state_t::offsetHigh:
+					{
+						distance |= size_t{data[offset++]} << 8U;
+						++distance;
+						if (distance > produced_ || remaining > capacity - produced_)
+						{
+							failed = true;
+							break;
+						}
+						for (; remaining; --remaining, ++produced_)
+							output[produced_] = output[produced_ - distance];
+						state = state_t::token;
+						break;
+					}
+				}
+			}
+			return !failed;
+		}
+
+		// How many bytes have been decoded so far
+		[[nodiscard]] size_t produced() const noexcept { return produced_; }
+		// Whether the stream decoded so far ends cleanly at a token boundary
+		[[nodiscard]] bool complete() const noexcept { return !failed && state == state_t::token; }
+	};
+} // namespace compression
+
+#endif /*COMPRESSION_HXX*/
@@ -0,0 +1,59 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#ifndef CRC32_HXX
+#define CRC32_HXX
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+
+/*!
+ * The usual reflected CRC-32 (as used by zlib and Ethernet), computed a byte at a time from a
+ * table built at compile time. The programmer and flashprog both use this so checksums of a
+ * range of Flash taken on the programmer can be compared against those of an image on the host.
+ */
+namespace checksum
+{
+	constexpr static uint32_t crc32Polynomial{0xEDB88320U};
+
+	constexpr static auto crc32Table
+	{
+		[]() noexcept
+		{
+			std::array<uint32_t, 256> table{};
+			for (uint32_t index{}; index < table.size(); ++index)
+			{
+				auto value{index};
+				for (uint8_t bit{}; bit < 8U; ++bit)
+					value = (value >> 1U) ^ ((value & 1U) ? crc32Polynomial : 0U);
+				table[index] = value;
+			}
+			return table;
+		}()
+	};
+
+	struct crc32_t final
+	{
+	private:
+		uint32_t state{UINT32_MAX};
+
+	public:
+		constexpr crc32_t() noexcept = default;
+
+		constexpr void update(const uint8_t *const data, const size_t length) noexcept
+		{
+			for (size_t offset{}; offset < length; ++offset)
+				state = crc32Table[(state ^ data[offset]) & 0xFFU] ^ (state >> 8U);
+		}
+
+		[[nodiscard]] constexpr uint32_t value() const noexcept { return state ^ UINT32_MAX; }
+	};
+
+	[[nodiscard]] constexpr inline uint32_t crc32(const uint8_t *const data, const size_t length) noexcept
+	{
+		crc32_t crc{};
+		crc.update(data, length);
+		return crc.value();
+	}
+} // namespace checksum
+
+#endif /*CRC32_HXX*/
@@ -27,7 +27,19 @@ namespace flashProto
 		resetTarget,
 		status,
 		abort,
-		sfdp
+		sfdp,
+		readRange,
+		stats,
+		events,
+		benchmark,
+		busClock,
+		fill,
+		blankCheck,
+		compressedWrite,
+		compressedRead,
+		uniqueID,
+		checksum,
+		badBlocks
 	};
 
 	enum class flashBus_t : uint8_t
@@ -42,9 +54,29 @@ namespace flashProto
 		all,
 		page,
 		pageRange,
+		pageRanges,
 		idle
 	};
 
+	enum class eventType_t : uint8_t
+	{
+		controlRequest,
+		readSetup,
+		readBegin,
+		readComplete,
+		writeSetup,
+		writeBegin,
+		pageProgrammed,
+		writeComplete,
+		eraseSetup,
+		eraseIssue,
+		eraseComplete,
+		busyBegin,
+		busyEnd,
+		abort,
+		error
+	};
+
 	struct page_t final
 	{
 	private:
@@ -173,13 +205,173 @@ namespace flashProto
 			uint8_t eraseComplete{};
 			page_t erasePage{};
 			bool writeOK{};
+			// Which of the ranges of an eraseOperation_t::pageRanges erase is being worked on
+			uint8_t eraseRange{};
+			// Whether the last range read was accepted, and so whether its data is going to follow
+			bool readOK{};
+		};
+
+		// Snapshot of the firmware's performance counters. SPI time covers data transfers, not the command
+		// bytes around them or busy-polling, and USB time includes any Flash work done from the USB handlers.
+		struct stats_t final
+		{
+			// Elapsed time since the counters were last reset, and how that breaks down
+			uint64_t totalCycles{};
+			uint64_t spiCycles{};
+			uint64_t busyCycles{};
+			uint64_t usbCycles{};
+			uint64_t idleCycles{};
+			// The frequency the cycle counters count at, in Hz
+			uint32_t cycleFrequency{};
+			uint32_t bytesRead{};
+			uint32_t bytesWritten{};
+			uint32_t pagesProgrammed{};
+			uint32_t sectorsErased{};
+			uint32_t busyPolls{};
+			// How many bytes compressed reads and writes moved, and how many bytes that took over USB
+			uint32_t compressedBytesRead{};
+			uint32_t compressedWireRead{};
+			uint32_t compressedBytesWritten{};
+			uint32_t compressedWireWritten{};
+		};
+
+		struct event_t final
+		{
+			// When the event occured, in microseconds on the programmer's clock
+			uint32_t timestamp{};
+			eventType_t type{};
+			// The meaning of these depends on the event type - usually the request and the page involved
+			uint8_t argument{};
+			uint16_t value{};
+		};
+
+		// A chunk of the programmer's event log, oldest events first
+		struct events_t final
+		{
+			// The programmer's clock at the time the chunk was taken, for aligning with the host's clock
+			uint32_t timestamp{};
+			// How many more events are waiting to be drained after this chunk
+			uint16_t remaining{};
+			uint8_t count{};
+			// How many events were lost to the log overflowing since it was last drained (saturating)
+			uint8_t dropped{};
+			std::array<event_t, 7> events{};
+		};
+
+		// Result of reading the same block of the target Flash using 8- and then 16-bit SPI frames
+		struct benchmark_t final
+		{
+			uint32_t byteCycles{};
+			uint32_t wordCycles{};
+			// 0 if the programmer can't count cycles
+			uint32_t cycleFrequency{};
+			uint16_t length{};
+			// Whether both reads returned the same data
+			uint8_t match{};
+			uint8_t reserved{};
+		};
+
+		// The external bus clock chosen by training against the targeted chip, all in kHz. These are
+		// 32-bit as chips rated for 104MHz and such need more than 16 bits to say so in kHz
+		struct busClock_t final
+		{
+			uint32_t currentKHz{};
+			// The clock training picked, after backing off from the fastest reliable clock for safety
+			uint32_t trainedKHz{};
+			uint32_t fastestKHz{};
+			// The fastest clock the chip is rated for, or the cap used for unknown chips
+			uint32_t ratedKHz{};
+			// Whether the host has overridden the trained clock
+			uint8_t overridden{};
+			std::array<uint8_t, 3> reserved{};
+		};
+
+		struct fill_t final
+		{
+			// How many bytes of the fill have been programmed so far
+			uint32_t bytesWritten{};
+			// 0 while the fill is running, 1 once it completes, 2 if there's no target and 3 if the fill was invalid
+			uint8_t complete{};
+			bool_t writeOK{};
+			std::array<uint8_t, 2> reserved{};
+		};
+
+		struct blankCheck_t final
+		{
+			// The addresses of the first and last bytes in the range that aren't erased (0xFF)
+			uint32_t firstUsed{};
+			uint32_t lastUsed{};
+			uint32_t bytesScanned{};
+			// 0 while the scan is running, 1 once it completes, 2 if there's no target and 3 if the range was invalid
+			uint8_t complete{};
+			// Whether the whole range is erased, in which case firstUsed and lastUsed are meaningless
+			bool_t blank{};
+			std::array<uint8_t, 2> reserved{};
 		};
 
 		static_assert(sizeof(deviceCount_t) == 3);
 		static_assert(sizeof(listDevice_t) == 16);
 		static_assert(sizeof(erase_t) == 5);
 		static_assert(sizeof(write_t) == 1);
-		static_assert(sizeof(status_t) == 5);
+		static_assert(sizeof(status_t) == 7);
+		static_assert(sizeof(stats_t) == 80);
+		static_assert(sizeof(event_t) == 8);
+		static_assert(sizeof(events_t) == 64);
+		static_assert(sizeof(benchmark_t) == 16);
+		static_assert(sizeof(busClock_t) == 20);
+		static_assert(sizeof(fill_t) == 8);
+		static_assert(sizeof(blankCheck_t) == 16);
+
+		// Compressed reads are streamed back as frames padded out to a whole number of packets, each
+		// holding up to a block of data. The host reads a frame's first packet to find out how long it is.
+		constexpr static uint32_t compressedFrameAlignment{64U};
+		constexpr static uint32_t compressedFrameBlock{4096U};
+
+		struct compressedFrame_t final
+		{
+			// How many bytes of payload follow this header, and how many bytes they decode to.
+			// A frame whose payload is as long as its data is not compressed.
+			uint16_t length{};
+			uint16_t decodedLength{};
+		};
+
+		static_assert(sizeof(compressedFrame_t) == 4);
+
+		// The factory programmed unique ID of the targeted chip, as read with the 0x4B instruction.
+		// Chips with shorter IDs fill out the rest with whatever they return past the end of theirs.
+		struct uniqueID_t final
+		{
+			std::array<uint8_t, 16> id{};
+		};
+
+		struct checksum_t final
+		{
+			// The CRC-32 (as per crc32.hxx) of the range, valid once complete
+			uint32_t crc{};
+			uint32_t bytesScanned{};
+			// 0 while the checksum is running, 1 once it completes, 2 if there's no target and 3 if the range was invalid
+			uint8_t complete{};
+			std::array<uint8_t, 3> reserved{};
+		};
+
+		// A chunk of the targeted NAND's bad block list, starting from the index of the list asked for
+		struct badBlocks_t final
+		{
+			// How many erase blocks the chip has, and how many of those are bad. If the scan found more bad
+			// blocks than the programmer can keep track of, this is just how many of them it kept
+			uint16_t blockCount{};
+			uint16_t badCount{};
+			// 0 while the scan is running, 1 once it completes, 2 if there's no target, 3 if the target isn't
+			// a NAND and 4 if the chip has more bad blocks than the programmer can keep track of
+			uint8_t complete{};
+			// How many of the bad blocks, in ascending order, this chunk carries
+			uint8_t count{};
+			std::array<uint16_t, 29> blocks{};
+		};
+
+		static_assert(sizeof(uniqueID_t) == 16);
+		static_assert(sizeof(checksum_t) == 12);
+		static_assert(sizeof(badBlocks_t) == 64);
 	} // namespace responses
 
 	namespace requests
@@ -205,14 +397,19 @@ namespace flashProto
 
 		struct deviceCount_t final
 		{
+			// The programmer remembers what it identified the chips as until the target is reset or released,
+			// or an abort. Re-scanning has it identify them afresh, unless a chip is targeted.
+			bool rescan{false};
+
 			constexpr deviceCount_t() noexcept = default;
+			constexpr deviceCount_t(const bool rescanChips) noexcept : rescan{rescanChips} { }
 
 #ifndef __arm__
 			[[nodiscard]] bool read(const usbDeviceHandle_t &device, uint8_t interface,
 				responses::deviceCount_t &count) const noexcept
 			{
 				return device.readControl({recipient_t::interface, request_t::typeClass},
-					static_cast<uint8_t>(messages_t::deviceCount), 0, interface, count);
+					static_cast<uint8_t>(messages_t::deviceCount), rescan ? 1U : 0U, interface, count);
 			}
 #endif
 		};
@@ -287,6 +484,27 @@ namespace flashProto
 #endif
 		};
 
+		// The most page ranges a single eraseOperation_t::pageRanges request can carry, which keeps
+		// eraseRanges_t small enough to fit in a single control transfer data packet
+		constexpr static size_t maxEraseRanges{10U};
+
+		struct eraseRanges_t final
+		{
+			uint8_t count{};
+			std::array<erase_t, maxEraseRanges> ranges{};
+
+#ifndef __arm__
+			[[nodiscard]] bool write(const usbDeviceHandle_t &device, uint8_t interface) const noexcept
+			{
+				return device.writeControl({recipient_t::interface, request_t::typeClass},
+					static_cast<uint8_t>(messages_t::erase), static_cast<uint8_t>(eraseOperation_t::pageRanges),
+					interface, *this);
+			}
+#endif
+		};
+
+		static_assert(sizeof(eraseRanges_t) <= 64);
+
 		struct read_t final
 		{
 			page_t page{};
@@ -326,6 +544,72 @@ namespace flashProto
 #endif
 		};
 
+		// This readRange_t is followed by length bytes of data being streamed back
+		// to the host from the IN endpoint, starting at the given byte address. If the
+		// range can't be read, no data follows and the status area's readOK is cleared.
+		struct readRange_t final
+		{
+			uint32_t address{};
+			uint32_t length{};
+
+			constexpr readRange_t() noexcept = default;
+			constexpr readRange_t(const uint32_t startAddress, const uint32_t byteCount) noexcept :
+				address{startAddress}, length{byteCount} { }
+
+#ifndef __arm__
+			[[nodiscard]] bool write(const usbDeviceHandle_t &device, uint8_t interface) const noexcept
+			{
+				return device.writeControl({recipient_t::interface, request_t::typeClass},
+					static_cast<uint8_t>(messages_t::readRange), 0, interface, *this);
+			}
+#endif
+		};
+
+		// This compressedWrite_t is followed by the block's data, encoded as per compression.hxx.
+		// The request's value gives how many bytes of encoded data to expect.
+		struct compressedWrite_t final
+		{
+			page_t page{};
+			bool_t verify{};
+			// How many bytes the data decodes to, at most a transfer block
+			uint16_t length{};
+
+			constexpr compressedWrite_t() noexcept = default;
+			constexpr compressedWrite_t(const page_t pageNumber, const uint16_t byteCount,
+				const bool verifyWrite = false) noexcept :
+				page{pageNumber}, verify{verifyWrite}, length{byteCount} { }
+
+#ifndef __arm__
+			[[nodiscard]] bool write(const usbDeviceHandle_t &device, uint8_t interface,
+				const uint16_t encodedLength) const noexcept
+			{
+				return device.writeControl({recipient_t::interface, request_t::typeClass},
+					static_cast<uint8_t>(messages_t::compressedWrite), encodedLength, interface, *this);
+			}
+#endif
+		};
+
+		// This compressedRead_t is followed by the byte range starting at the given address being
+		// streamed back to the host from the IN endpoint as a series of responses::compressedFrame_t's.
+		// As with readRange_t, a range that can't be read sends no frames and clears the status area's readOK.
+		struct compressedRead_t final
+		{
+			uint32_t address{};
+			uint32_t length{};
+
+			constexpr compressedRead_t() noexcept = default;
+			constexpr compressedRead_t(const uint32_t startAddress, const uint32_t byteCount) noexcept :
+				address{startAddress}, length{byteCount} { }
+
+#ifndef __arm__
+			[[nodiscard]] bool write(const usbDeviceHandle_t &device, uint8_t interface) const noexcept
+			{
+				return device.writeControl({recipient_t::interface, request_t::typeClass},
+					static_cast<uint8_t>(messages_t::compressedRead), 0, interface, *this);
+			}
+#endif
+		};
+
 		struct resetTarget_t final
 		{
 			messages_t type{messages_t::resetTarget};
@@ -343,6 +627,190 @@ namespace flashProto
 #endif
 		};
 
+		struct stats_t final
+		{
+#ifndef __arm__
+			[[nodiscard]] bool read(const usbDeviceHandle_t &device, uint8_t interface,
+				responses::stats_t &stats, const bool reset = false) const noexcept
+			{
+				return device.readControl({recipient_t::interface, request_t::typeClass},
+					static_cast<uint8_t>(messages_t::stats), reset ? 1U : 0U, interface, stats);
+			}
+#endif
+		};
+
+		struct events_t final
+		{
+#ifndef __arm__
+			[[nodiscard]] bool read(const usbDeviceHandle_t &device, uint8_t interface,
+				responses::events_t &events) const noexcept
+			{
+				return device.readControl({recipient_t::interface, request_t::typeClass},
+					static_cast<uint8_t>(messages_t::events), 0, interface, events);
+			}
+#endif
+		};
+
+		struct benchmark_t final
+		{
+#ifndef __arm__
+			[[nodiscard]] bool read(const usbDeviceHandle_t &device, uint8_t interface,
+				responses::benchmark_t &result) const noexcept
+			{
+				return device.readControl({recipient_t::interface, request_t::typeClass},
+					static_cast<uint8_t>(messages_t::benchmark), 0, interface, result);
+			}
+#endif
+		};
+
+		struct busClock_t final
+		{
+#ifndef __arm__
+			[[nodiscard]] bool read(const usbDeviceHandle_t &device, uint8_t interface,
+				responses::busClock_t &busClock) const noexcept
+			{
+				return device.readControl({recipient_t::interface, request_t::typeClass},
+					static_cast<uint8_t>(messages_t::busClock), 0, interface, busClock);
+			}
+
+			// Override the trained clock with the given one, or return to the trained clock if 0. The clock
+			// travels in wValue so is limited to 65535kHz, which is still above what the SSI can generate
+			[[nodiscard]] bool write(const usbDeviceHandle_t &device, uint8_t interface,
+				const uint16_t clockKHz) const noexcept
+			{
+				return device.writeControl({recipient_t::interface, request_t::typeClass},
+					static_cast<uint8_t>(messages_t::busClock), clockKHz, interface, nullptr);
+			}
+#endif
+		};
+
+		// The longest repeating pattern a fill_t can carry
+		constexpr static size_t maxFillPattern{16U};
+
+		// Program length bytes from the given byte address with pattern repeated through them,
+		// the first byte of the pattern landing on address. The target must already be erased.
+		struct fill_t final
+		{
+			uint32_t address{};
+			uint32_t length{};
+			uint8_t patternLength{};
+			bool_t verify{};
+			std::array<uint8_t, maxFillPattern> pattern{};
+
+#ifndef __arm__
+			[[nodiscard]] bool write(const usbDeviceHandle_t &device, uint8_t interface) const noexcept
+			{
+				return device.writeControl({recipient_t::interface, request_t::typeClass},
+					static_cast<uint8_t>(messages_t::fill), 0, interface, *this);
+			}
+
+			// Read back how far the fill has got
+			[[nodiscard]] static bool read(const usbDeviceHandle_t &device, uint8_t interface,
+				responses::fill_t &fill) noexcept
+			{
+				return device.readControl({recipient_t::interface, request_t::typeClass},
+					static_cast<uint8_t>(messages_t::fill), 0, interface, fill);
+			}
+#endif
+		};
+
+		static_assert(sizeof(fill_t) <= 64);
+
+		// Scan length bytes from the given byte address for the first and last bytes that aren't erased
+		struct blankCheck_t final
+		{
+			uint32_t address{};
+			uint32_t length{};
+
+			constexpr blankCheck_t() noexcept = default;
+			constexpr blankCheck_t(const uint32_t startAddress, const uint32_t byteCount) noexcept :
+				address{startAddress}, length{byteCount} { }
+
+#ifndef __arm__
+			[[nodiscard]] bool write(const usbDeviceHandle_t &device, uint8_t interface) const noexcept
+			{
+				return device.writeControl({recipient_t::interface, request_t::typeClass},
+					static_cast<uint8_t>(messages_t::blankCheck), 0, interface, *this);
+			}
+
+			// Read back how far the scan has got, and what it found
+			[[nodiscard]] static bool read(const usbDeviceHandle_t &device, uint8_t interface,
+				responses::blankCheck_t &result) noexcept
+			{
+				return device.readControl({recipient_t::interface, request_t::typeClass},
+					static_cast<uint8_t>(messages_t::blankCheck), 0, interface, result);
+			}
+#endif
+		};
+
+		struct uniqueID_t final
+		{
+#ifndef __arm__
+			[[nodiscard]] bool read(const usbDeviceHandle_t &device, uint8_t interface,
+				responses::uniqueID_t &uniqueID) const noexcept
+			{
+				return device.readControl({recipient_t::interface, request_t::typeClass},
+					static_cast<uint8_t>(messages_t::uniqueID), 0, interface, uniqueID);
+			}
+#endif
+		};
+
+		// Compute the CRC-32 of length bytes from the given byte address on the programmer
+		struct checksum_t final
+		{
+			uint32_t address{};
+			uint32_t length{};
+
+			constexpr checksum_t() noexcept = default;
+			constexpr checksum_t(const uint32_t startAddress, const uint32_t byteCount) noexcept :
+				address{startAddress}, length{byteCount} { }
+
+#ifndef __arm__
+			[[nodiscard]] bool write(const usbDeviceHandle_t &device, uint8_t interface) const noexcept
+			{
+				return device.writeControl({recipient_t::interface, request_t::typeClass},
+					static_cast<uint8_t>(messages_t::checksum), 0, interface, *this);
+			}
+
+			// Read back how far the checksum has got, and the result once it's done
+			[[nodiscard]] static bool read(const usbDeviceHandle_t &device, uint8_t interface,
+				responses::checksum_t &result) noexcept
+			{
+				return device.readControl({recipient_t::interface, request_t::typeClass},
+					static_cast<uint8_t>(messages_t::checksum), 0, interface, result);
+			}
+#endif
+		};
+
+		/*!
+		 * Scan the targeted NAND for its bad blocks - those marked bad at the factory, and those its bad block
+		 * look-up table has put replacements in. The programmer keeps the result for the rest of the targeting
+		 * session, and won't erase the blocks found, so the scan is only run again when asked to rescan.
+		 */
+		struct badBlocks_t final
+		{
+			bool rescan{false};
+
+			constexpr badBlocks_t() noexcept = default;
+			constexpr badBlocks_t(const bool rescanChip) noexcept : rescan{rescanChip} { }
+
+#ifndef __arm__
+			[[nodiscard]] bool write(const usbDeviceHandle_t &device, uint8_t interface) const noexcept
+			{
+				return device.writeControl({recipient_t::interface, request_t::typeClass},
+					static_cast<uint8_t>(messages_t::badBlocks), rescan ? 1U : 0U, interface, nullptr);
+			}
+
+			// Read back how far the scan has got, and once complete, the bad blocks from the given index of the list
+			[[nodiscard]] static bool read(const usbDeviceHandle_t &device, uint8_t interface,
+				const uint16_t first, responses::badBlocks_t &result) noexcept
+			{
+				return device.readControl({recipient_t::interface, request_t::typeClass},
+					static_cast<uint8_t>(messages_t::badBlocks), first, interface, result);
+			}
+#endif
+		};
+
 		struct abort_t final
 		{
 #ifndef __arm__
@@ -374,6 +842,11 @@ namespace flashProto
 		static_assert(sizeof(erase_t) == 6);
 		static_assert(sizeof(read_t) == 3);
 		static_assert(sizeof(write_t) == 4);
+		static_assert(sizeof(readRange_t) == 8);
+		static_assert(sizeof(compressedWrite_t) == 6);
+		static_assert(sizeof(compressedRead_t) == 8);
+		static_assert(sizeof(checksum_t) == 8);
+		static_assert(sizeof(badBlocks_t) == 1);
 	} // namespace requests
 } // namespace flashProto
 
@@ -0,0 +1,222 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: BSD-3-Clause
+from argparse import ArgumentParser
+from pathlib import Path
+from sys import exit
+
+parser = ArgumentParser(
+	description = 'Checks the Flash chip database and generates the forms of it built into flashprog',
+	allow_abbrev = False
+)
+parser.add_argument('target', choices = ('host', 'firmware'), help = 'Which form of the database to generate')
+parser.add_argument('database', type = Path, help = 'Path to the chip database')
+parser.add_argument('output', type = Path, help = 'Path to the header to generate')
+args = parser.parse_args()
+
+sizeSuffixes = {'KiB': 1024, 'MiB': 1024 ** 2, 'GiB': 1024 ** 3}
+timeSuffixes = {'us': 1, 'ms': 1000, 's': 1000 ** 2}
+requiredKeys = ('id', 'capacity', 'page', 'erase', 'program', 'clock')
+knownQuirks = ('pageAddressed', 'continuousRead', 'enter4ByteMode')
+
+class DatabaseError(Exception):
+	pass
+
+def parseSuffixed(value, suffixes):
+	for suffix, scale in sorted(suffixes.items(), key = lambda item: len(item[0]), reverse = True):
+		if suffix and value.endswith(suffix):
+			return float(value[:-len(suffix)]) * scale
+	if '' in suffixes:
+		return float(value) * suffixes['']
+	raise ValueError(value)
+
+def parseSize(value):
+	return int(parseSuffixed(value, {'': 1, **sizeSuffixes}))
+
+def parseTime(value):
+	return int(parseSuffixed(value, timeSuffixes))
+
+def parseOpcode(value):
+	opcode = int(value, 16)
+	if not 0 <= opcode <= 0xFF:
+		raise ValueError(value)
+	return opcode
+
+def parseValue(chip, key, value):
+	fields = value.split()
+	if key == 'id':
+		if len(fields) != 3:
+			raise ValueError(value)
+		chip['id'] = tuple(parseOpcode(field) for field in fields)
+	elif key in ('capacity', 'page'):
+		chip[key] = parseSize(value)
+	elif key == 'erase':
+		if len(fields) != 4:
+			raise ValueError(value)
+		chip.setdefault('erase', []).append((parseOpcode(fields[0]), parseSize(fields[1]),
+			parseTime(fields[2]), parseTime(fields[3])))
+	elif key == 'chipErase':
+		if len(fields) != 3:
+			raise ValueError(value)
+		chip['chipErase'] = (parseOpcode(fields[0]), parseTime(fields[1]), parseTime(fields[2]))
+	elif key == 'program':
+		if len(fields) != 2:
+			raise ValueError(value)
+		chip['program'] = tuple(parseTime(field) for field in fields)
+	elif key == 'clock':
+		if len(fields) != 2:
+			raise ValueError(value)
+		chip['clock'] = tuple(int(field) for field in fields)
+	elif key == 'quirks':
+		for quirk in fields:
+			if quirk not in knownQuirks:
+				raise DatabaseError(f'unknown quirk \'{quirk}\'')
+		chip['quirks'] = fields
+	else:
+		raise DatabaseError(f'unknown key \'{key}\'')
+
+def checkChip(chip):
+	for key in requiredKeys:
+		if key not in chip:
+			raise DatabaseError(f'chip {chip["name"]} is missing its {key}')
+	capacity = chip['capacity']
+	if capacity & (capacity - 1):
+		raise DatabaseError(f'chip {chip["name"]} has a capacity that is not a power of 2')
+
+def parseDatabase(path):
+	chips = []
+	chip = None
+	for lineNumber, line in enumerate(path.read_text().splitlines(), start = 1):
+		line = line.split('#', 1)[0].strip()
+		if not line:
+			continue
+		try:
+			if line.startswith('[') and line.endswith(']'):
+				if chip is not None:
+					checkChip(chip)
+				chip = {'name': line[1:-1].strip()}
+				chips.append(chip)
+				continue
+			if chip is None:
+				raise DatabaseError('value given outside of a chip section')
+			key, separator, value = line.partition('=')
+			if not separator:
+				raise DatabaseError('expected a "key = value" line')
+			parseValue(chip, key.strip(), value.strip())
+		except ValueError as error:
+			raise DatabaseError(f'{path}:{lineNumber}: invalid value {error}')
+		except DatabaseError as error:
+			raise DatabaseError(f'{path}:{lineNumber}: {error}')
+	if chip is not None:
+		checkChip(chip)
+
+	seen = {}
+	for chip in chips:
+		key = (chip['id'][0], chip['id'][1], chip['capacity'])
+		if key in seen:
+			raise DatabaseError(f'{path}: chips {seen[key]} and {chip["name"]} have the same ID and capacity')
+		seen[key] = chip['name']
+	return chips
+
+# The firmware stores page sizes as powers of 2 above this, packed into a nibble each
+firmwareMinPageShift = 8
+
+def log2(value):
+	return value.bit_length() - 1
+
+def packPageSizes(chip):
+	eraseSize = chip['erase'][0][1]
+	pageSize = chip['page']
+	for size in (eraseSize, pageSize):
+		if size & (size - 1) or not 0 <= log2(size) - firmwareMinPageShift <= 15:
+			raise DatabaseError(f'chip {chip["name"]} has a page size the firmware cannot represent')
+	return ((log2(eraseSize) - firmwareMinPageShift) << 4) | (log2(pageSize) - firmwareMinPageShift)
+
+# Chips bigger than this need 4-byte addresses to reach all of them
+threeByteAddressLimit = 16 * 1024 ** 2
+# The 4-byte address forms of the standard erase instructions
+fourByteEraseOpcodes = {0x20: 0x21, 0x52: 0x5C, 0xD8: 0xDC}
+
+def firmwareAddressing(chip):
+	quirks = chip.get('quirks', ())
+	if 'pageAddressed' in quirks:
+		return 'continuousPages' if 'continuousRead' in quirks else 'pageAddressed'
+	if chip['capacity'] <= threeByteAddressLimit:
+		return 'threeByte'
+	if 'enter4ByteMode' in quirks:
+		return 'fourByteMode'
+	return 'fourByteInstructions'
+
+def firmwareEraseOpcode(chip, addressing):
+	opcode = chip['erase'][0][0]
+	if addressing != 'fourByteInstructions':
+		return opcode
+	if opcode not in fourByteEraseOpcodes:
+		raise DatabaseError(f'chip {chip["name"]} has no 4-byte address form of its erase instruction')
+	return fourByteEraseOpcodes[opcode]
+
+def writeFirmwareHeader(chips, output):
+	entries = []
+	for chip in chips:
+		manufacturer, deviceType, capacityID = chip['id']
+		readMHz, fastReadMHz = chip['clock']
+		if readMHz > 255 or fastReadMHz > 255:
+			raise DatabaseError(f'chip {chip["name"]} has a clock the firmware cannot represent')
+		addressing = firmwareAddressing(chip)
+		entries.append(
+			f'\t\t// {chip["name"]}\n'
+			f'\t\t{{0x{manufacturer:02X}U, 0x{deviceType:02X}U, 0x{capacityID:02X}U, {log2(chip["capacity"])}U, '
+			f'0x{firmwareEraseOpcode(chip, addressing):02X}U, 0x{packPageSizes(chip):02X}U, {readMHz}U, '
+			f'{fastReadMHz}U, flashAddressing_t::{addressing}}},\n'
+		)
+	output.write_text(
+		'// SPDX-License-Identifier: BSD-3-Clause\n'
+		'/* THIS FILE IS AUTOGENERATED, DO NOT EDIT */\n'
+		'#ifndef CHIP_TABLE_HXX\n'
+		'#define CHIP_TABLE_HXX\n'
+		'\n'
+		'#include <array>\n'
+		'#include "flash.hxx"\n'
+		'\n'
+		'namespace flash\n'
+		'{\n'
+		'\t// The chips from the chip database, in the order the database gives them\n'
+		f'\tconstexpr static std::array<chipEntry_t, {len(chips)}> chipDatabase\n'
+		'\t{{\n'
+		f'{"".join(entries)}'
+		'\t}};\n'
+		'} // namespace flash\n'
+		'\n'
+		'#endif /*CHIP_TABLE_HXX*/\n'
+	)
+
+def writeHostHeader(database, output):
+	text = database.read_text()
+	if ')chipDB"' in text:
+		raise DatabaseError(f'{database}: the database may not contain the text \')chipDB"\'')
+	output.write_text(
+		'// SPDX-License-Identifier: BSD-3-Clause\n'
+		'/* THIS FILE IS AUTOGENERATED, DO NOT EDIT */\n'
+		'#ifndef BUILTIN_CHIP_DB_HXX\n'
+		'#define BUILTIN_CHIP_DB_HXX\n'
+		'\n'
+		'#include <string_view>\n'
+		'\n'
+		'namespace flashprog::chipDB\n'
+		'{\n'
+		'\tusing namespace std::literals::string_view_literals;\n'
+		'\n'
+		f'\tconstexpr static auto builtinDatabase{{R"chipDB({text})chipDB"sv}};\n'
+		'} // namespace flashprog::chipDB\n'
+		'\n'
+		'#endif /*BUILTIN_CHIP_DB_HXX*/\n'
+	)
+
+try:
+	chips = parseDatabase(args.database)
+	if args.target == 'host':
+		writeHostHeader(args.database, args.output)
+	else:
+		writeFirmwareHeader(chips, args.output)
+except DatabaseError as error:
+	print(error)
+	exit(1)
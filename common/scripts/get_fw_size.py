@@ -117,11 +117,13 @@ def analyze_elf(elf, size_prog):
         if parts[0] == ".text":
             bootloader_size = int(parts[2], 10)
 
-    program_size = sections[".text"] + sections.get(".relocate", 0) + sections.get(".data", 0)
+    # Functions run from RAM are stored in Flash and copied to RAM at startup, so cost both
+    ramfunc_size = sections.get(".ramfunc", 0)
+    program_size = sections[".text"] + sections.get(".relocate", 0) + sections.get(".data", 0) + ramfunc_size
     stack_size = sections[".stack"]
     variables_size = sections.get(".relocate", 0) + sections.get(".data", 0) + sections[".bss"]
 
-    return bootloader_size, program_size, stack_size, variables_size
+    return bootloader_size, program_size, stack_size, variables_size, ramfunc_size
 
 
 def color_for_percent(percentage):
@@ -208,11 +210,13 @@ def main():
         last_data = json.loads(last_file.read_text())
         last_program_size = last_data["program_size"]
         last_variables_size = last_data["variables_size"]
+        last_ramfunc_size = last_data.get("ramfunc_size")
     else:
         last_program_size = None
         last_variables_size = None
+        last_ramfunc_size = None
 
-    bootloader_size, program_size, stack_size, variables_size = analyze_elf(
+    bootloader_size, program_size, stack_size, variables_size, ramfunc_size = analyze_elf(
         args.elf_file, args.size_prog
     )
     if last_file.exists():
@@ -232,6 +236,9 @@ def main():
         MemorySection(
             name="Variables", size=variables_size, last_size=last_variables_size
         ),
+        MemorySection(
+            name="RAM functions", size=ramfunc_size, last_size=last_ramfunc_size
+        ),
     )
 
     if not args.no_last:
@@ -240,6 +247,7 @@ def main():
                 dict(
                     program_size=program_size,
                     variables_size=variables_size,
+                    ramfunc_size=ramfunc_size,
                 )
             )
         )
@@ -0,0 +1,106 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#include <array>
+#include "eventLog.hxx"
+#include "perf.hxx"
+
+using flashProto::responses::event_t;
+using flashProto::responses::events_t;
+
+namespace eventLog
+{
+	struct sysTick_t final
+	{
+		volatile uint32_t ctrl;
+		volatile uint32_t reload;
+		volatile uint32_t value;
+		volatile uint32_t calibration;
+	};
+
+	constexpr static uintptr_t sysTickAddress{0xE000E010U};
+	constexpr static uint32_t sysTickEnable{1U << 0U};
+	constexpr static uint32_t sysTickClockCPU{1U << 2U};
+	// SysTick is a 24-bit down counter
+	constexpr static uint32_t sysTickMask{0x00FFFFFFU};
+	constexpr static uint32_t cyclesPerMicrosecond{perf::cpuFrequency / 1'000'000U};
+
+	// This must be a power of two so the indices can wrap naturally
+	constexpr static size_t logLength{256U};
+	static_assert(logLength == 256U, "The log indices are uint8_t's and rely on wrapping at 256");
+
+	// The log is only touched from the USB interrupt, so needs no further protection
+	// NOLINTBEGIN(cppcoreguidelines-avoid-non-const-global-variables)
+	static std::array<event_t, logLength> events{};
+	static uint8_t head{};
+	static uint16_t count{};
+	static uint8_t dropped{};
+
+	static uint32_t lastValue{};
+	static uint32_t cycles{};
+	static uint32_t microseconds{};
+	// NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables)
+
+	// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast,performance-no-int-to-ptr)
+	static sysTick_t &sysTick() noexcept { return *reinterpret_cast<sysTick_t *>(sysTickAddress); }
+
+	// Unlike the DWT cycle counter, SysTick keeps counting while the processor sleeps in wfi,
+	// so we use it free-running without its interrupt to provide the log's timestamps.
+	void init() noexcept
+	{
+		auto &timer{sysTick()};
+		timer.ctrl = 0;
+		timer.reload = sysTickMask;
+		timer.value = 0;
+		timer.ctrl = sysTickClockCPU | sysTickEnable;
+		lastValue = timer.value;
+		cycles = 0;
+		microseconds = 0;
+		head = 0;
+		count = 0;
+		dropped = 0;
+	}
+
+	void tick() noexcept { static_cast<void>(timestamp()); }
+
+	uint32_t timestamp() noexcept
+	{
+		const auto value{sysTick().value};
+		// The counter counts down, so the elapsed cycles are last - now, modulo the counter's width
+		cycles += (lastValue - value) & sysTickMask;
+		lastValue = value;
+		microseconds += cycles / cyclesPerMicrosecond;
+		cycles %= cyclesPerMicrosecond;
+		return microseconds;
+	}
+
+	void record(const eventType_t type, const uint8_t argument, const uint16_t value) noexcept
+	{
+		// If the log is full, overwrite the oldest event - the most recent history is the most useful
+		if (count == logLength)
+		{
+			if (dropped != UINT8_MAX)
+				++dropped;
+		}
+		else
+			++count;
+		events[head++] = {timestamp(), type, argument, value};
+	}
+
+	void drain(events_t &chunk) noexcept
+	{
+		chunk = {};
+		chunk.timestamp = timestamp();
+		chunk.dropped = dropped;
+		dropped = 0;
+		// The oldest event in the log is count events back from the head
+		auto tail{static_cast<uint8_t>(head - count)};
+		for (auto &event : chunk.events)
+		{
+			if (!count)
+				break;
+			event = events[tail++];
+			--count;
+			++chunk.count;
+		}
+		chunk.remaining = count;
+	}
+} // namespace eventLog
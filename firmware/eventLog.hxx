@@ -0,0 +1,20 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#ifndef EVENT_LOG_HXX
+#define EVENT_LOG_HXX
+
+#include <cstdint>
+#include "usbProtocol.hxx"
+
+namespace eventLog
+{
+	using flashProto::eventType_t;
+
+	void init() noexcept;
+	// Must be called at least every 200ms to keep the clock from losing time - the SOF handler does this
+	void tick() noexcept;
+	[[nodiscard]] uint32_t timestamp() noexcept;
+	void record(eventType_t type, uint8_t argument = 0U, uint16_t value = 0U) noexcept;
+	void drain(flashProto::responses::events_t &chunk) noexcept;
+} // namespace eventLog
+
+#endif /*EVENT_LOG_HXX*/
@@ -3,6 +3,7 @@
 #include <substrate/utility>
 #include <substrate/units>
 #include "flash.hxx"
+#include "chipTable.hxx"
 #include "sfdp.hxx"
 
 #ifdef __GNUC__
@@ -17,72 +18,61 @@ using namespace substrate;
 
 namespace flash
 {
-	struct flashManufacturer_t
+	// Sort the chip table by ID at compile time so chips can be binary searched for in it
+	template<size_t count> [[nodiscard]] constexpr static auto sortChips(std::array<chipEntry_t, count> chips) noexcept
 	{
-		uint8_t manufacturerID;
-		const flashChip_t *chips;
-		size_t chipCount;
-
-		[[nodiscard]] const flashChip_t *begin() const noexcept { return chips; }
-		[[nodiscard]] const flashChip_t *end() const noexcept { return chips + chipCount; }
-	};
-
-	constexpr static auto adestoChips
-	{
-		substrate::make_array<flashChip_t>
-		({
-			{0x32, 0x17, 0x17, 0x20, 4_KiB, 256, 50}
-		})
-	};
-
-	constexpr static auto numonyxChips
-	{
-		substrate::make_array<flashChip_t>
-		({
-			{0x20, 0x14, 0x14, 0xD8, 64_KiB, 256, 33},
-			{0x20, 0x15, 0x15, 0xD8, 64_KiB, 256, 33}
-		})
-	};
+		for (size_t index{1U}; index < count; ++index)
+		{
+			for (size_t entry{index}; entry && chips[entry].id() < chips[entry - 1U].id(); --entry)
+			{
+				const auto chip{chips[entry]};
+				chips[entry] = chips[entry - 1U];
+				chips[entry - 1U] = chip;
+			}
+		}
+		return chips;
+	}
 
-	constexpr static auto gigaDeviceChips
-	{
-		substrate::make_array<flashChip_t>
-		({
-			{0x40, 0x13, 0x13, 0x20, 4_KiB, 256, 80},
-			{0x40, 0x17, 0x17, 0x20, 4_KiB, 256, 80}
-		})
-	};
+	constexpr static auto chipTable{sortChips(chipDatabase)};
 
-	constexpr static auto winbondChips
+	[[nodiscard]] constexpr static const chipEntry_t *lookupChip(const uint32_t chipID) noexcept
 	{
-		substrate::make_array<flashChip_t>
-		({
-			{0x40, 0x14, 0x14, 0x20, 4_KiB, 256, 50},
-			{0x40, 0x15, 0x15, 0x20, 4_KiB, 256, 50},
-			{0x40, 0x16, 0x16, 0x20, 4_KiB, 256, 50},
-			{0x40, 0x18, 0x18, 0x20, 4_KiB, 256, 50},
-			{0xAA, 0x21, 0x1B, 0xD8, 128_KiB, 2_KiB, 104},
-			{0x70, 0x18, 0x18, 0x20, 4_KiB, 256, 50}
-		})
-	};
+		size_t begin{};
+		size_t end{chipTable.size()};
+		while (begin < end)
+		{
+			const auto middle{begin + ((end - begin) / 2U)};
+			const auto middleID{chipTable[middle].id()};
+			if (middleID == chipID)
+				return &chipTable[middle];
+			if (middleID < chipID)
+				begin = middle + 1U;
+			else
+				end = middle;
+		}
+		return nullptr;
+	}
 
-	constexpr static auto manufacturers
+	// Check that no chip appears in the table twice, and that every chip in it can be looked up
+	[[nodiscard]] constexpr static bool chipTableValid() noexcept
 	{
-		substrate::make_array<flashManufacturer_t>
-		({
-			{0x1F, adestoChips.data(), adestoChips.size()},
-			{0x20, numonyxChips.data(), numonyxChips.size()},
-			{0xC8, gigaDeviceChips.data(), gigaDeviceChips.size()},
-			{0xEF, winbondChips.data(), winbondChips.size()},
-		})
-	};
+		for (size_t index{}; index < chipTable.size(); ++index)
+		{
+			if (index && chipTable[index - 1U].id() >= chipTable[index].id())
+				return false;
+			if (lookupChip(chipTable[index].id()) != &chipTable[index])
+				return false;
+		}
+		return lookupChip(packID(0xFFU, 0xFFU, 0xFFU)) == nullptr;
+	}
+	static_assert(chipTableValid(), "The chip database must list each chip only once");
 
 	static inline uint8_t log2(uint32_t value) noexcept
 	{
 		if (unlikely(!value))
 			return UINT8_MAX;
 #if defined(__GNUC__)
-		return (sizeof(uint32_t) * 8U) - static_cast<uint8_t>(__builtin_clz(value));
+		return (sizeof(uint32_t) * 8U) - 1U - static_cast<uint8_t>(__builtin_clz(value));
 #else
 		uint8_t result{};
 		if (value <= UINT32_C(0x0000FFFF))
@@ -107,7 +97,7 @@ namespace flash
 		}
 		if (value <= UINT32_C(0x7FFFFFFF))
 			++result;
-		return (sizeof(uint32_t) * 8U) - result;
+		return (sizeof(uint32_t) * 8U) - 1U - result;
 #endif
 	}
 
@@ -127,36 +117,26 @@ namespace flash
 		device.flashPageSize = parameters->pageSize;
 		// SFDP guarantees 50MHz operation minimum
 		device.chipSpeedMHz = 50U;
+		device.fastReadMHz = parameters->fastRead ? 50U : 0U;
+		device.addressing = parameters->addressing;
 		return device;
 	}
 
 	flashChip_t findChip(const flashID_t chipID, const spiChip_t targetDevice) noexcept
 	{
-		// Loop through the manufacturers
-		for (const auto &mfr : manufacturers)
-		{
-			if (mfr.manufacturerID == chipID.manufacturer)
-			{
-				// Once we've found a matching manufacturer, loop through their devices
-				for (const auto &chip : mfr)
-				{
-					if (chip == chipID)
-					{
-						// If we find the chip in the chipDB, then reclock to its designated speed
-						spiSetClock(targetDevice, chip.chipSpeedMHz);
-						return chip;
-					}
-				}
-				// Once we've exhausted this manufactuer's chipDB, exit out and check SFDP instead
-				break;
-			}
-		}
+		// Look the chip up in the chip table first
+		if (const auto *const chip{lookupChip(packID(chipID))}; chip)
+			return chip->chip();
 		// If we didn't find the chip in the database, no worries - read the SFDP data if available
 		const auto parameters{readSFDP(chipID, targetDevice)};
 		if (parameters)
 			return *parameters;
 		// If we could not read the SFDP data then fabricate something based on some sensible fallbacks
-		// NB: This leaves the bus set to 500kHz as a safe bet (hence the 0 for chipSpeedMHz)
-		return {chipID.type, chipID.capacity, chipID.capacity, 0xD8, 64_KiB, 256, 0};
+		// NB: The 0 for chipSpeedMHz has the bus run at 500kHz as a safe bet, and chips too big for 3-byte
+		// addresses are assumed to have the standard 4-byte address instructions as nearly all modern ones do
+		if (chipID.capacity > 24U)
+			return {chipID.type, chipID.capacity, chipID.capacity, 0xDC, 64_KiB, 256, 0, 0,
+				flashAddressing_t::fourByteInstructions};
+		return {chipID.type, chipID.capacity, chipID.capacity, 0xD8, 64_KiB, 256, 0, 0, flashAddressing_t::threeByte};
 	}
 } // namespace flash
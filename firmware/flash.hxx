@@ -14,6 +14,21 @@ enum class spiChip_t
 	none
 };
 
+// How a chip is addressed
+enum class flashAddressing_t : uint8_t
+{
+	// Plain 3-byte addresses, which reach the first 16MiB
+	threeByte,
+	// The chip's dedicated 4-byte address instructions (0x13, 0x0C, 0x12 and the 4-byte erases)
+	fourByteInstructions,
+	// The normal instructions, once the chip has been switched into 4-byte addressing with 0xB7
+	fourByteMode,
+	// A NAND read and written through its page buffer, a page at a time
+	pageAddressed,
+	// A NAND written a page at a time, but whose reads stream on across pages once started
+	continuousPages,
+};
+
 struct flashID_t
 {
 	uint8_t manufacturer;
@@ -29,15 +44,80 @@ struct flashChip_t
 	uint8_t eraseInstruction;
 	flashProto::page_t erasePageSize;
 	flashProto::page_t flashPageSize;
+	// The maximum clock for the normal read instruction (0x03)
 	uint8_t chipSpeedMHz;
+	// The maximum clock for the fast read instruction (0x0B), or 0 if the chip doesn't support it
+	uint8_t fastReadMHz;
+	flashAddressing_t addressing;
 
 	flashChip_t() = delete;
 	constexpr bool operator ==(const flashID_t id) const noexcept
 		{ return type == id.type && reportedCapacity == id.capacity; }
+	[[nodiscard]] constexpr bool supportsFastRead() const noexcept { return fastReadMHz != 0U; }
+	// Fast read runs the chip at its full clock, whereas the normal read instruction is often limited
+	[[nodiscard]] constexpr uint8_t maxClockMHz() const noexcept
+		{ return supportsFastRead() ? fastReadMHz : chipSpeedMHz; }
+	[[nodiscard]] constexpr bool isPageAddressed() const noexcept
+	{
+		return addressing == flashAddressing_t::pageAddressed ||
+			addressing == flashAddressing_t::continuousPages;
+	}
+	// Whether a read started on the chip runs on through its pages without being re-addressed
+	[[nodiscard]] constexpr bool streamsPages() const noexcept
+		{ return addressing == flashAddressing_t::continuousPages; }
+	// Whether byte addresses sent to the chip are 4 bytes long rather than 3
+	[[nodiscard]] constexpr bool fourByteAddresses() const noexcept
+	{
+		return addressing == flashAddressing_t::fourByteInstructions ||
+			addressing == flashAddressing_t::fourByteMode;
+	}
 };
 
 namespace flash
 {
+	// Chip IDs are packed into a single value so the chip table can be kept sorted and searched by them
+	[[nodiscard]] constexpr inline uint32_t packID(const uint8_t manufacturer, const uint8_t type,
+		const uint8_t capacity) noexcept
+		{ return (uint32_t{manufacturer} << 16U) | (uint32_t{type} << 8U) | capacity; }
+	[[nodiscard]] constexpr inline uint32_t packID(const flashID_t id) noexcept
+		{ return packID(id.manufacturer, id.type, id.capacity); }
+
+	// Page sizes in the chip table are stored as their power of 2 above this
+	constexpr static uint8_t minPageShift{8U};
+
+	/*!
+	 * An entry in the chip table generated from the chip database (common/chips.db), packed down to 9 bytes.
+	 * The erase page size is stored in the top nibble of pageSizes and the program page size in the bottom.
+	 * The erase instruction is the one to use with the chip's addressing, so the 4-byte address form of it
+	 * for chips addressed with their 4-byte instructions.
+	 */
+	struct chipEntry_t
+	{
+		uint8_t manufacturer;
+		uint8_t type;
+		uint8_t reportedCapacity;
+		uint8_t actualCapacity;
+		uint8_t eraseInstruction;
+		uint8_t pageSizes;
+		uint8_t chipSpeedMHz;
+		uint8_t fastReadMHz;
+		flashAddressing_t addressing;
+
+		[[nodiscard]] constexpr uint32_t id() const noexcept
+			{ return packID(manufacturer, type, reportedCapacity); }
+
+		[[nodiscard]] constexpr flashChip_t chip() const noexcept
+		{
+			return
+			{
+				type, reportedCapacity, actualCapacity, eraseInstruction,
+				uint32_t{1U} << ((pageSizes >> 4U) + minPageShift), uint32_t{1U} << ((pageSizes & 0x0FU) + minPageShift),
+				chipSpeedMHz, fastReadMHz, addressing
+			};
+		}
+	};
+	static_assert(sizeof(chipEntry_t) == 9);
+
 	flashChip_t findChip(flashID_t chipID, spiChip_t targetDevice) noexcept;
 }
 
@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#include "perf.hxx"
+
+using flashProto::responses::stats_t;
+
+namespace perf
+{
+	struct dwt_t final
+	{
+		volatile uint32_t ctrl;
+		volatile uint32_t cycleCount;
+	};
+
+	constexpr static uintptr_t dwtAddress{0xE0001000U};
+	constexpr static uintptr_t demcrAddress{0xE000EDFCU};
+	constexpr static uint32_t demcrTraceEnable{1U << 24U};
+	constexpr static uint32_t dwtCtrlCycleCountEnable{1U << 0U};
+
+	// USB start-of-frame packets arrive every 1ms
+	constexpr static uint32_t cyclesPerFrame{cpuFrequency / 1000U};
+
+	// NOLINTBEGIN(cppcoreguidelines-avoid-non-const-global-variables)
+	stats_t counters{};
+	static stats_t snapshotCounters{};
+	static uint32_t frames{};
+	static uint64_t awakeCycles{};
+	static uint32_t lastCycleCount{};
+	// NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables)
+
+	void init() noexcept
+	{
+		// NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast,performance-no-int-to-ptr)
+		auto &demcr{*reinterpret_cast<volatile uint32_t *>(demcrAddress)};
+		auto &dwt{*reinterpret_cast<dwt_t *>(dwtAddress)};
+		// NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast,performance-no-int-to-ptr)
+		// Turn on the trace subsystem so the DWT works, then reset and start its cycle counter
+		demcr |= demcrTraceEnable;
+		dwt.cycleCount = 0;
+		dwt.ctrl |= dwtCtrlCycleCountEnable;
+		reset();
+	}
+
+	// The cycle counter stops while the processor sleeps in wfi, so we use the USB frame clock as our
+	// wall clock. Sampling the cycle counter every frame also keeps us well clear of it wrapping.
+	void frameTick() noexcept
+	{
+		const auto now{cycles()};
+		awakeCycles += now - lastCycleCount;
+		lastCycleCount = now;
+		++frames;
+	}
+
+	void reset() noexcept
+	{
+		counters = {};
+		frames = 0;
+		awakeCycles = 0;
+		lastCycleCount = cycles();
+	}
+
+	// Take a copy of the counters so they can be reset while the copy is still being sent to the host
+	const stats_t &snapshot() noexcept
+	{
+		snapshotCounters = counters;
+		snapshotCounters.totalCycles = uint64_t{frames} * cyclesPerFrame;
+		const auto awake{awakeCycles + (cycles() - lastCycleCount)};
+		// Any time we were not awake for, we were idle
+		snapshotCounters.idleCycles = snapshotCounters.totalCycles > awake ? snapshotCounters.totalCycles - awake : 0U;
+		snapshotCounters.cycleFrequency = cpuFrequency;
+		return snapshotCounters;
+	}
+} // namespace perf
@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#ifndef PERF_HXX
+#define PERF_HXX
+
+#include <cstdint>
+#include "usbProtocol.hxx"
+
+namespace perf
+{
+	constexpr static uint32_t cpuFrequency{80'000'000U};
+	// Location of the Cortex-M4 DWT unit's cycle counter
+	constexpr static uintptr_t dwtCycleCountAddress{0xE0001004U};
+
+	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+	extern flashProto::responses::stats_t counters;
+
+	void init() noexcept;
+	void frameTick() noexcept;
+	void reset() noexcept;
+	[[nodiscard]] const flashProto::responses::stats_t &snapshot() noexcept;
+
+	[[nodiscard]] inline uint32_t cycles() noexcept
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast,performance-no-int-to-ptr)
+		{ return *reinterpret_cast<volatile uint32_t *>(dwtCycleCountAddress); }
+
+	// Accumulates the number of cycles spent in the enclosing scope into the given counter
+	struct cycleTimer_t final
+	{
+	private:
+		uint64_t &accumulator;
+		uint32_t start{cycles()};
+
+	public:
+		cycleTimer_t(uint64_t &accumulator_) noexcept : accumulator{accumulator_} { }
+		cycleTimer_t(const cycleTimer_t &) = delete;
+		cycleTimer_t(cycleTimer_t &&) = delete;
+		cycleTimer_t &operator =(const cycleTimer_t &) = delete;
+		cycleTimer_t &operator =(cycleTimer_t &&) = delete;
+		~cycleTimer_t() noexcept { accumulator += cycles() - start; }
+	};
+} // namespace perf
+
+#endif /*PERF_HXX*/
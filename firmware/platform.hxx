@@ -2,6 +2,10 @@
 #ifndef PLATFORM_HXX
 #define PLATFORM_HXX
 
+// Places a function in RAM (copied there by irqReset()) so it runs without Flash wait states or prefetch stalls.
+// Calls from Flash can't reach RAM with a direct branch, so these must be long calls.
+#define RAMFUNC [[gnu::section(".ramfunc"), gnu::long_call, gnu::noinline]]
+
 void run() noexcept;
 [[gnu::isr]] void irqUSB() noexcept;
 
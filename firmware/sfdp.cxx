@@ -9,6 +9,9 @@ namespace sfdp
 
 	constexpr static std::array<char, 4> sfdpMagic{{'S', 'F', 'D', 'P'}};
 	constexpr static uint16_t basicSPIParameterTable{0xFF00};
+	constexpr static uint16_t fourByteInstructionParameterTable{0xFF84};
+	// Chips bigger than this can't be fully reached with 3-byte addresses
+	constexpr static size_t threeByteAddressLimit{16U * 1024U * 1024U};
 
 	static void sfdpRead(const spiChip_t targetDevice, const uint32_t address, void *const buffer, const size_t bufferLen)
 	{
@@ -29,23 +32,89 @@ namespace sfdp
 	template<typename T> static void sfdpRead(const spiChip_t targetDevice, const uint32_t address, T &buffer)
 		{ return sfdpRead(targetDevice, address, &buffer, sizeof(T)); }
 
-	spiParameters_t readBasicParameterTable(const spiChip_t device, uint32_t address, size_t length)
+	// Map a 3-byte address erase instruction to its 4-byte address form, or 0 if there isn't a standard one
+	static uint8_t fourByteEraseOpcode(const uint8_t opcode) noexcept
+	{
+		switch (opcode)
+		{
+			case 0x20U:
+				return 0x21U;
+			case 0x52U:
+				return 0x5CU;
+			case 0xD8U:
+				return 0xDCU;
+			default:
+				return 0U;
+		}
+	}
+
+	/*!
+	 * Work out how to address chips too big for 3-byte addresses. Dedicated 4-byte address instructions are
+	 * preferred as they leave the chip in its default addressing mode for whatever else uses it; failing that
+	 * the chip is switched into 4-byte addressing for as long as it's targeted.
+	 */
+	static void selectAddressing(spiParameters_t &result, const basicParameterTable_t &parameterTable,
+		const size_t eraseType, const std::optional<fourByteInstructionTable_t> &instructions)
+	{
+		if (result.capacity <= threeByteAddressLimit && parameterTable.addressBytes() != 2U)
+			return;
+
+		if (instructions && instructions->supportsRead() && instructions->supportsPageProgram() &&
+			instructions->supportsErase(eraseType))
+		{
+			result.addressing = flashAddressing_t::fourByteInstructions;
+			result.sectorEraseOpcode = instructions->eraseOpcodes[eraseType];
+			result.fastRead = result.fastRead && instructions->supportsFastRead();
+			return;
+		}
+		// Without a 4BAIT to say otherwise, a chip claiming the dedicated instructions has the standard ones
+		const auto eraseOpcode{fourByteEraseOpcode(result.sectorEraseOpcode)};
+		if (!instructions && parameterTable.hasFourByteInstructions() && eraseOpcode)
+		{
+			result.addressing = flashAddressing_t::fourByteInstructions;
+			result.sectorEraseOpcode = eraseOpcode;
+			return;
+		}
+		if (parameterTable.entersFourByteWithB7() || parameterTable.alwaysFourByte() ||
+			parameterTable.addressBytes() == 2U)
+			result.addressing = flashAddressing_t::fourByteMode;
+		// Otherwise we have no way to reach past the first 16MiB and are stuck with 3-byte addressing
+	}
+
+	spiParameters_t readBasicParameterTable(const spiChip_t device, uint32_t address, size_t length,
+		const std::optional<fourByteInstructionTable_t> &instructions)
 	{
 		basicParameterTable_t parameterTable{};
 		sfdpRead(device, address, &parameterTable, std::min(sizeof(basicParameterTable_t), length));
 
 		spiParameters_t result{};
 		result.capacity = parameterTable.flashMemoryDensity.capacity();
-		for (const auto &eraseType : parameterTable.eraseTypes)
+		size_t sectorEraseType{};
+		for (const auto idx : substrate::indexSequence_t{parameterTable.eraseTypes.size()})
 		{
+			const auto &eraseType{parameterTable.eraseTypes[idx]};
 			if (eraseType.opcode == parameterTable.sectorEraseOpcode)
 			{
 				result.sectorEraseOpcode = eraseType.opcode;
 				result.sectorSize = eraseType.eraseSize();
+				sectorEraseType = idx;
 				break;
 			}
 		}
 		result.pageSize = parameterTable.programmingAndChipEraseTiming.pageSize();
+
+		// The basic parameter table only describes the multi-IO fast reads, none of which the SSI controllers
+		// can do. Any chip that implements them implements the single-IO fast read (0x0B) too though, and
+		// JESD216 fixes that at 8 wait clocks - the same as the 1-1-2 read when the table describes it.
+		result.fastRead = parameterTable.supportsFastRead112() || parameterTable.supportsFastRead122() ||
+			parameterTable.supportsFastRead114() || parameterTable.supportsFastRead144() ||
+			parameterTable.supportsFastRead222() || parameterTable.supportsFastRead444();
+		result.fastReadWaitClocks = parameterTable.supportsFastRead112() ?
+			parameterTable.fastDualOutput.waitClocks() : 8U;
+		// We can only insert whole bytes of wait clocks, so anything else means we can't use fast read safely
+		if (result.fastReadWaitClocks != 8U)
+			result.fastRead = false;
+		selectAddressing(result, parameterTable, sectorEraseType, instructions);
 		return result;
 	}
 
@@ -58,14 +127,26 @@ namespace sfdp
 		// When we've read a valid SFDP header, we now know we can reclock the bus to 50MHz
 		spiSetClock(device, 50U);
 
+		// Find the basic parameter table, and the 4-byte address instruction table if the chip has one
+		std::optional<parameterTableHeader_t> basicTable{};
+		std::optional<fourByteInstructionTable_t> instructions{};
 		for (const auto idx : substrate::indexSequence_t{header.parameterHeadersCount()})
 		{
 			parameterTableHeader_t tableHeader{};
 			sfdpRead(device, tableHeaderAddress + (sizeof(parameterTableHeader_t) * idx), tableHeader);
-			if (tableHeader.jedecParameterID() == basicSPIParameterTable)
-				return readBasicParameterTable(device, tableHeader.tableAddress, tableHeader.tableLength());
+			if (tableHeader.jedecParameterID() == basicSPIParameterTable && !basicTable)
+				basicTable = tableHeader;
+			else if (tableHeader.jedecParameterID() == fourByteInstructionParameterTable && !instructions)
+			{
+				fourByteInstructionTable_t instructionTable{};
+				sfdpRead(device, tableHeader.tableAddress, &instructionTable,
+					std::min(sizeof(fourByteInstructionTable_t), tableHeader.tableLength()));
+				instructions = instructionTable;
+			}
 		}
 
-		return std::nullopt;
+		if (!basicTable)
+			return std::nullopt;
+		return readBasicParameterTable(device, basicTable->tableAddress, basicTable->tableLength(), instructions);
 	}
 } // namespace sfdp
@@ -92,6 +92,12 @@ namespace sfdp
 	{
 		uint8_t timings{};
 		uint8_t opcode{};
+
+		// The number of dummy (wait state) clocks, and of mode bit clocks, between the address and data
+		[[nodiscard]] uint8_t dummyClocks() const noexcept { return timings & 0x1FU; }
+		[[nodiscard]] uint8_t modeClocks() const noexcept { return timings >> 5U; }
+		[[nodiscard]] uint8_t waitClocks() const noexcept
+			{ return static_cast<uint8_t>(dummyClocks() + modeClocks()); }
 	};
 
 	struct [[gnu::packed]] eraseParameters_t
@@ -144,6 +150,34 @@ namespace sfdp
 		std::array<uint8_t, 3> dualAndQuadMode{};
 		uint8_t reserved4{};
 		uint32_t statusAndAddressingMode{};
+
+		// Fast read modes supported, as (instruction, address, data) bus widths. DWORD 1 bits 16 and 20-22
+		[[nodiscard]] bool supportsFastRead112() const noexcept { return value2 & 0x01U; }
+		[[nodiscard]] bool supportsFastRead122() const noexcept { return value2 & 0x10U; }
+		[[nodiscard]] bool supportsFastRead144() const noexcept { return value2 & 0x20U; }
+		[[nodiscard]] bool supportsFastRead114() const noexcept { return value2 & 0x40U; }
+		// DWORD 5 bits 0 and 4
+		[[nodiscard]] bool supportsFastRead222() const noexcept { return fastSupportFlags & 0x01U; }
+		[[nodiscard]] bool supportsFastRead444() const noexcept { return fastSupportFlags & 0x10U; }
+		// DWORD 1 bits 17-18: 0 for 3-byte addressing only, 1 for either 3- or 4-byte, and 2 for 4-byte only
+		[[nodiscard]] uint8_t addressBytes() const noexcept { return (value2 >> 1U) & 0x03U; }
+		// DWORD 16 bits 24-31, the ways the chip can be put into 4-byte addressing
+		[[nodiscard]] bool entersFourByteWithB7() const noexcept { return statusAndAddressingMode & 0x03000000U; }
+		[[nodiscard]] bool hasFourByteInstructions() const noexcept { return statusAndAddressingMode & 0x20000000U; }
+		[[nodiscard]] bool alwaysFourByte() const noexcept { return statusAndAddressingMode & 0x40000000U; }
+	};
+
+	// The JEDEC 4-byte address instruction table (4BAIT)
+	struct fourByteInstructionTable_t
+	{
+		uint32_t support{};
+		std::array<uint8_t, 4> eraseOpcodes{};
+
+		[[nodiscard]] bool supportsRead() const noexcept { return support & 0x00000001U; }
+		[[nodiscard]] bool supportsFastRead() const noexcept { return support & 0x00000002U; }
+		[[nodiscard]] bool supportsPageProgram() const noexcept { return support & 0x00000040U; }
+		[[nodiscard]] bool supportsErase(const size_t eraseType) const noexcept
+			{ return support & (0x00000200U << eraseType); }
 	};
 
 	static_assert(sizeof(uint24_t) == 3);
@@ -153,6 +187,7 @@ namespace sfdp
 	static_assert(sizeof(timingsAndOpcode_t) == 2);
 	static_assert(sizeof(programmingAndChipEraseTiming_t) == 4);
 	static_assert(sizeof(basicParameterTable_t) == 64);
+	static_assert(sizeof(fourByteInstructionTable_t) == 8);
 
 	struct spiParameters_t
 	{
@@ -160,6 +195,11 @@ namespace sfdp
 		uint32_t sectorSize{};
 		size_t capacity{};
 		uint8_t sectorEraseOpcode{};
+		// Whether the chip implements the fast read family of instructions
+		bool fastRead{};
+		// The wait clocks the chip's fast dual output read (0x3B) needs, as a cross-check on fast read
+		uint8_t fastReadWaitClocks{};
+		flashAddressing_t addressing{flashAddressing_t::threeByte};
 	};
 
 	std::optional<spiParameters_t> parameters(spiChip_t device);
@@ -1,4 +1,6 @@
 // SPDX-License-Identifier: BSD-3-Clause
+#include <cstring>
+#include <algorithm>
 #include <tm4c123gh6pm/platform.hxx>
 #include <tm4c123gh6pm/constants.hxx>
 #include "spi.hxx"
@@ -161,6 +163,24 @@ void spiSetClock(const spiChip_t chip, const uint8_t valueMHz) noexcept
 		ssi0.cpsr = speed;
 }
 
+// Switch the specified bus to the given raw CPSR divider, which must be even and at least 2
+void spiSetClockDivider(const spiChip_t chip, const uint8_t divider) noexcept
+{
+	if (chip == spiChip_t::local1 || chip == spiChip_t::local2)
+		ssi1.cpsr = divider;
+	if (chip == spiChip_t::target)
+		ssi0.cpsr = divider;
+}
+
+uint8_t spiClockDivider(const spiChip_t chip) noexcept
+{
+	if (chip == spiChip_t::local1 || chip == spiChip_t::local2)
+		return uint8_t(ssi1.cpsr);
+	if (chip == spiChip_t::target)
+		return uint8_t(ssi0.cpsr);
+	return 0U;
+}
+
 void spiSelect(const spiChip_t chip) noexcept
 {
 	// NOLINTBEGIN(bugprone-branch-clone)
@@ -198,7 +218,7 @@ tivaC::ssi_t *spiDevice(const spiChip_t chip) noexcept
 
 tivaC::ssi_t *spiDevice() noexcept { return spiDevice(targetDevice); }
 
-void spiResync(tivaC::ssi_t &device)
+RAMFUNC static void spiResync(tivaC::ssi_t &device) noexcept
 {
 	// TxFIFOEmpty should always be true on entry as otherwise read-to-write desynced,
 	// but lets check all the same just in case.
@@ -211,7 +231,7 @@ void spiResync(tivaC::ssi_t &device)
 		[[maybe_unused]] const volatile auto _{device.data};
 }
 
-uint8_t spiRead(tivaC::ssi_t &device) noexcept
+RAMFUNC uint8_t spiRead(tivaC::ssi_t &device) noexcept
 {
 	spiResync(device);
 	device.data = 0;
@@ -231,7 +251,7 @@ uint8_t spiRead() noexcept
 	return {};
 }
 
-void spiWrite(tivaC::ssi_t &device, const uint8_t value) noexcept
+RAMFUNC void spiWrite(tivaC::ssi_t &device, const uint8_t value) noexcept
 {
 	spiResync(device);
 	device.data = value;
@@ -296,6 +316,97 @@ flashID_t identDevice(const spiChip_t chip, const bool releaseReset) noexcept
 	return chipID;
 }
 
+namespace spi
+{
+	// The dividers clock training tries, fastest first
+	constexpr static std::array<uint8_t, 11> trainingDividers{{2U, 4U, 6U, 8U, 10U, 12U, 16U, 20U, 40U, 80U, 160U}};
+	// How many times the training pattern must read back correctly for a clock to count as reliable
+	constexpr static size_t trainingPasses{16U};
+	// The SFDP header signature, "SFDP" read as a little endian word
+	constexpr static uint32_t sfdpSignature{0x50444653U};
+
+	// What we read back from the chip to check a clock setting against
+	struct trainingPattern_t final
+	{
+		flashID_t id{};
+		std::array<uint8_t, 8> sfdpHeader{};
+		bool haveHeader{false};
+
+		[[nodiscard]] bool operator ==(const trainingPattern_t &other) const noexcept
+		{
+			return id.manufacturer == other.id.manufacturer && id.type == other.id.type &&
+				id.capacity == other.id.capacity && (!haveHeader || sfdpHeader == other.sfdpHeader);
+		}
+		[[nodiscard]] bool operator !=(const trainingPattern_t &other) const noexcept
+			{ return !(*this == other); }
+	};
+}
+
+static void readSFDPHeader(const spiChip_t chip, std::array<uint8_t, 8> &header) noexcept
+{
+	spiSelect(chip);
+	auto &device{*spiDevice()};
+	spiWrite(device, spiOpcodes::readSFDP);
+	// Address 0, followed by the 8 dummy clocks the instruction requires
+	spiWrite(device, 0U);
+	spiWrite(device, 0U);
+	spiWrite(device, 0U);
+	spiWrite(device, 0U);
+	for (auto &byte : header)
+		byte = spiRead(device);
+	spiSelect(spiChip_t::none);
+}
+
+static trainingPattern_t readTrainingPattern(const spiChip_t chip, const bool withHeader) noexcept
+{
+	trainingPattern_t pattern{};
+	pattern.id = readID(chip);
+	pattern.haveHeader = withHeader;
+	if (withHeader)
+		readSFDPHeader(chip, pattern.sfdpHeader);
+	return pattern;
+}
+
+/*!
+ * Find the fastest clock the chip on the given bus reads back reliably at, no faster than maxMHz.
+ * A reference JEDEC ID and (if the chip has one) SFDP header are taken at 500kHz, then each
+ * candidate divider is tried fastest first until one reads the reference back every time.
+ * The bus is left one step slower than that to leave some margin for temperature and noise.
+ */
+spiClockTraining_t spiTrainClock(const spiChip_t chip, const uint8_t maxMHz) noexcept
+{
+	spiSetClockDivider(chip, safeDivider);
+	auto reference{readTrainingPattern(chip, false)};
+	// If nothing's answering there's nothing to train against
+	if ((reference.id.manufacturer == 0xFFU && reference.id.type == 0xFFU) ||
+		(reference.id.manufacturer == 0x00U && reference.id.type == 0x00U))
+		return {0U, safeDivider};
+	// Only use the SFDP header if the chip has one, as what comes back otherwise need not be stable
+	readSFDPHeader(chip, reference.sfdpHeader);
+	uint32_t signature{};
+	std::memcpy(&signature, reference.sfdpHeader.data(), sizeof(signature));
+	reference.haveHeader = signature == sfdpSignature;
+
+	for (size_t index{}; index < trainingDividers.size(); ++index)
+	{
+		const auto divider{trainingDividers[index]};
+		if (dividerToKHz(divider) > maxMHz * 1000U)
+			continue;
+		spiSetClockDivider(chip, divider);
+		bool reliable{true};
+		for (size_t pass{}; pass < trainingPasses && reliable; ++pass)
+			reliable = readTrainingPattern(chip, reference.haveHeader) == reference;
+		if (reliable)
+		{
+			const auto margin{trainingDividers[std::min(index + 1U, trainingDividers.size() - 1U)]};
+			spiSetClockDivider(chip, margin);
+			return {divider, margin};
+		}
+	}
+	spiSetClockDivider(chip, safeDivider);
+	return {0U, safeDivider};
+}
+
 bool checkDeviceID(const uint8_t index) noexcept
 {
 	return
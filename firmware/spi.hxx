@@ -6,19 +6,32 @@
 #include <array>
 #include <tuple>
 #include <tm4c123gh6pm/platform.hxx>
+#include <tm4c123gh6pm/constants.hxx>
 #include "flash.hxx"
+#include "platform.hxx"
+#include "perf.hxx"
+
+// The result of training a bus's clock, as CPSR divider values (0 if nothing answered reliably)
+struct spiClockTraining_t final
+{
+	uint8_t fastestDivider;
+	uint8_t divider;
+};
 
 void spiInit() noexcept;
 void spiResetClocks() noexcept;
 void spiSetClock(spiChip_t chip, uint8_t valueMHz) noexcept;
+void spiSetClockDivider(spiChip_t chip, uint8_t divider) noexcept;
+[[nodiscard]] uint8_t spiClockDivider(spiChip_t chip) noexcept;
 void spiSelect(spiChip_t chip) noexcept;
 tivaC::ssi_t *spiDevice() noexcept;
 tivaC::ssi_t *spiDevice(spiChip_t chip) noexcept;
-uint8_t spiRead(tivaC::ssi_t &device) noexcept;
-void spiWrite(tivaC::ssi_t &device, uint8_t value) noexcept;
+RAMFUNC uint8_t spiRead(tivaC::ssi_t &device) noexcept;
+RAMFUNC void spiWrite(tivaC::ssi_t &device, uint8_t value) noexcept;
 uint8_t spiRead() noexcept;
 void spiWrite(uint8_t value) noexcept;
 flashID_t identDevice(spiChip_t chip, bool releaseReset = true) noexcept;
+[[nodiscard]] spiClockTraining_t spiTrainClock(spiChip_t chip, uint8_t maxMHz) noexcept;
 void setDeviceReset(bool resetState) noexcept;
 bool isDeviceReset() noexcept;
 
@@ -27,7 +40,216 @@ namespace spi
 	constexpr static const uint8_t internalChips{2};
 	// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
 	extern std::array<flashID_t, internalChips> localChip;
-}
+
+	// The SSI controllers have 8 entry deep transmit and receive FIFOs
+	constexpr static size_t fifoDepth{8U};
+	// The data size (DSS) field of the SSI controllers' CR0 register, and its value for 16-bit frames
+	constexpr static uint32_t ctrl0DataSizeMask{0x0000000FU};
+	constexpr static uint32_t ctrl0Data16Bit{0x0000000FU};
+	// Blocks shorter than this aren't worth switching frame width for
+	constexpr static size_t wideFrameThreshold{8U};
+
+	// The SSI clock is the 80MHz system clock divided by an even CPSR value from 2 to 254
+	constexpr static uint32_t clockKHz{80'000U};
+	constexpr static uint8_t minimumDivider{2U};
+	constexpr static uint8_t maximumDivider{254U};
+	// 500kHz, which every part we might find on the external bus can cope with
+	constexpr static uint8_t safeDivider{160U};
+
+	[[nodiscard]] constexpr inline uint32_t dividerToKHz(const uint8_t divider) noexcept
+		{ return divider ? clockKHz / divider : 0U; }
+
+	// Pick the divider giving the fastest clock that is not faster than requested
+	[[nodiscard]] constexpr inline uint8_t kHzToDivider(const uint32_t valueKHz) noexcept
+	{
+		if (!valueKHz)
+			return maximumDivider;
+		auto divider{(clockKHz + valueKHz - 1U) / valueKHz};
+		divider += divider & 1U;
+		if (divider < minimumDivider)
+			return minimumDivider;
+		if (divider > maximumDivider)
+			return maximumDivider;
+		return uint8_t(divider);
+	}
+
+	enum class bus_t
+	{
+		internal,
+		external
+	};
+
+	/*!
+	 * Data path access to one of the SPI busses, specialised at compile time so the controller's
+	 * registers are constant addresses and the block transfer loops need no per-byte lookups.
+	 */
+	template<bus_t bus> struct spiBus_t final
+	{
+		[[nodiscard, gnu::always_inline]] static tivaC::ssi_t &device() noexcept
+		{
+			// SSI1 is the internal bus, SSI0 is the external.
+			if constexpr (bus == bus_t::internal)
+				return ssi1;
+			else
+				return ssi0;
+		}
+
+		// Bring the FIFOs back in step, discarding anything left in the receive FIFO
+		[[gnu::always_inline]] static void resync() noexcept
+		{
+			auto &ssi{device()};
+			while (!(ssi.status & vals::ssi::statusTxFIFOEmpty))
+				continue;
+			while (ssi.status & vals::ssi::statusRxFIFONotEmpty)
+				// NOLINTNEXTLINE(readability-identifier-length)
+				[[maybe_unused]] const volatile auto _{ssi.data};
+		}
+
+		/*!
+		 * Switch the controller between 8- and 16-bit frames. The controller must be disabled to change
+		 * the frame width, and must have nothing in flight - which the block loops below guarantee.
+		 */
+		[[gnu::always_inline]] static void wideFrames(const bool enable) noexcept
+		{
+			auto &ssi{device()};
+			ssi.ctrl1 = vals::ssi::control1ModeController;
+			ssi.ctrl0 = (ssi.ctrl0 & ~ctrl0DataSizeMask) | (enable ? ctrl0Data16Bit : vals::ssi::ctrl0Data8Bit);
+			ssi.ctrl1 = vals::ssi::control1ModeController | vals::ssi::control1EnableOperations;
+		}
+
+		// Clock in length bytes, keeping the transmit FIFO fed with dummy bytes so the bus never idles
+		[[gnu::always_inline]] static void readBytes(uint8_t *const data, const size_t length) noexcept
+		{
+			auto &ssi{device()};
+			size_t sent{};
+			for (size_t received{}; received < length;)
+			{
+				// Never have more than a FIFO's worth in flight so the receive FIFO can't overflow
+				if (sent < length && sent - received < fifoDepth)
+				{
+					ssi.data = 0;
+					++sent;
+				}
+				if (ssi.status & vals::ssi::statusRxFIFONotEmpty)
+					// NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+					data[received++] = uint8_t(ssi.data);
+			}
+		}
+
+		// As readBytes(), but two bytes per frame - the controller must be in 16-bit mode.
+		// Frames are sent MSB first, so the first byte on the wire is the high byte of each frame.
+		[[gnu::always_inline]] static void readWords(uint8_t *const data, const size_t words) noexcept
+		{
+			auto &ssi{device()};
+			size_t sent{};
+			for (size_t received{}; received < words;)
+			{
+				if (sent < words && sent - received < fifoDepth)
+				{
+					ssi.data = 0;
+					++sent;
+				}
+				if (ssi.status & vals::ssi::statusRxFIFONotEmpty)
+				{
+					const auto frame{ssi.data};
+					// NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+					data[received * 2U] = uint8_t(frame >> 8U);
+					data[(received * 2U) + 1U] = uint8_t(frame);
+					// NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+					++received;
+				}
+			}
+		}
+
+		// Clock out length bytes, discarding what comes back
+		[[gnu::always_inline]] static void writeBytes(const uint8_t *const data, const size_t length) noexcept
+		{
+			auto &ssi{device()};
+			size_t sent{};
+			for (size_t received{}; received < length;)
+			{
+				if (sent < length && sent - received < fifoDepth)
+					// NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+					ssi.data = data[sent++];
+				if (ssi.status & vals::ssi::statusRxFIFONotEmpty)
+				{
+					// NOLINTNEXTLINE(readability-identifier-length)
+					[[maybe_unused]] const volatile auto _{ssi.data};
+					++received;
+				}
+			}
+		}
+
+		// As writeBytes(), but two bytes per frame - the controller must be in 16-bit mode
+		[[gnu::always_inline]] static void writeWords(const uint8_t *const data, const size_t words) noexcept
+		{
+			auto &ssi{device()};
+			size_t sent{};
+			for (size_t received{}; received < words;)
+			{
+				if (sent < words && sent - received < fifoDepth)
+				{
+					// NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+					ssi.data = (uint32_t{data[sent * 2U]} << 8U) | data[(sent * 2U) + 1U];
+					++sent;
+				}
+				if (ssi.status & vals::ssi::statusRxFIFONotEmpty)
+				{
+					// NOLINTNEXTLINE(readability-identifier-length)
+					[[maybe_unused]] const volatile auto _{ssi.data};
+					++received;
+				}
+			}
+		}
+
+		// Read a block of data, using 16-bit frames for the bulk of it when it's long enough to be worthwhile
+		[[gnu::always_inline]] static void readBlock(uint8_t *const data, const size_t length) noexcept
+		{
+			const perf::cycleTimer_t timer{perf::counters.spiCycles};
+			resync();
+			size_t offset{};
+			if (length >= wideFrameThreshold)
+			{
+				offset = length & ~size_t{1U};
+				wideFrames(true);
+				readWords(data, offset / 2U);
+				wideFrames(false);
+			}
+			// Pick up any odd byte at the end (or the whole block if it's short) with 8-bit frames
+			// NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+			readBytes(data + offset, length - offset);
+		}
+
+		// Write a block of data, using 16-bit frames for the bulk of it when it's long enough to be worthwhile
+		[[gnu::always_inline]] static void writeBlock(const uint8_t *const data, const size_t length) noexcept
+		{
+			const perf::cycleTimer_t timer{perf::counters.spiCycles};
+			resync();
+			size_t offset{};
+			if (length >= wideFrameThreshold)
+			{
+				offset = length & ~size_t{1U};
+				wideFrames(true);
+				writeWords(data, offset / 2U);
+				wideFrames(false);
+			}
+			// NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+			writeBytes(data + offset, length - offset);
+		}
+	};
+
+	/*!
+	 * Runs the given function with the data path for the bus the chip is on, so the function gets
+	 * instantiated once per bus and the choice of bus is made once per transfer rather than per byte.
+	 */
+	template<typename function_t> inline void withBus(const spiChip_t chip, function_t &&function) noexcept
+	{
+		if (chip == spiChip_t::target)
+			function(spiBus_t<bus_t::external>{});
+		else if (chip == spiChip_t::local1 || chip == spiChip_t::local2)
+			function(spiBus_t<bus_t::internal>{});
+	}
+} // namespace spi
 
 namespace spiOpcodes
 {
@@ -35,14 +257,22 @@ namespace spiOpcodes
 	constexpr static uint8_t chipErase{0xC7U};
 	constexpr static uint8_t blockErase{0xD8U};
 	constexpr static uint8_t pageRead{0x03U};
+	constexpr static uint8_t fastRead{0x0BU};
+	constexpr static uint8_t pageRead4Byte{0x13U};
+	constexpr static uint8_t fastRead4Byte{0x0CU};
 	constexpr static uint8_t pageAddressRead{0x13U};
 	constexpr static uint8_t pageWrite{0x02U};
+	constexpr static uint8_t pageWrite4Byte{0x12U};
 	constexpr static uint8_t pageAddressWrite{0x10U};
 	constexpr static uint8_t statusRead{0x05U};
 	constexpr static uint8_t statusWrite{0x01U};
 	constexpr static uint8_t writeEnable{0x06U};
 	constexpr static uint8_t writeDisable{0x04U};
+	constexpr static uint8_t enter4ByteMode{0xB7U};
+	constexpr static uint8_t exit4ByteMode{0xE9U};
 	constexpr static uint8_t readSFDP{0x5AU};
+	constexpr static uint8_t readUniqueID{0x4BU};
+	constexpr static uint8_t readBBMTable{0xA5U};
 	constexpr static uint8_t wakeUp{0xABU};
 	constexpr static uint8_t reset{0xFFU};
 } // namespace spiOpcodes
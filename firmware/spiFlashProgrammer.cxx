@@ -4,6 +4,8 @@
 #include "led.hxx"
 #include "spi.hxx"
 #include "timer.hxx"
+#include "perf.hxx"
+#include "eventLog.hxx"
 #include <usb/core.hxx>
 #include <usb/drivers/dfu.hxx>
 #include "usb/flashProto.hxx"
@@ -15,6 +17,8 @@ void run() noexcept
 	ledInit();
 	oscInit();
 	timerInit();
+	perf::init();
+	eventLog::init();
 	spiInit();
 	usb::core::init();
 	usb::flashProto::registerHandlers(1, 1, 0, 1);
@@ -25,7 +29,11 @@ void run() noexcept
 		__asm__("wfi");
 }
 
-void irqUSB() noexcept { usb::core::handleIRQ(); }
+void irqUSB() noexcept
+{
+	const perf::cycleTimer_t timer{perf::counters.usbCycles};
+	usb::core::handleIRQ();
+}
 
 namespace usb::dfu
 {
@@ -12,6 +12,9 @@ extern const uint32_t stackTop;
 extern const uint32_t endText;
 extern uint32_t beginData;
 extern const uint32_t endData;
+extern uint32_t beginRAMFuncs;
+extern const uint32_t endRAMFuncs;
+extern const uint32_t loadRAMFuncs;
 extern uint32_t beginBSS;
 extern const uint32_t endBSS;
 
@@ -198,6 +201,9 @@ void irqReset() noexcept
 		auto *src{&endText};
 		for (auto *dst{&beginData}; dst < &endData; ++dst, ++src)
 			*dst = *src;
+		src = &loadRAMFuncs;
+		for (auto *dst{&beginRAMFuncs}; dst < &endRAMFuncs; ++dst, ++src)
+			*dst = *src;
 		for (auto *dst{&beginBSS}; dst < &endBSS; ++dst)
 			*dst = 0;
 		for (auto *ctor{&beginCtors}; ctor != &endCtors; ++ctor)
@@ -1,7 +1,10 @@
 // SPDX-License-Identifier: BSD-3-Clause
 #include <cstring>
 #include <cstdint>
+#include <limits>
 #include <array>
+#include <algorithm>
+#include <optional>
 #include <substrate/units>
 #include <substrate/indexed_iterator>
 #include <substrate/index_sequence>
@@ -10,10 +13,14 @@
 #include <usb/core.hxx>
 #include <usb/device.hxx>
 #include "usbProtocol.hxx"
+#include "compression.hxx"
+#include "crc32.hxx"
 #include "flashProto.hxx"
 #include "spi.hxx"
 #include "led.hxx"
 #include "timer.hxx"
+#include "perf.hxx"
+#include "eventLog.hxx"
 
 using namespace substrate;
 using namespace usb::constants;
@@ -28,22 +35,45 @@ namespace usb::flashProto
 	enum class readMode_t
 	{
 		data,
-		sfdp
+		sfdp,
+		compressed
 	};
 
 	// NOLINTBEGIN(cppcoreguidelines-avoid-non-const-global-variables)
 	static std::array<uint8_t, epBufferSize> response{};
-	static std::array<uint8_t, 4096> flashBuffer{};
+	// Aligned so blank checks can compare it a word at a time
+	alignas(uint32_t) static std::array<uint8_t, 4096> flashBuffer{};
 	static spiChip_t targetDevice{spiChip_t::none};
 	static flashID_t targetID{};
 	static flashChip_t targetParams{};
 
+	// What each chip was last identified as, so listing and targeting them doesn't re-probe them every time
+	struct identifiedChip_t
+	{
+		flashID_t id;
+		flashChip_t params;
+	};
+	static std::array<std::optional<flashChip_t>, spi::internalChips> internalChipParams{};
+	static std::optional<identifiedChip_t> externalChip{};
+
 	static readMode_t readMode{readMode_t::data};
 	static uint8_t readEndpoint{};
 	static page_t readPage{};
-	static uint16_t readCount{};
+	static uint32_t readAddress{};
+	static uint32_t readCount{};
+	static requests::readRange_t readRange{};
+
+	static requests::compressedRead_t compressedRead{};
+	// Each block of a compressed read is encoded into a frame here while the previous one is sent
+	alignas(uint32_t) static std::array<uint8_t, responses::compressedFrameBlock +
+		responses::compressedFrameAlignment> readFrame{};
+	static uint32_t readFrameLength{};
+	static uint32_t readFrameOffset{};
+	static compression::encoder_t<9U> readEncoder{};
 
 	static requests::erase_t eraseConfig{};
+	static requests::eraseRanges_t eraseRanges{};
+	static uint8_t eraseRange{};
 	static eraseOperation_t eraseOperation{eraseOperation_t::idle};
 	static bool eraseActive{false};
 
@@ -51,6 +81,15 @@ namespace usb::flashProto
 	static page_t writePage{};
 	static uint32_t writeCount{};
 	static uint32_t writeTotal{};
+	// How far into flashBuffer we've handed pages to the chip, and whether it's still programming the last
+	static uint32_t writeProgrammed{};
+	static bool writeProgramming{false};
+	// Compressed writes receive a packet of encoded data at a time here, and decode it into flashBuffer
+	static bool writeCompressed{false};
+	static requests::compressedWrite_t compressedWrite{};
+	static std::array<uint8_t, epBufferSize> writePacket{};
+	static uint32_t writePacketLength{};
+	static compression::decoder_t writeDecoder{};
 
 	static bool verifyWrite{};
 	static page_t verifyPage{};
@@ -58,6 +97,42 @@ namespace usb::flashProto
 	static uint32_t sfdpAddress{};
 
 	static responses::status_t status{};
+	static responses::events_t eventsChunk{};
+	static responses::benchmark_t benchmarkResult{};
+	// The external bus clock training result for the current targeting session
+	static responses::busClock_t busClock{};
+
+	static requests::fill_t fillConfig{};
+	static responses::fill_t fillStatus{};
+	static bool fillActive{false};
+	// Whether the chip is programming the last page of the fill, and where and how long that page is
+	static bool fillProgramming{false};
+	static uint32_t fillPageAddress{};
+	static uint32_t fillPageLength{};
+
+	static requests::blankCheck_t blankConfig{};
+	static responses::blankCheck_t blankResult{};
+	static bool blankActive{false};
+	// Blank checks scan forward to find the first used byte, then back down from the end to find the last
+	static bool blankBackward{false};
+	static uint32_t blankCursor{};
+
+	static responses::uniqueID_t uniqueID{};
+	static requests::checksum_t checksumConfig{};
+	static responses::checksum_t checksumResult{};
+	static bool checksumActive{false};
+	static checksum::crc32_t checksumCRC{};
+
+	// The most bad blocks of a NAND the programmer keeps track of
+	constexpr static size_t maxBadBlocks{64U};
+	// The bad blocks of the targeted NAND, kept in ascending order once the scan for them completes
+	static responses::badBlocks_t badBlockStatus{};
+	static std::array<uint16_t, maxBadBlocks> badBlockList{};
+	static responses::badBlocks_t badBlockChunk{};
+	static bool badBlockActive{false};
+	// Set when the scan finds more bad blocks than fit in badBlockList
+	static bool badBlockOverflow{false};
+	static uint16_t badBlockCursor{};
 	// NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables)
 
 	constexpr static std::array<spiChip_t, spi::internalChips> internalChipMap
@@ -83,11 +158,52 @@ namespace usb::flashProto
 		return sizeof(T);
 	}
 
-	static uint16_t fetchDeviceCount() noexcept
+	// Forget what the chips were identified as, as they may have been changed or reset since
+	static void forgetChips() noexcept
+	{
+		internalChipParams = {};
+		externalChip.reset();
+	}
+
+	[[nodiscard]] static const flashChip_t &identifyInternal(const uint8_t deviceNumber) noexcept
+	{
+		auto &chip{internalChipParams[deviceNumber]};
+		if (!chip)
+		{
+			chip.emplace(flash::findChip(spi::localChip[deviceNumber], internalChipMap[deviceNumber]));
+			// Looking the chip up may have reclocked the bus to read its SFDP data
+			if (targetDevice == spiChip_t::none)
+				spiResetClocks();
+		}
+		return *chip;
+	}
+
+	/*!
+	 * Identify the chip on the external bus, holding it in reset afterwards if asked to. The target is only
+	 * put through reset to probe the chip if we don't already know what it is, or to hold it for targeting.
+	 */
+	[[nodiscard]] static const identifiedChip_t &identifyExternal(const bool holdReset = false) noexcept
+	{
+		if (!externalChip)
+		{
+			const auto chipID{identDevice(spiChip_t::target, !holdReset)};
+			externalChip.emplace(identifiedChip_t{chipID, flash::findChip(chipID, spiChip_t::target)});
+			if (targetDevice == spiChip_t::none)
+				spiResetClocks();
+		}
+		else if (holdReset)
+			setDeviceReset(true);
+		return *externalChip;
+	}
+
+	static uint16_t fetchDeviceCount(const bool rescan) noexcept
 	{
+		// Re-scanning starts over identifying the chips, unless one is targeted and so can't have changed
+		if (rescan && targetDevice == spiChip_t::none)
+			forgetChips();
 		responses::deviceCount_t deviceCount{};
 		deviceCount.internalCount = 2;
-		const auto [mfr, type, capacity] = identDevice(spiChip_t::target);
+		const auto [mfr, type, capacity] = identifyExternal().id;
 		if (mfr || type || capacity)
 			deviceCount.externalCount = 1;
 		else
@@ -95,8 +211,9 @@ namespace usb::flashProto
 		return writeResponse(deviceCount);
 	}
 
-	[[nodiscard]] constexpr size_t power2(const size_t power) noexcept
-		{ return power ? power2(power - 1) * 2 : 1; }
+	// Turn a log2 chip capacity into bytes, saturating for chips bigger than a 32-bit byte address can reach
+	[[nodiscard]] constexpr uint32_t capacityBytes(const uint8_t capacity) noexcept
+		{ return capacity >= 32U ? UINT32_MAX : uint32_t(1U) << capacity; }
 
 	static uint16_t fetchDeviceListing(const setupPacket::address_t address)
 	{
@@ -108,12 +225,12 @@ namespace usb::flashProto
 
 		if (deviceType == flashBus_t::internal)
 		{
-			if (deviceNumber <= spi::internalChips)
+			if (deviceNumber < spi::internalChips)
 			{
-				const auto chip{flash::findChip(spi::localChip[deviceNumber], internalChipMap[deviceNumber])};
+				const auto &chip{identifyInternal(deviceNumber)};
 				device.manufacturer = spi::localChip[deviceNumber].manufacturer;
 				device.deviceType = chip.type;
-				device.deviceSize = power2(chip.actualCapacity);
+				device.deviceSize = capacityBytes(chip.actualCapacity);
 				device.eraseSize = chip.erasePageSize;
 				device.pageSize = chip.flashPageSize;
 			}
@@ -122,20 +239,44 @@ namespace usb::flashProto
 		{
 			if (deviceNumber == 0)
 			{
-				const auto chipID{identDevice(spiChip_t::target)};
-				const auto chip{flash::findChip(chipID, spiChip_t::target)};
+				const auto &[chipID, chip] = identifyExternal();
 				device.manufacturer = chipID.manufacturer;
 				device.deviceType = chip.type;
-				device.deviceSize = power2(chip.actualCapacity);
+				device.deviceSize = capacityBytes(chip.actualCapacity);
 				device.eraseSize = chip.erasePageSize;
 				device.pageSize = chip.flashPageSize;
 			}
 		}
-		spiResetClocks();
 		return writeResponse(device);
 	}
 
-	static void prepareW25N01GVxxIx() noexcept
+	// Select between the W25N's continuous read (BUF=0) and buffer read (BUF=1) modes
+	static void setW25NReadMode(const bool continuousRead) noexcept
+	{
+		auto &device{*spiDevice(targetDevice)};
+		// Read the second status register
+		// SR address Bx maps to SR2 (aka the configuration register)
+		// documented in §7.2, pg17 of the datasheet.
+		spiSelect(targetDevice);
+		spiWrite(device, spiOpcodes::statusRead);
+		spiWrite(device, 0xB0U);
+		// Read the current configuration back
+		const auto cfgReg{spiRead(device)};
+		spiSelect(spiChip_t::none);
+		// Work out the buffer bit for the read mode we want - low for continuous read, high for buffer read
+		const auto wantedCfgReg{static_cast<uint8_t>(continuousRead ? cfgReg & ~0x08U : cfgReg | 0x08U)};
+		if (cfgReg != wantedCfgReg)
+		{
+			spiSelect(targetDevice);
+			// Reprogram the buffer bit to select the read mode
+			spiWrite(device, spiOpcodes::statusWrite);
+			spiWrite(device, 0xB0U);
+			spiWrite(device, wantedCfgReg);
+			spiSelect(spiChip_t::none);
+		}
+	}
+
+	static void prepareW25N01GVxxIx(const bool continuousRead) noexcept
 	{
 		auto &device{*spiDevice(targetDevice)};
 
@@ -162,26 +303,67 @@ namespace usb::flashProto
 			spiWrite(device, 0x00U);
 			spiSelect(spiChip_t::none);
 		}
-		// Now we're in a state where there shouldn't be any protections enabled,
-		// Select the device again and read the second status register
-		// SR address Bx maps to SR2 (aka the configuration register)
-		// documented in §7.2, pg17 of the datasheet.
+		// Now we're in a state where there shouldn't be any protections enabled, pick the read mode
+		setW25NReadMode(continuousRead);
+	}
+
+	/*!
+	 * Chips only reachable in full by switching them into 4-byte addressing are switched while they're targeted,
+	 * and switched back when released so whatever boots from them finds them addressed as it expects
+	 */
+	static void setFourByteMode(const bool enable) noexcept
+	{
+		if (targetDevice == spiChip_t::none || targetParams.addressing != flashAddressing_t::fourByteMode)
+			return;
+		auto &device{*spiDevice(targetDevice)};
+		// Some chips only accept the mode switch with writes enabled, so enable them around it
 		spiSelect(targetDevice);
-		spiWrite(device, spiOpcodes::statusRead);
-		spiWrite(device, 0xB0U);
-		// Read the current configuration back
-		const auto cfgReg{spiRead(device)};
+		spiWrite(device, spiOpcodes::writeEnable);
 		spiSelect(spiChip_t::none);
-		// If the buffer bit is low
-		if (!(cfgReg & 0x08U))
-		{
-			spiSelect(targetDevice);
-			// Reprogram the bit high to select buffer read rather than continous read
-			spiWrite(device, spiOpcodes::statusWrite);
-			spiWrite(device, 0xB0U);
-			spiWrite(device, cfgReg | 0x08U);
-			spiSelect(spiChip_t::none);
-		}
+
+		spiSelect(targetDevice);
+		spiWrite(device, enable ? spiOpcodes::enter4ByteMode : spiOpcodes::exit4ByteMode);
+		spiSelect(spiChip_t::none);
+
+		spiSelect(targetDevice);
+		spiWrite(device, spiOpcodes::writeDisable);
+		spiSelect(spiChip_t::none);
+	}
+
+	// How long fills and blank checks may run for in each SOF tick, in microseconds
+	constexpr static uint32_t tickBudget{750U};
+	// How much of the chip a blank check reads at a time, and the size of the words it compares them by
+	constexpr static uint32_t blankChunkSize{512U};
+	constexpr static uint32_t blankWordSize{sizeof(uint32_t)};
+
+	// Chips we know nothing about get trained no faster than this
+	constexpr static uint8_t unknownChipMHz{20U};
+	// Chips are rated in whole MHz, commonly 104MHz for fast reads, and that has to survive being reported in kHz
+	using clockKHz_t = decltype(responses::busClock_t::ratedKHz);
+	static_assert(clockKHz_t{104U * 1000U} == 104'000U);
+	static_assert(std::numeric_limits<clockKHz_t>::max() >= UINT8_MAX * 1000U);
+
+	static void trainTargetClock() noexcept
+	{
+		const auto ratedMHz{targetParams.maxClockMHz() ? targetParams.maxClockMHz() : unknownChipMHz};
+		const auto training{spiTrainClock(targetDevice, ratedMHz)};
+		busClock = {};
+		busClock.ratedKHz = ratedMHz * 1000U;
+		busClock.fastestKHz = spi::dividerToKHz(training.fastestDivider);
+		busClock.trainedKHz = spi::dividerToKHz(training.divider);
+		busClock.currentKHz = busClock.trainedKHz;
+	}
+
+	// Override the trained clock, never going faster than asked. 0 returns to the trained clock.
+	static bool handleBusClock(const uint16_t valueKHz) noexcept
+	{
+		if (targetDevice != spiChip_t::target)
+			return false;
+		const auto divider{valueKHz ? spi::kHzToDivider(valueKHz) : spi::kHzToDivider(busClock.trainedKHz)};
+		spiSetClockDivider(targetDevice, divider);
+		busClock.currentKHz = spi::dividerToKHz(divider);
+		busClock.overridden = valueKHz ? 1U : 0U;
+		return true;
 	}
 
 	static bool handleTargetDevice(const setupPacket::address_t address) noexcept
@@ -190,27 +372,29 @@ namespace usb::flashProto
 			return false;
 		const auto deviceType{static_cast<flashBus_t>(address.addrH)};
 		const auto deviceNumber{address.addrL};
+		// Refuse a chip that doesn't exist before touching the current session, so a bad request leaves it be
+		if ((deviceType == flashBus_t::internal && deviceNumber >= internalChipMap.size()) ||
+			(deviceType == flashBus_t::external && deviceNumber != 0))
+			return false;
+		// The chip currently targeted is being let go of, along with what's known of it
+		setFourByteMode(false);
+		badBlockActive = false;
+		badBlockStatus = {};
 
 		if (deviceType == flashBus_t::internal)
 		{
-			if (deviceNumber >= internalChipMap.size())
-				return false;
 			targetDevice = internalChipMap[deviceNumber];
 			targetID = spi::localChip[deviceNumber];
 		}
 		else if (deviceType == flashBus_t::external)
 		{
-			if (deviceNumber == 0)
-			{
-				targetDevice = spiChip_t::target;
-				targetID = identDevice(spiChip_t::target, false);
+			targetDevice = spiChip_t::target;
+			const auto &chip{identifyExternal(true)};
+			targetID = chip.id;
 
-				// Exception for the dimbos at Winbond.. *grumbles*
-				if (targetID.manufacturer == 0xEFU && targetID.type == 0xAAU)
-					prepareW25N01GVxxIx();
-			}
-			else
-				return false;
+			// Exception for the dimbos at Winbond.. *grumbles*
+			if (targetID.manufacturer == 0xEFU && targetID.type == 0xAAU)
+				prepareW25N01GVxxIx(chip.params.streamsPages());
 		}
 		else // if (deviceType == flashBus_t::unknown)
 		{
@@ -231,18 +415,32 @@ namespace usb::flashProto
 					spiSelect(spiChip_t::none);
 				}
 				setDeviceReset(false);
+				// The target is running again, and may do anything to the chip
+				externalChip.reset();
 			}
 			targetDevice = spiChip_t::none;
 			targetID = {};
+			busClock = {};
 			spiResetClocks();
 		}
 		if (deviceType != flashBus_t::unknown)
-			targetParams = flash::findChip(targetID, targetDevice);
+		{
+			targetParams = deviceType == flashBus_t::internal ?
+				identifyInternal(deviceNumber) : externalChip->params;
+			// Clock the bus for the fastest read mode the chip allows, training the external bus for it
+			if (targetDevice == spiChip_t::target)
+				trainTargetClock();
+			else
+				spiSetClock(targetDevice, targetParams.maxClockMHz());
+			setFourByteMode(true);
+		}
 		return true;
 	}
 
 	static bool isBusy() noexcept
 	{
+		const perf::cycleTimer_t timer{perf::counters.busyCycles};
+		++perf::counters.busyPolls;
 		auto &device{*spiDevice(targetDevice)};
 		spiSelect(targetDevice);
 		spiWrite(device, spiOpcodes::statusRead);
@@ -254,6 +452,23 @@ namespace usb::flashProto
 		return (status & 1);
 	}
 
+	static void waitNotBusy() noexcept
+	{
+		eventLog::record(eventType_t::busyBegin);
+		uint16_t polls{};
+		while (isBusy())
+		{
+			if (polls != UINT16_MAX)
+				++polls;
+		}
+		eventLog::record(eventType_t::busyEnd, 0U, polls);
+	}
+
+	// Whether one of the operations tick() works through in the background is under way. Anything else
+	// that wants to talk to the target has to wait for it to finish, or the two would trip over each other.
+	static bool backgroundBusy() noexcept
+		{ return eraseActive || fillActive || blankActive || checksumActive || badBlockActive; }
+
 	static void handleErase() noexcept
 	{
 		status.eraseComplete = 0;
@@ -276,11 +491,28 @@ namespace usb::flashProto
 				[[fallthrough]];
 			case eraseOperation_t::pageRange:
 				status.erasePage = eraseConfig.beginPage;
+				status.eraseRange = 0;
+				eraseActive = true;
+				break;
+			case eraseOperation_t::pageRanges:
+				if (!eraseRanges.count || eraseRanges.count > requests::maxEraseRanges)
+				{
+					ledSetColour(true, false, false);
+					status.eraseComplete = 3;
+					eventLog::record(eventType_t::error, static_cast<uint8_t>(messages_t::erase), eraseRanges.count);
+					break;
+				}
+				// The ranges are worked through one after the other by tick()
+				eraseRange = 0;
+				eraseConfig = eraseRanges.ranges[0];
+				status.erasePage = eraseConfig.beginPage;
+				status.eraseRange = 0;
 				eraseActive = true;
 				break;
 			default:
 				ledSetColour(true, false, false);
 				status.eraseComplete = 3;
+				eventLog::record(eventType_t::error, static_cast<uint8_t>(messages_t::erase));
 		}
 	}
 
@@ -288,16 +520,26 @@ namespace usb::flashProto
 	{
 		if (opcode >= static_cast<uint8_t>(eraseOperation_t::idle))
 			return false;
-		else if (targetDevice == spiChip_t::none)
+		else if (targetDevice == spiChip_t::none || backgroundBusy())
 		{
 			eraseOperation = eraseOperation_t::idle;
 			status.eraseComplete = 2;
+			eventLog::record(eventType_t::error, static_cast<uint8_t>(messages_t::erase));
 			return false;
 		}
+		eventLog::record(eventType_t::eraseSetup, opcode);
 		auto &epStatus{epStatusControllerOut[0]};
 		eraseOperation = static_cast<eraseOperation_t>(opcode);
-		epStatus.memBuffer = &eraseConfig;
-		epStatus.transferCount = sizeof(eraseConfig);
+		if (eraseOperation == eraseOperation_t::pageRanges)
+		{
+			epStatus.memBuffer = &eraseRanges;
+			epStatus.transferCount = sizeof(eraseRanges);
+		}
+		else
+		{
+			epStatus.memBuffer = &eraseConfig;
+			epStatus.transferCount = sizeof(eraseConfig);
+		}
 		epStatus.needsArming(true);
 		setupCallback = handleErase;
 		return true;
@@ -310,12 +552,39 @@ namespace usb::flashProto
 			eraseOperation = eraseOperation_t::idle;
 	}
 
-	static void beginPageRead(const page_t &page) noexcept
+	/*!
+	 * NAND devices are page addressed, and have to be re-addressed at every page boundary
+	 * unless they stream reads on across their pages
+	 */
+	static bool isPageAddressed() noexcept
+		{ return targetParams.isPageAddressed(); }
+
+	// Send a byte address to the target in as many bytes as it's addressed with
+	static void writeByteAddress(tivaC::ssi_t &device, const uint32_t address) noexcept
+	{
+		if (targetParams.fourByteAddresses())
+			spiWrite(device, uint8_t(address >> 24U));
+		spiWrite(device, uint8_t(address >> 16U));
+		spiWrite(device, uint8_t(address >> 8U));
+		spiWrite(device, uint8_t(address));
+	}
+
+	// Pick the form of an instruction that goes with how the target is addressed
+	static uint8_t addressedOpcode(const uint8_t threeByteOpcode, const uint8_t fourByteOpcode) noexcept
+	{
+		return targetParams.addressing == flashAddressing_t::fourByteInstructions ?
+			fourByteOpcode : threeByteOpcode;
+	}
+
+	static void beginRead(const uint32_t address) noexcept
 	{
 		auto &device{*spiDevice(targetDevice)};
-		// If the device is bigger than 2^24 bytes, it's addressed differently.
-		if (targetParams.actualCapacity > 0x18U)
+		if (isPageAddressed())
 		{
+			// NOLINTNEXTLINE(cppcoreguidelines-init-variables)
+			const uint32_t page{address / targetParams.flashPageSize};
+			// NOLINTNEXTLINE(cppcoreguidelines-init-variables)
+			const uint32_t column{address & (targetParams.flashPageSize - 1U)};
 			spiSelect(targetDevice);
 			spiWrite(device, spiOpcodes::pageAddressRead);
 			spiWrite(device, uint8_t(page >> 16U));
@@ -323,59 +592,106 @@ namespace usb::flashProto
 			spiWrite(device, uint8_t(page));
 			spiSelect(spiChip_t::none);
 
-			while (isBusy())
-				continue;
+			waitNotBusy();
 
 			spiSelect(targetDevice);
 			spiWrite(device, spiOpcodes::pageRead);
-			// Write a dummy "column address" (byte address within the page)
-			spiWrite(device, 0);
-			spiWrite(device, 0);
-			spiWrite(device, 0);
+			if (targetParams.streamsPages())
+			{
+				/*
+				 * In continuous read mode the column address is replaced by 3 dummy bytes, and the data starts
+				 * from the beginning of the page, so skip over the part of it before the address wanted. From
+				 * here on the chip loads each next page into its buffer while the current one is read out.
+				 */
+				spiWrite(device, 0);
+				spiWrite(device, 0);
+				spiWrite(device, 0);
+				for (uint32_t offset{}; offset < column; ++offset)
+					static_cast<void>(spiRead(device));
+			}
+			else
+			{
+				// Write the "column address" (byte address within the page) and a dummy byte
+				spiWrite(device, uint8_t(column >> 8U));
+				spiWrite(device, uint8_t(column));
+				spiWrite(device, 0);
+			}
 		}
 		else
 		{
-			// NOLINTNEXTLINE(cppcoreguidelines-init-variables)
-			const uint32_t pageAddress{page * targetParams.flashPageSize};
 			spiSelect(targetDevice);
-			spiWrite(device, spiOpcodes::pageRead);
-			// Translate the page number into a byte address
-			spiWrite(device, uint8_t(pageAddress >> 16U));
-			spiWrite(device, uint8_t(pageAddress >> 8U));
-			spiWrite(device, uint8_t(pageAddress));
+			// Use fast read where we can as it runs at the chip's full clock rate
+			const auto fastRead{targetParams.supportsFastRead()};
+			spiWrite(device, fastRead ? addressedOpcode(spiOpcodes::fastRead, spiOpcodes::fastRead4Byte) :
+				addressedOpcode(spiOpcodes::pageRead, spiOpcodes::pageRead4Byte));
+			writeByteAddress(device, address);
+			// Fast read needs 8 wait clocks before the data starts
+			if (fastRead)
+				spiWrite(device, 0);
+		}
+	}
+
+	static void beginPageRead(const page_t &page) noexcept
+		// Translate the page number into a byte address
+		{ beginRead(page * targetParams.flashPageSize); }
+
+	// Carry on the read started by beginRead(), reading the next length bytes of the readCount left into data
+	RAMFUNC static void readTarget(uint8_t *const data, const size_t length)
+	{
+		for (size_t offset{}; offset < length;)
+		{
+			// Read up to the next Flash page boundary, or the end of this packet, whichever is first
+			const uint32_t pageSize{targetParams.flashPageSize};
+			const auto chunk{std::min<size_t>(length - offset, pageSize - (readAddress & (pageSize - 1U)))};
+			spi::withBus(targetDevice, [&](const auto bus)
+				// NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+				{ bus.readBlock(data + offset, chunk); });
+			offset += chunk;
+			readAddress += static_cast<uint32_t>(chunk);
+			// If the device is page addressed and there's more to read, we have to entirely re-address it
+			if (isPageAddressed() && !targetParams.streamsPages() &&
+				(readAddress & (pageSize - 1U)) == 0 && readCount > offset)
+			{
+				spiSelect(spiChip_t::none);
+				beginRead(readAddress);
+			}
 		}
 	}
 
-	static void performRead(const uint8_t endpoint)
+	RAMFUNC static void performRead(const uint8_t endpoint)
 	{
 		// If we've run out of work to do, return early.
 		if (readCount == 0)
 			return;
-		// Grab the USB stack IN endpoint control structure and SPI device to use
+		// Grab the USB stack IN endpoint control structure to use
 		auto &epStatus{epStatusControllerIn[endpoint]};
-		auto &device{*spiDevice()};
-		// For each byte in the response buffer, read a byte from Flash and store it
-		for (auto &byte : response)
-			byte = spiRead(device);
+		// Fill as much of the response buffer as we have bytes left to read
+		const auto amount{static_cast<uint16_t>(std::min<uint32_t>(response.size(), readCount))};
+		readTarget(response.data(), amount);
 		// Reset the transfer buffer pointer and amount
 		epStatus.memBuffer = response.data();
-		epStatus.transferCount = response.size();
+		epStatus.transferCount = amount;
 		// Transfer the data to the USB controller and tell it that we're ready for it to transmit
 		writeEP(endpoint);
 		// Update our read counters and perform any cleanup that might be necessary
-		readCount -= static_cast<uint16_t>(response.size());
+		readCount -= amount;
+		perf::counters.bytesRead += amount;
 		if (readCount == 0)
 		{
 			spiSelect(spiChip_t::none);
 			ledSetColour(false, true, false);
+			eventLog::record(eventType_t::readComplete);
 		}
-		else if (targetID.manufacturer == 0xEFU && targetID.type == 0xAAU &&
-			(readCount & (targetParams.flashPageSize - 1)) == 0)
-		{
-			// We're on a special winbond device where we have to entirely re-address the device every complete page
-			spiSelect(spiChip_t::none);
-			beginPageRead(++readPage);
-		}
+	}
+
+	// Page addressed devices don't describe their size by byte address, so don't limit ranges on them
+	static uint32_t targetCapacity() noexcept
+		{ return isPageAddressed() ? UINT32_MAX : capacityBytes(targetParams.actualCapacity); }
+
+	static bool validRange(const uint32_t address, const uint32_t length) noexcept
+	{
+		const auto capacity{targetCapacity()};
+		return length && address < capacity && length <= capacity - address;
 	}
 
 	static void handleRead() noexcept
@@ -384,25 +700,33 @@ namespace usb::flashProto
 		if (targetDevice == spiChip_t::none)
 		{
 			// TODO: Handle.. - use the status area to indicate we were asked to do something silly
+			eventLog::record(eventType_t::error, static_cast<uint8_t>(messages_t::read));
 			return;
 		}
 
+		eventLog::record(eventType_t::readBegin, static_cast<uint8_t>(messages_t::read), uint16_t(readPage));
 		// Set up the SPI Flash read sequence and send the host the first buffer of data
 		readMode = readMode_t::data;
-		beginPageRead(readPage);
+		readAddress = readPage * targetParams.flashPageSize;
+		beginRead(readAddress);
 		performRead(readEndpoint);
 	}
 
 	static bool setupRead(const uint16_t count) noexcept
 	{
-		// Our first step on recieving a read request is to validate it's not over-large
-		if (count > flashBuffer.size())
+		// Our first step on recieving a read request is to validate it's not over-large, and that nothing running
+		// in the background (such as a bad block scan, which changes how the chip reads) is using the chip
+		if (count > flashBuffer.size() || backgroundBusy())
+		{
+			eventLog::record(eventType_t::error, static_cast<uint8_t>(messages_t::read), count);
 			return false;
+		}
 		// Remap a count of 0 to the default read size of 256 bytes.
 		if (!count)
 			readCount = 256U;
 		else
 			readCount = count;
+		eventLog::record(eventType_t::readSetup, static_cast<uint8_t>(messages_t::read), uint16_t(readCount));
 		// We then have to set up to read from the USB host the Flash page they want us to read
 		auto &epStatus{epStatusControllerOut[0]};
 		epStatus.memBuffer = &readPage;
@@ -414,7 +738,150 @@ namespace usb::flashProto
 		return true;
 	}
 
-	static void writeAddress()
+	static void handleReadRange() noexcept
+	{
+		// Now we know the byte range the USB host wants us to read, validate it. If we can't read it, nothing
+		// gets streamed back, so tell the host through the status area rather than leaving it waiting for data
+		if (targetDevice == spiChip_t::none || !validRange(readRange.address, readRange.length))
+		{
+			status.readOK = false;
+			ledSetColour(true, false, false);
+			eventLog::record(eventType_t::error, static_cast<uint8_t>(messages_t::readRange));
+			return;
+		}
+		status.readOK = true;
+		eventLog::record(eventType_t::readBegin, static_cast<uint8_t>(messages_t::readRange),
+			uint16_t(readRange.address / targetParams.flashPageSize));
+
+		// Set up the SPI Flash read sequence and start streaming the data to the host.
+		// performRead() will then keep the IN endpoint fed until the whole range has been sent.
+		readMode = readMode_t::data;
+		readAddress = readRange.address;
+		readCount = readRange.length;
+		beginRead(readAddress);
+		performRead(readEndpoint);
+	}
+
+	static bool setupReadRange() noexcept
+	{
+		if (backgroundBusy())
+		{
+			eventLog::record(eventType_t::error, static_cast<uint8_t>(messages_t::readRange));
+			return false;
+		}
+		eventLog::record(eventType_t::readSetup, static_cast<uint8_t>(messages_t::readRange));
+		status.readOK = false;
+		// Set up to read from the USB host the byte range they want us to read
+		auto &epStatus{epStatusControllerOut[0]};
+		epStatus.memBuffer = &readRange;
+		epStatus.transferCount = sizeof(readRange);
+		epStatus.needsArming(true);
+		// Once we have that information, we then dispatch to handleReadRange()
+		setupCallback = handleReadRange;
+		ledSetColour(false, false, false);
+		return true;
+	}
+
+	// Read the next block of a compressed read from the target and encode it into a frame in readFrame
+	static void nextReadFrame() noexcept
+	{
+		const auto length{std::min(readCount, responses::compressedFrameBlock)};
+		readTarget(flashBuffer.data(), length);
+		readCount -= length;
+		if (readCount == 0)
+			spiSelect(spiChip_t::none);
+
+		// If the block doesn't compress, send it as-is
+		auto *const payload{readFrame.data() + sizeof(responses::compressedFrame_t)};
+		auto encodedLength{readEncoder.encode(flashBuffer.data(), length, payload, length - 1U)};
+		if (!encodedLength)
+		{
+			std::memcpy(payload, flashBuffer.data(), length);
+			encodedLength = length;
+		}
+		const responses::compressedFrame_t header{uint16_t(encodedLength), uint16_t(length)};
+		std::memcpy(readFrame.data(), &header, sizeof(header));
+
+		// Pad the frame out to a whole number of packets so the host can always read whole packets
+		const auto frameLength{sizeof(header) + encodedLength};
+		const auto alignment{responses::compressedFrameAlignment};
+		readFrameLength = static_cast<uint32_t>((frameLength + alignment - 1U) / alignment) * alignment;
+		std::fill(readFrame.begin() + static_cast<ptrdiff_t>(frameLength),
+			readFrame.begin() + readFrameLength, uint8_t{});
+		readFrameOffset = 0;
+		perf::counters.bytesRead += length;
+		perf::counters.compressedBytesRead += length;
+	}
+
+	RAMFUNC static void performCompressedRead(const uint8_t endpoint)
+	{
+		if (readFrameOffset == readFrameLength)
+		{
+			// If we've run out of work to do, return early.
+			if (readCount == 0)
+				return;
+			nextReadFrame();
+		}
+		auto &epStatus{epStatusControllerIn[endpoint]};
+		const auto amount{static_cast<uint16_t>(std::min<uint32_t>(readFrameLength - readFrameOffset, epBufferSize))};
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+		epStatus.memBuffer = readFrame.data() + readFrameOffset;
+		epStatus.transferCount = amount;
+		writeEP(endpoint);
+		readFrameOffset += amount;
+		perf::counters.compressedWireRead += amount;
+		if (readCount == 0 && readFrameOffset == readFrameLength)
+		{
+			ledSetColour(false, true, false);
+			eventLog::record(eventType_t::readComplete);
+		}
+	}
+
+	static void handleCompressedRead() noexcept
+	{
+		// As with handleReadRange(), tell the host through the status area if no frames are going to follow
+		if (targetDevice == spiChip_t::none || !validRange(compressedRead.address, compressedRead.length))
+		{
+			status.readOK = false;
+			ledSetColour(true, false, false);
+			eventLog::record(eventType_t::error, static_cast<uint8_t>(messages_t::compressedRead));
+			return;
+		}
+		status.readOK = true;
+		eventLog::record(eventType_t::readBegin, static_cast<uint8_t>(messages_t::compressedRead),
+			uint16_t(compressedRead.address / targetParams.flashPageSize));
+
+		// Set up the SPI Flash read sequence and start streaming frames to the host.
+		// performCompressedRead() will then keep the IN endpoint fed until the whole range has been sent.
+		readMode = readMode_t::compressed;
+		readAddress = compressedRead.address;
+		readCount = compressedRead.length;
+		readFrameLength = 0;
+		readFrameOffset = 0;
+		beginRead(readAddress);
+		performCompressedRead(readEndpoint);
+	}
+
+	static bool setupCompressedRead() noexcept
+	{
+		if (backgroundBusy())
+		{
+			eventLog::record(eventType_t::error, static_cast<uint8_t>(messages_t::compressedRead));
+			return false;
+		}
+		eventLog::record(eventType_t::readSetup, static_cast<uint8_t>(messages_t::compressedRead));
+		status.readOK = false;
+		auto &epStatus{epStatusControllerOut[0]};
+		epStatus.memBuffer = &compressedRead;
+		epStatus.transferCount = sizeof(compressedRead);
+		epStatus.needsArming(true);
+		setupCallback = handleCompressedRead;
+		ledSetColour(false, false, false);
+		return true;
+	}
+
+	// Start a page program at the given byte address, leaving the device selected for the data to follow
+	static void writeAddress(const uint32_t address)
 	{
 		auto &device{*spiDevice(targetDevice)};
 		// Enable writes to the device (must be done for every page, so..)
@@ -422,78 +889,166 @@ namespace usb::flashProto
 		spiWrite(device, spiOpcodes::writeEnable);
 		spiSelect(spiChip_t::none);
 
-		// If the device is bigger than 2^24 bytes, it's addressed differently.
-		if (targetParams.actualCapacity > 0x18U)
+		spiSelect(targetDevice);
+		spiWrite(device, addressedOpcode(spiOpcodes::pageWrite, spiOpcodes::pageWrite4Byte));
+		// Page addressed devices are loaded by column, and committed to a page afterwards
+		if (isPageAddressed())
 		{
-			spiSelect(targetDevice);
-			spiWrite(device, spiOpcodes::pageWrite);
-			// Write a dummy "column address" (byte address within the page)
-			spiWrite(device, 0);
-			spiWrite(device, 0);
+			// Write the "column address" (byte address within the page)
+			const uint32_t column{address & (targetParams.flashPageSize - 1U)};
+			spiWrite(device, uint8_t(column >> 8U));
+			spiWrite(device, uint8_t(column));
 		}
 		else
-		{
-			// NOLINTNEXTLINE(cppcoreguidelines-init-variables)
-			const uint32_t writeAddress{writePage * targetParams.flashPageSize};
+			writeByteAddress(device, address);
+	}
+
+	static void writeAddress()
+	{
+		// Translate the page number into a byte address
+		writeAddress(writePage * targetParams.flashPageSize);
+		if (!isPageAddressed())
 			++writePage;
-			spiSelect(targetDevice);
-			spiWrite(device, spiOpcodes::pageWrite);
-			// Translate the page number into a byte address
-			spiWrite(device, uint8_t(writeAddress >> 16U));
-			spiWrite(device, uint8_t(writeAddress >> 8U));
-			spiWrite(device, uint8_t(writeAddress));
-		}
 	}
 
-	static void writePageAddress()
+	// Commit the data loaded for a page addressed device into the given page
+	static void writePageAddress(const uint32_t page)
 	{
 		auto &device{*spiDevice(targetDevice)};
 		spiSelect(targetDevice);
 		spiWrite(device, spiOpcodes::pageAddressWrite);
-		spiWrite(device, uint8_t(writePage >> 16U));
-		spiWrite(device, uint8_t(writePage >> 8U));
-		spiWrite(device, uint8_t(writePage));
+		spiWrite(device, uint8_t(page >> 16U));
+		spiWrite(device, uint8_t(page >> 8U));
+		spiWrite(device, uint8_t(page));
 		spiSelect(spiChip_t::none);
+	}
+
+	static void writePageAddress()
+	{
+		writePageAddress(writePage);
 		++writePage;
 	}
 
-	static void performWrite(const uint8_t endpoint)
+	// Send the page held in the given slot of flashBuffer to the chip and start it programming
+	RAMFUNC static void programPage(const uint32_t offset, const uint32_t length)
+	{
+		writeAddress();
+		spi::withBus(targetDevice, [&](const auto bus)
+			// NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+			{ bus.writeBlock(flashBuffer.data() + offset, length); });
+		spiSelect(spiChip_t::none);
+		if (isPageAddressed())
+			writePageAddress();
+		++perf::counters.pagesProgrammed;
+		writeProgramming = true;
+	}
+
+	// Check if the page being programmed is done, waiting for it if asked to
+	static bool pageProgrammed(const bool wait) noexcept
+	{
+		if (!writeProgramming)
+			return true;
+		if (wait)
+			waitNotBusy();
+		else if (isBusy())
+			return false;
+		writeProgramming = false;
+		eventLog::record(eventType_t::pageProgrammed, 0U, uint16_t(writePage - 1U));
+		return true;
+	}
+
+	/*!
+	 * flashBuffer is treated as a set of page sized slots, filled by USB and drained by programming the chip.
+	 * Hand each full slot (or the final partial one) to the chip as soon as it's done with the previous page,
+	 * so the next page can be received while the chip programs. Unless told to wait, this never blocks
+	 * on the chip - receiving more data from USB carries on while it's busy.
+	 */
+	static void programReadyPages(const uint32_t received, const bool wait) noexcept
+	{
+		const uint32_t pageSize{targetParams.flashPageSize};
+		while (writeProgrammed < received)
+		{
+			const auto pageEnd{std::min(writeProgrammed + pageSize, writeTotal)};
+			if (received < pageEnd || !pageProgrammed(wait))
+				break;
+			programPage(writeProgrammed, pageEnd - writeProgrammed);
+			writeProgrammed = pageEnd;
+		}
+		if (wait)
+			static_cast<void>(pageProgrammed(true));
+	}
+
+	/*!
+	 * Decode the packet of compressed data just received into flashBuffer, re-arming the endpoint for the
+	 * next packet. Returns how much of the block has now been decoded, which programReadyPages() then
+	 * treats exactly as it does the data received by an uncompressed write.
+	 */
+	static uint32_t decodeWritePacket(const uint8_t endpoint) noexcept
 	{
-		auto &device{*spiDevice()};
+		auto &epStatus{epStatusControllerOut[endpoint]};
+		const auto received{writePacketLength - epStatus.transferCount};
+		writeCount -= received;
+		perf::counters.compressedWireWritten += received;
+		const auto before{static_cast<uint32_t>(writeDecoder.produced())};
+		if (!writeDecoder.feed(writePacket.data(), received))
+		{
+			status.writeOK = false;
+			eventLog::record(eventType_t::error, static_cast<uint8_t>(messages_t::compressedWrite));
+		}
+		const auto end{static_cast<uint32_t>(writeDecoder.produced())};
+		perf::counters.bytesWritten += end - before;
+		perf::counters.compressedBytesWritten += end - before;
+
+		if (writeCount)
+		{
+			writePacketLength = std::min<uint32_t>(writeCount, writePacket.size());
+			epStatus.memBuffer = writePacket.data();
+			epStatus.transferCount = static_cast<uint16_t>(writePacketLength);
+		}
+		// If the data didn't decode to exactly the block promised, don't program a partial block as if it were good
+		else if (end != writeTotal || !writeDecoder.complete())
+			status.writeOK = false;
+		return end;
+	}
+
+	RAMFUNC static void performWrite(const uint8_t endpoint)
+	{
+		auto &device{*spiDevice(targetDevice)};
 		if (writeCount == 0)
 			return;
 		readEP(endpoint);
-		auto &epStatus{epStatusControllerOut[endpoint]};
-		// Compute where we are in the buffer
-		const auto begin{writeTotal - writeCount};
-		const auto end{writeTotal - epStatus.transferCount};
-		// For each new byte in the write buffer, write the byte to Flash
-		for (const auto idx : substrate::indexSequence_t{begin, end})
-			spiWrite(device, flashBuffer[idx]);
-		// Decrease the number of bytes left to write by the amount written
-		writeCount -= end - begin;
-		// If we finished writing a page or we finished recieving data
-		if ((end & (targetParams.flashPageSize - 1)) == 0 || writeCount == 0)
+		uint32_t end{};
+		if (writeCompressed)
+			end = decodeWritePacket(endpoint);
+		else
 		{
-			spiSelect(spiChip_t::none);
-			if (targetParams.actualCapacity > 0x18U)
-				writePageAddress();
-			while (isBusy())
-				continue;
-			if (writeCount)
-				writeAddress();
-			else
-				ledSetColour(false, true, false);
+			auto &epStatus{epStatusControllerOut[endpoint]};
+			// Compute how much of the buffer we've now received
+			const auto begin{writeTotal - writeCount};
+			end = writeTotal - epStatus.transferCount;
+			// Decrease the number of bytes left to receive by the amount received
+			writeCount -= end - begin;
+			perf::counters.bytesWritten += end - begin;
+		}
+		// Once we've recieved all the data, finish programming it before accepting any new requests
+		programReadyPages(end, writeCount == 0);
+		if (writeCount == 0)
+		{
+			ledSetColour(false, true, false);
+			eventLog::record(eventType_t::writeComplete, status.writeOK);
 		}
 		// If we completed writing the buffer and we need to verify, perform verification
 		if (writeCount == 0 && verifyWrite)
 		{
+			// spiRead() is too fine grained to time itself, so account for the verify pass as one transfer
+			const perf::cycleTimer_t timer{perf::counters.spiCycles};
 			beginPageRead(verifyPage);
 			for (const auto idx : substrate::indexSequence_t{writeTotal})
 			{
 				if (flashBuffer[idx] != spiRead(device))
 					status.writeOK = false;
-				if ((idx & (targetParams.flashPageSize - 1)) == 0)
+				// Having read the last byte of a page, re-address the chip for the next one
+				if (((idx + 1U) & (targetParams.flashPageSize - 1U)) == 0 && idx + 1U < writeTotal)
 				{
 					spiSelect(spiChip_t::none);
 					beginPageRead(++verifyPage);
@@ -513,8 +1068,10 @@ namespace usb::flashProto
 		}
 #endif
 
+		eventLog::record(eventType_t::writeBegin, 0U, uint16_t(writePage));
 		verifyPage = writePage;
-		writeAddress();
+		writeProgrammed = 0;
+		writeProgramming = false;
 
 		auto &epStatus{epStatusControllerOut[writeEndpoint]};
 		// Reset the transfer buffer pointer and amount
@@ -524,12 +1081,16 @@ namespace usb::flashProto
 
 	static bool setupWrite(const uint16_t count, const bool verify) noexcept
 	{
-		if (count > flashBuffer.size())
+		if (count > flashBuffer.size() || backgroundBusy())
+		{
+			eventLog::record(eventType_t::error, static_cast<uint8_t>(messages_t::write), count);
 			return false;
+		}
 		else if (!count)
 			writeCount = 256U;
 		else
 			writeCount = count;
+		eventLog::record(eventType_t::writeSetup, verify, uint16_t(writeCount));
 		auto &epStatus{epStatusControllerOut[0]};
 		epStatus.memBuffer = &writePage;
 		epStatus.transferCount = sizeof(writePage);
@@ -538,37 +1099,568 @@ namespace usb::flashProto
 
 		ledSetColour(true, true, false);
 		writeTotal = writeCount;
+		writeCompressed = false;
 		verifyWrite = verify;
 		status.writeOK = true;
 		return true;
 	}
 
-	static void handleResetTarget()
+	static void handleCompressedWrite()
 	{
-		if (!isDeviceReset())
+		if (targetDevice == spiChip_t::none || !compressedWrite.length ||
+			compressedWrite.length > flashBuffer.size())
 		{
-			setDeviceReset(true);
-			waitFor(20); // 20us
+			eventLog::record(eventType_t::error, static_cast<uint8_t>(messages_t::compressedWrite),
+				compressedWrite.length);
+			// Swallow the encoded data without programming anything so the host isn't left hanging
+			status.writeOK = false;
+			writeTotal = 0;
 		}
-		setDeviceReset(false);
-	}
-
-	static void handleAbort()
-	{
+		else
+		{
+			eventLog::record(eventType_t::writeBegin, 0U, uint16_t(compressedWrite.page));
+			writeTotal = compressedWrite.length;
+		}
+		writePage = compressedWrite.page;
+		verifyWrite = compressedWrite.verify && writeTotal;
+		verifyPage = writePage;
+		writeProgrammed = 0;
+		writeProgramming = false;
+		writeDecoder.reset(flashBuffer.data(), writeTotal);
+
+		auto &epStatus{epStatusControllerOut[writeEndpoint]};
+		// The encoded data arrives a packet at a time into writePacket, to be decoded into flashBuffer
+		writePacketLength = std::min<uint32_t>(writeCount, writePacket.size());
+		epStatus.memBuffer = writePacket.data();
+		epStatus.transferCount = static_cast<uint16_t>(writePacketLength);
+	}
+
+	static bool setupCompressedWrite(const uint16_t count) noexcept
+	{
+		if (!count || backgroundBusy())
+		{
+			eventLog::record(eventType_t::error, static_cast<uint8_t>(messages_t::compressedWrite), count);
+			return false;
+		}
+		writeCount = count;
+		eventLog::record(eventType_t::writeSetup, 0U, count);
+		auto &epStatus{epStatusControllerOut[0]};
+		epStatus.memBuffer = &compressedWrite;
+		epStatus.transferCount = sizeof(compressedWrite);
+		epStatus.needsArming(true);
+		setupCallback = handleCompressedWrite;
+
+		ledSetColour(true, true, false);
+		writeCompressed = true;
+		status.writeOK = true;
+		return true;
+	}
+
+	static void handleFill() noexcept
+	{
+		// Check the fill is something we can actually do before starting it
+		if (!fillConfig.patternLength || fillConfig.patternLength > requests::maxFillPattern ||
+			!validRange(fillConfig.address, fillConfig.length))
+		{
+			ledSetColour(true, false, false);
+			fillStatus.complete = 3;
+			eventLog::record(eventType_t::error, static_cast<uint8_t>(messages_t::fill));
+			return;
+		}
+		eventLog::record(eventType_t::writeBegin, 0U, uint16_t(fillConfig.address / targetParams.flashPageSize));
+		ledSetColour(true, true, false);
+		fillProgramming = false;
+		fillActive = true;
+	}
+
+	static bool setupFill() noexcept
+	{
+		fillStatus = {};
+		fillStatus.writeOK = true;
+		if (targetDevice == spiChip_t::none || backgroundBusy())
+		{
+			fillStatus.complete = 2;
+			eventLog::record(eventType_t::error, static_cast<uint8_t>(messages_t::fill));
+			return false;
+		}
+		// Set up to read from the USB host the range and pattern they want filled
+		auto &epStatus{epStatusControllerOut[0]};
+		epStatus.memBuffer = &fillConfig;
+		epStatus.transferCount = sizeof(fillConfig);
+		epStatus.needsArming(true);
+		setupCallback = handleFill;
+		return true;
+	}
+
+	// Generate the next page of the fill into flashBuffer, and start the chip programming it
+	static void programFillPage() noexcept
+	{
+		const uint32_t pageSize{targetParams.flashPageSize};
+		const uint32_t offset{fillStatus.bytesWritten};
+		fillPageAddress = fillConfig.address + offset;
+		// Don't cross a page boundary, as the chip would wrap around to the start of the page
+		fillPageLength = std::min(pageSize - (fillPageAddress & (pageSize - 1U)), fillConfig.length - offset);
+		for (uint32_t idx{}; idx < fillPageLength; ++idx)
+			flashBuffer[idx] = fillConfig.pattern[(offset + idx) % fillConfig.patternLength];
+
+		writeAddress(fillPageAddress);
+		spi::withBus(targetDevice, [&](const auto bus) { bus.writeBlock(flashBuffer.data(), fillPageLength); });
+		spiSelect(spiChip_t::none);
+		if (isPageAddressed())
+			writePageAddress(fillPageAddress / pageSize);
+		fillStatus.bytesWritten += fillPageLength;
+		perf::counters.bytesWritten += fillPageLength;
+		++perf::counters.pagesProgrammed;
+		fillProgramming = true;
+	}
+
+	static void verifyFillPage() noexcept
+	{
+		auto &device{*spiDevice(targetDevice)};
+		beginRead(fillPageAddress);
+		for (uint32_t idx{}; idx < fillPageLength; ++idx)
+		{
+			if (flashBuffer[idx] != spiRead(device))
+				fillStatus.writeOK = false;
+		}
+		spiSelect(spiChip_t::none);
+	}
+
+	/*!
+	 * Run the fill for up to tickBudget microseconds. As the data is generated locally this
+	 * goes as fast as the chip can program, but still hands the processor back to USB every tick.
+	 */
+	static void runFill() noexcept
+	{
+		const auto start{eventLog::timestamp()};
+		while (fillActive && eventLog::timestamp() - start < tickBudget)
+		{
+			if (fillProgramming)
+			{
+				// Rather than spin on the chip for the rest of the tick, hand back to USB and look again next tick
+				if (isBusy())
+					break;
+				fillProgramming = false;
+				eventLog::record(eventType_t::pageProgrammed, 0U, uint16_t(fillPageAddress / targetParams.flashPageSize));
+				if (fillConfig.verify)
+					verifyFillPage();
+			}
+			if (fillStatus.bytesWritten == fillConfig.length)
+			{
+				fillActive = false;
+				fillStatus.complete = 1;
+				ledSetColour(false, true, false);
+				eventLog::record(eventType_t::writeComplete, fillStatus.writeOK);
+				break;
+			}
+			programFillPage();
+		}
+	}
+
+	static void handleBlankCheck() noexcept
+	{
+		if (!validRange(blankConfig.address, blankConfig.length))
+		{
+			blankResult.complete = 3;
+			eventLog::record(eventType_t::error, static_cast<uint8_t>(messages_t::blankCheck));
+			return;
+		}
+		eventLog::record(eventType_t::readBegin, static_cast<uint8_t>(messages_t::blankCheck),
+			uint16_t(blankConfig.address / targetParams.flashPageSize));
+		blankBackward = false;
+		blankCursor = blankConfig.address;
+		blankActive = true;
+	}
+
+	static bool setupBlankCheck() noexcept
+	{
+		blankResult = {};
+		if (targetDevice == spiChip_t::none || backgroundBusy())
+		{
+			blankResult.complete = 2;
+			eventLog::record(eventType_t::error, static_cast<uint8_t>(messages_t::blankCheck));
+			return false;
+		}
+		// Set up to read from the USB host the range they want checked
+		auto &epStatus{epStatusControllerOut[0]};
+		epStatus.memBuffer = &blankConfig;
+		epStatus.transferCount = sizeof(blankConfig);
+		epStatus.needsArming(true);
+		setupCallback = handleBlankCheck;
+		return true;
+	}
+
+	// Find the offset of the first byte of data that isn't erased, or length if they all are
+	static uint32_t firstUsedByte(const uint8_t *const data, const uint32_t length) noexcept
+	{
+		uint32_t offset{};
+		// Compare a word at a time until we find a word that isn't all 0xFF
+		for (; offset + blankWordSize <= length; offset += blankWordSize)
+		{
+			uint32_t word{};
+			// NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+			std::memcpy(&word, data + offset, blankWordSize);
+			if (word != UINT32_MAX)
+				break;
+		}
+		// Then find which byte in that word (or the tail of the data) it was
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+		while (offset < length && data[offset] == 0xFFU)
+			++offset;
+		return offset;
+	}
+
+	// Find the offset one past the last byte of data that isn't erased, or 0 if they all are
+	static uint32_t lastUsedByte(const uint8_t *const data, const uint32_t length) noexcept
+	{
+		uint32_t end{length};
+		// Deal with any bytes past the last whole word first
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+		while (end & (blankWordSize - 1U) && data[end - 1U] == 0xFFU)
+			--end;
+		if (end & (blankWordSize - 1U))
+			return end;
+		for (; end >= blankWordSize; end -= blankWordSize)
+		{
+			uint32_t word{};
+			// NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+			std::memcpy(&word, data + end - blankWordSize, blankWordSize);
+			if (word != UINT32_MAX)
+				break;
+		}
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+		while (end && data[end - 1U] == 0xFFU)
+			--end;
+		return end;
+	}
+
+	static void readBlankChunk(const uint32_t address, const uint32_t length) noexcept
+	{
+		beginRead(address);
+		spi::withBus(targetDevice, [&](const auto bus) { bus.readBlock(flashBuffer.data(), length); });
+		spiSelect(spiChip_t::none);
+		blankResult.bytesScanned += length;
+	}
+
+	static void completeBlankCheck(const bool blank) noexcept
+	{
+		blankActive = false;
+		blankResult.blank = blank;
+		blankResult.complete = 1;
+		eventLog::record(eventType_t::readComplete, static_cast<uint8_t>(messages_t::blankCheck));
+	}
+
+	/*!
+	 * Run the blank check for up to tickBudget microseconds. The scan runs forward until it finds
+	 * the first used byte, then from the end of the range back down until it finds the last, so
+	 * only the blank parts of the range at either end plus a chunk either side of them get read.
+	 * Chunks never cross a Flash page boundary so page addressed devices can read them in one go.
+	 */
+	static void runBlankCheck() noexcept
+	{
+		const auto start{eventLog::timestamp()};
+		const uint32_t pageSize{targetParams.flashPageSize};
+		const auto end{blankConfig.address + blankConfig.length};
+		while (blankActive && eventLog::timestamp() - start < tickBudget)
+		{
+			if (!blankBackward)
+			{
+				if (blankCursor == end)
+				{
+					completeBlankCheck(true);
+					break;
+				}
+				const auto chunk{std::min({blankChunkSize, pageSize - (blankCursor & (pageSize - 1U)), end - blankCursor})};
+				readBlankChunk(blankCursor, chunk);
+				const auto used{firstUsedByte(flashBuffer.data(), chunk)};
+				if (used == chunk)
+					blankCursor += chunk;
+				else
+				{
+					blankResult.firstUsed = blankCursor + used;
+					blankResult.lastUsed = blankResult.firstUsed;
+					blankBackward = true;
+					blankCursor = end;
+				}
+			}
+			else
+			{
+				// Everything after the first used byte that's left to scan
+				const auto remaining{blankCursor - (blankResult.firstUsed + 1U)};
+				const auto pageOffset{blankCursor & (pageSize - 1U)};
+				const auto chunk{std::min({blankChunkSize, pageOffset ? pageOffset : pageSize, remaining})};
+				if (!chunk)
+				{
+					completeBlankCheck(false);
+					break;
+				}
+				blankCursor -= chunk;
+				readBlankChunk(blankCursor, chunk);
+				const auto used{lastUsedByte(flashBuffer.data(), chunk)};
+				if (used)
+				{
+					blankResult.lastUsed = blankCursor + used - 1U;
+					completeBlankCheck(false);
+				}
+			}
+		}
+	}
+
+	// Page addressed devices don't have a unique ID to read
+	static bool readUniqueID() noexcept
+	{
+		if (targetDevice == spiChip_t::none || isPageAddressed() || backgroundBusy())
+		{
+			eventLog::record(eventType_t::error, static_cast<uint8_t>(messages_t::uniqueID));
+			return false;
+		}
+		auto &device{*spiDevice(targetDevice)};
+		spiSelect(targetDevice);
+		spiWrite(device, spiOpcodes::readUniqueID);
+		// The instruction is followed by 4 dummy bytes on most parts (3 address + 1 dummy on some, to the same effect)
+		for (uint8_t dummy{}; dummy < 4U; ++dummy)
+			spiWrite(device, 0U);
+		for (auto &byte : uniqueID.id)
+			byte = spiRead(device);
+		spiSelect(spiChip_t::none);
+		return true;
+	}
+
+	static void handleChecksum() noexcept
+	{
+		if (!validRange(checksumConfig.address, checksumConfig.length))
+		{
+			checksumResult.complete = 3;
+			eventLog::record(eventType_t::error, static_cast<uint8_t>(messages_t::checksum));
+			return;
+		}
+		eventLog::record(eventType_t::readBegin, static_cast<uint8_t>(messages_t::checksum),
+			uint16_t(checksumConfig.address / targetParams.flashPageSize));
+		checksumCRC = {};
+		checksumActive = true;
+	}
+
+	static bool setupChecksum() noexcept
+	{
+		checksumResult = {};
+		if (targetDevice == spiChip_t::none || backgroundBusy())
+		{
+			checksumResult.complete = 2;
+			eventLog::record(eventType_t::error, static_cast<uint8_t>(messages_t::checksum));
+			return false;
+		}
+		// Set up to read from the USB host the range they want checksummed
+		auto &epStatus{epStatusControllerOut[0]};
+		epStatus.memBuffer = &checksumConfig;
+		epStatus.transferCount = sizeof(checksumConfig);
+		epStatus.needsArming(true);
+		setupCallback = handleChecksum;
+		return true;
+	}
+
+	// Run the checksum for up to tickBudget microseconds, a chunk at a time just as the blank check reads
+	static void runChecksum() noexcept
+	{
+		const auto start{eventLog::timestamp()};
+		const uint32_t pageSize{targetParams.flashPageSize};
+		while (checksumActive && eventLog::timestamp() - start < tickBudget)
+		{
+			const auto address{checksumConfig.address + checksumResult.bytesScanned};
+			const auto remaining{checksumConfig.length - checksumResult.bytesScanned};
+			if (!remaining)
+			{
+				checksumActive = false;
+				checksumResult.crc = checksumCRC.value();
+				checksumResult.complete = 1;
+				eventLog::record(eventType_t::readComplete, static_cast<uint8_t>(messages_t::checksum));
+				break;
+			}
+			const auto chunk{std::min({blankChunkSize, pageSize - (address & (pageSize - 1U)), remaining})};
+			beginRead(address);
+			spi::withBus(targetDevice, [&](const auto bus) { bus.readBlock(flashBuffer.data(), chunk); });
+			spiSelect(spiChip_t::none);
+			checksumCRC.update(flashBuffer.data(), chunk);
+			checksumResult.bytesScanned += chunk;
+		}
+	}
+
+	// Whether the bad block scan found the given erase block to be bad
+	static bool isBadBlock(const uint32_t block) noexcept
+	{
+		if (badBlockStatus.complete != 1U && badBlockStatus.complete != 4U)
+			return false;
+		const auto listed{badBlockStatus.badCount};
+		return std::find(badBlockList.begin(), badBlockList.begin() + listed, block) != badBlockList.begin() + listed;
+	}
+
+	static void noteBadBlock(const uint16_t block) noexcept
+	{
+		const auto listed{badBlockStatus.badCount};
+		// A block can be both marked bad and in the look-up table, so only count it the once
+		if (std::find(badBlockList.begin(), badBlockList.begin() + listed, block) != badBlockList.begin() + listed)
+			return;
+		// Once the list is full there's no telling repeats from new bad blocks, so stop counting them
+		if (listed == badBlockList.size())
+		{
+			badBlockOverflow = true;
+			return;
+		}
+		badBlockList[listed] = block;
+		++badBlockStatus.badCount;
+	}
+
+	/*!
+	 * The W25N keeps a look-up table of the bad blocks it has been told to replace, and which good blocks replace
+	 * them. The chip redirects accesses to a replaced block to its replacement, so the replaced block reads as good
+	 * and it's the replacement that has to be kept out of use. Each of the 20 links is the replaced block then the
+	 * replacement, with the top two bits of the replaced block saying if the link is enabled and if it's invalid.
+	 */
+	static void readW25NLookUpTable() noexcept
+	{
+		auto &device{*spiDevice(targetDevice)};
+		spiSelect(targetDevice);
+		spiWrite(device, spiOpcodes::readBBMTable);
+		spiWrite(device, 0);
+		for (uint8_t link{}; link < 20U; ++link)
+		{
+			uint16_t replaced{spiRead(device)};
+			replaced = uint16_t((replaced << 8U) | spiRead(device));
+			uint16_t replacement{spiRead(device)};
+			replacement = uint16_t((replacement << 8U) | spiRead(device));
+			if ((replaced & 0xC000U) == 0x8000U && replacement < badBlockStatus.blockCount)
+				noteBadBlock(replacement);
+		}
+		spiSelect(spiChip_t::none);
+	}
+
+	// A NAND's factory bad block marker is the first byte of the spare area of the block's first page
+	static bool blockMarkedBad(const uint32_t block) noexcept
+	{
+		auto &device{*spiDevice(targetDevice)};
+		const uint32_t pageSize{targetParams.flashPageSize};
+		// NOLINTNEXTLINE(cppcoreguidelines-init-variables)
+		const uint32_t page{block * (targetParams.erasePageSize / pageSize)};
+		spiSelect(targetDevice);
+		spiWrite(device, spiOpcodes::pageAddressRead);
+		spiWrite(device, uint8_t(page >> 16U));
+		spiWrite(device, uint8_t(page >> 8U));
+		spiWrite(device, uint8_t(page));
+		spiSelect(spiChip_t::none);
+
+		waitNotBusy();
+
+		// The spare area follows on from the page's data in the page buffer
+		spiSelect(targetDevice);
+		spiWrite(device, spiOpcodes::pageRead);
+		spiWrite(device, uint8_t(pageSize >> 8U));
+		spiWrite(device, uint8_t(pageSize));
+		spiWrite(device, 0);
+		const auto marker{spiRead(device)};
+		spiSelect(spiChip_t::none);
+		return marker != 0xFFU;
+	}
+
+	static bool setupBadBlockScan(const bool rescan) noexcept
+	{
+		// A scan that's already under way just carries on, with the host polling it as before
+		if (badBlockActive)
+			return true;
+		if (targetDevice == spiChip_t::none || backgroundBusy() || !isPageAddressed())
+		{
+			badBlockStatus = {};
+			badBlockStatus.complete = targetDevice == spiChip_t::none || isPageAddressed() ? 2U : 3U;
+			eventLog::record(eventType_t::error, static_cast<uint8_t>(messages_t::badBlocks));
+			return false;
+		}
+		// The result is kept for the rest of the targeting session, so only scan again if asked to
+		if (!rescan && (badBlockStatus.complete == 1U || badBlockStatus.complete == 4U))
+			return true;
+		eventLog::record(eventType_t::readBegin, static_cast<uint8_t>(messages_t::badBlocks));
+		badBlockStatus = {};
+		badBlockStatus.blockCount = uint16_t(std::min<uint32_t>(
+			capacityBytes(targetParams.actualCapacity) / targetParams.erasePageSize, UINT16_MAX));
+		badBlockOverflow = false;
+		badBlockCursor = 0;
+		// Exception for the dimbos at Winbond.. *grumbles*
+		if (targetID.manufacturer == 0xEFU && targetID.type == 0xAAU)
+		{
+			readW25NLookUpTable();
+			// The spare areas can only be reached in buffer read mode
+			if (targetParams.streamsPages())
+				setW25NReadMode(false);
+		}
+		badBlockActive = true;
+		return true;
+	}
+
+	static const responses::badBlocks_t &badBlockListing(const uint16_t first) noexcept
+	{
+		badBlockChunk = badBlockStatus;
+		const size_t listed{badBlockStatus.badCount};
+		if (badBlockActive || first >= listed)
+			return badBlockChunk;
+		badBlockChunk.count = uint8_t(std::min(listed - first, badBlockChunk.blocks.size()));
+		std::copy_n(badBlockList.begin() + first, badBlockChunk.count, badBlockChunk.blocks.begin());
+		return badBlockChunk;
+	}
+
+	// Check the factory bad block markers for up to tickBudget microseconds, a block at a time
+	static void runBadBlockScan() noexcept
+	{
+		const auto start{eventLog::timestamp()};
+		while (badBlockActive && eventLog::timestamp() - start < tickBudget)
+		{
+			if (badBlockCursor == badBlockStatus.blockCount)
+			{
+				std::sort(badBlockList.begin(), badBlockList.begin() + badBlockStatus.badCount);
+				if (targetParams.streamsPages())
+					setW25NReadMode(true);
+				badBlockActive = false;
+				badBlockStatus.complete = badBlockOverflow ? 4U : 1U;
+				eventLog::record(eventType_t::readComplete, static_cast<uint8_t>(messages_t::badBlocks),
+					badBlockStatus.badCount);
+				break;
+			}
+			if (blockMarkedBad(badBlockCursor))
+				noteBadBlock(badBlockCursor);
+			++badBlockCursor;
+		}
+	}
+
+	static void handleAbort()
+	{
+		eventLog::record(eventType_t::abort);
 		// Deselect the target device and clean up selection state
 		spiSelect(spiChip_t::none);
+		setFourByteMode(false);
 		targetDevice = spiChip_t::none;
 		targetID = {};
 		targetParams = {};
+		forgetChips();
+		// The clock training result went with the targeting session
+		busClock = {};
+		spiResetClocks();
 
 		// Reset the pending read, write and verification state
 		readCount = 0;
 		writeCount = 0;
 		writeTotal = 0;
+		writeProgrammed = 0;
+		writeProgramming = false;
+		writeCompressed = false;
+		writePacketLength = 0;
 		verifyWrite = false;
+		readFrameLength = 0;
+		readFrameOffset = 0;
 
-		// Reset erase state and assert that
+		// Reset erase, fill and blank check state and assert that
 		eraseActive = false;
+		fillActive = false;
+		fillProgramming = false;
+		blankActive = false;
+		checksumActive = false;
+		badBlockActive = false;
+		badBlockStatus = {};
 		eraseOperation = eraseOperation_t::idle;
 
 		// Reset the transfer endpoints
@@ -588,20 +1680,33 @@ namespace usb::flashProto
 		status = {};
 	}
 
+	static void handleResetTarget()
+	{
+		// The target is about to boot from its chip, so it needs to find it in its default addressing mode.
+		// Once it's running it may do anything to the chip, so a session on the chip ends here as on an abort
+		if (targetDevice == spiChip_t::target)
+			handleAbort();
+		externalChip.reset();
+		if (!isDeviceReset())
+		{
+			setDeviceReset(true);
+			waitFor(20); // 20us
+		}
+		setDeviceReset(false);
+	}
+
 	static void performSFDPRead(const uint8_t endpoint) noexcept
 	{
 		// If we've run out of work to do, return early.
 		if (readCount == 0)
 			return;
-		// Grab the USB stack IN endpoint control structure and SPI device to use
+		// Grab the USB stack IN endpoint control structure to use
 		auto &epStatus{epStatusControllerIn[endpoint]};
-		auto &device{*spiDevice()};
 		// We only want to read up to the requested number of bytes, so pick
 		// between the read count remaining and the response buffer size (whichever's smaller)
-		const auto amount{std::min(static_cast<uint16_t>(response.size()), readCount)};
+		const auto amount{static_cast<uint16_t>(std::min<uint32_t>(response.size(), readCount))};
 		// read amount SFDP bytes and store them in the response buffer
-		for (const auto idx : substrate::indexSequence_t{amount})
-			response[idx] = spiRead(device);
+		spi::withBus(targetDevice, [&](const auto bus) { bus.readBlock(response.data(), amount); });
 		// Reset the transfer buffer pointer and amount
 		epStatus.memBuffer = response.data();
 		epStatus.transferCount = amount;
@@ -609,6 +1714,7 @@ namespace usb::flashProto
 		writeEP(endpoint);
 		// Update our read counters and perform any cleanup that might be necessary
 		readCount -= amount;
+		perf::counters.bytesRead += amount;
 		if (readCount == 0)
 		{
 			spiSelect(spiChip_t::none);
@@ -622,6 +1728,7 @@ namespace usb::flashProto
 		if (targetDevice == spiChip_t::none)
 		{
 			// TODO: Handle.. - use the status area to indicate we were asked to do something silly
+			eventLog::record(eventType_t::error, static_cast<uint8_t>(messages_t::sfdp));
 			return;
 		}
 
@@ -665,47 +1772,137 @@ namespace usb::flashProto
 
 	static void performDataOrSFDPRead(const uint8_t endpoint)
 	{
-		if (readMode == readMode_t::data)
-			performRead(endpoint);
-		else
-			performSFDPRead(endpoint);
+		switch (readMode)
+		{
+			case readMode_t::data:
+				performRead(endpoint);
+				break;
+			case readMode_t::sfdp:
+				performSFDPRead(endpoint);
+				break;
+			case readMode_t::compressed:
+				performCompressedRead(endpoint);
+				break;
+		}
+	}
+
+	// Simple check value for comparing the results of the benchmark's reads
+	static uint32_t checksum(const size_t length) noexcept
+	{
+		uint32_t sum{};
+		for (const auto idx : substrate::indexSequence_t{length})
+			sum = ((sum << 1U) | (sum >> 31U)) ^ flashBuffer[idx];
+		return sum;
+	}
+
+	// Time reading the start of the target using first 8-bit and then 16-bit SPI frames for the data phase
+	static bool runBenchmark() noexcept
+	{
+		if (targetDevice == spiChip_t::none)
+		{
+			eventLog::record(eventType_t::error, static_cast<uint8_t>(messages_t::benchmark));
+			return false;
+		}
+		// Page addressed devices can only be read a page at a time
+		const auto length{isPageAddressed() ? std::min<size_t>(targetParams.flashPageSize, flashBuffer.size()) :
+			flashBuffer.size()};
+		benchmarkResult = {};
+		benchmarkResult.length = static_cast<uint16_t>(length);
+		benchmarkResult.cycleFrequency = perf::cpuFrequency;
+
+		beginRead(0);
+		spi::withBus(targetDevice, [&](const auto bus)
+		{
+			bus.resync();
+			const auto start{perf::cycles()};
+			bus.readBytes(flashBuffer.data(), length);
+			benchmarkResult.byteCycles = perf::cycles() - start;
+		});
+		spiSelect(spiChip_t::none);
+		const auto byteChecksum{checksum(length)};
+
+		beginRead(0);
+		spi::withBus(targetDevice, [&](const auto bus)
+		{
+			const auto start{perf::cycles()};
+			bus.readBlock(flashBuffer.data(), length);
+			benchmarkResult.wordCycles = perf::cycles() - start;
+		});
+		spiSelect(spiChip_t::none);
+		benchmarkResult.match = byteChecksum == checksum(length);
+		return true;
+	}
+
+	// Move on to the next range of a multi-range erase that has pages left in it, if there is one
+	static bool nextEraseRange() noexcept
+	{
+		if (eraseOperation != eraseOperation_t::pageRanges)
+			return false;
+		while (++eraseRange < eraseRanges.count)
+		{
+			eraseConfig = eraseRanges.ranges[eraseRange];
+			if (eraseConfig.beginPage < eraseConfig.endPage)
+			{
+				status.eraseRange = eraseRange;
+				return true;
+			}
+		}
+		return false;
 	}
 
 	static void tick() noexcept
 	{
+		perf::frameTick();
+		eventLog::tick();
+		if (fillActive)
+			runFill();
+		if (blankActive)
+			runBlankCheck();
+		if (checksumActive)
+			runChecksum();
+		if (badBlockActive)
+			runBadBlockScan();
 		if (eraseActive && !isBusy())
 		{
 			auto *device{spiDevice(targetDevice)};
+			if (eraseConfig.beginPage >= eraseConfig.endPage && device)
+				static_cast<void>(nextEraseRange());
 			status.erasePage = eraseConfig.beginPage;
 			if (eraseConfig.beginPage >= eraseConfig.endPage || !device)
 			{
 				eraseActive = false;
 				ledSetColour(false, true, false);
+				eventLog::record(eventType_t::eraseComplete);
 				return;
 			}
+			// Erasing a bad block would wipe out its bad block marker, so leave those be
+			if (isPageAddressed() && isBadBlock(eraseConfig.beginPage))
+			{
+				++eraseConfig.beginPage;
+				return;
+			}
+			eventLog::record(eventType_t::eraseIssue, status.eraseRange, uint16_t(eraseConfig.beginPage));
 			spiSelect(targetDevice);
 			spiWrite(*device, spiOpcodes::writeEnable);
 			spiSelect(spiChip_t::none);
 
 			spiSelect(targetDevice);
 			spiWrite(*device, targetParams.eraseInstruction);
-			if (targetParams.actualCapacity > 0x18U)
+			if (isPageAddressed())
 			{
-				spiWrite(*device, uint8_t(eraseConfig.beginPage >> 16U));
-				spiWrite(*device, uint8_t(eraseConfig.beginPage >> 8U));
-				spiWrite(*device, uint8_t(eraseConfig.beginPage));
+				// Block erases take the address of any page in the block
+				// NOLINTNEXTLINE(cppcoreguidelines-init-variables)
+				const uint32_t page{eraseConfig.beginPage * (targetParams.erasePageSize / targetParams.flashPageSize)};
+				spiWrite(*device, uint8_t(page >> 16U));
+				spiWrite(*device, uint8_t(page >> 8U));
+				spiWrite(*device, uint8_t(page));
 			}
 			else
-			{
-				// NOLINTNEXTLINE(cppcoreguidelines-init-variables)
-				const uint32_t eraseAddress{eraseConfig.beginPage * targetParams.erasePageSize};
 				// Translate the page number into a byte address
-				spiWrite(*device, uint8_t(eraseAddress >> 16U));
-				spiWrite(*device, uint8_t(eraseAddress >> 8U));
-				spiWrite(*device, uint8_t(eraseAddress));
-			}
+				writeByteAddress(*device, eraseConfig.beginPage * targetParams.erasePageSize);
 			spiSelect(spiChip_t::none);
 			++eraseConfig.beginPage;
+			++perf::counters.sectorsErased;
 		}
 	}
 
@@ -718,12 +1915,15 @@ namespace usb::flashProto
 			return {response_t::unhandled, nullptr, 0};
 
 		const auto request{static_cast<messages_t>(packet.request)};
+		// Don't log requests to drain the log, or draining it would never finish
+		if (request != messages_t::events)
+			eventLog::record(eventType_t::controlRequest, packet.request, packet.value);
 		switch (request)
 		{
 			case messages_t::deviceCount:
 				if (packet.requestType.dir() != endpointDir_t::controllerIn)
 					return {response_t::stall, nullptr, 0};
-				return {response_t::data, response.data(), fetchDeviceCount()};
+				return {response_t::data, response.data(), fetchDeviceCount(packet.value != 0U)};
 			case messages_t::listDevice:
 				if (packet.requestType.dir() != endpointDir_t::controllerIn)
 					return {response_t::stall, nullptr, 0};
@@ -780,6 +1980,94 @@ namespace usb::flashProto
 					return {response_t::zeroLength, nullptr, 0};
 				else
 					return {response_t::stall, nullptr, 0};
+			case messages_t::readRange:
+				if (packet.requestType.dir() != endpointDir_t::controllerOut)
+					return {response_t::stall, nullptr, 0};
+				if (setupReadRange())
+					return {response_t::zeroLength, nullptr, 0};
+				else
+					return {response_t::stall, nullptr, 0};
+			case messages_t::stats:
+			{
+				if (packet.requestType.dir() != endpointDir_t::controllerIn)
+					return {response_t::stall, nullptr, 0};
+				const auto &stats{perf::snapshot()};
+				// A non-zero value requests the counters be reset once read
+				if (packet.value)
+					perf::reset();
+				return {response_t::data, &stats, sizeof(stats)};
+			}
+			case messages_t::events:
+				if (packet.requestType.dir() != endpointDir_t::controllerIn)
+					return {response_t::stall, nullptr, 0};
+				eventLog::drain(eventsChunk);
+				return {response_t::data, &eventsChunk, sizeof(eventsChunk)};
+			case messages_t::benchmark:
+				if (packet.requestType.dir() != endpointDir_t::controllerIn)
+					return {response_t::stall, nullptr, 0};
+				if (runBenchmark())
+					return {response_t::data, &benchmarkResult, sizeof(benchmarkResult)};
+				else
+					return {response_t::stall, nullptr, 0};
+			case messages_t::fill:
+				if (packet.requestType.dir() == endpointDir_t::controllerIn)
+					return {response_t::data, &fillStatus, sizeof(fillStatus)};
+				if (setupFill())
+					return {response_t::zeroLength, nullptr, 0};
+				else
+					return {response_t::stall, nullptr, 0};
+			case messages_t::blankCheck:
+				if (packet.requestType.dir() == endpointDir_t::controllerIn)
+					return {response_t::data, &blankResult, sizeof(blankResult)};
+				if (setupBlankCheck())
+					return {response_t::zeroLength, nullptr, 0};
+				else
+					return {response_t::stall, nullptr, 0};
+			case messages_t::busClock:
+				if (packet.requestType.dir() == endpointDir_t::controllerIn)
+					return {response_t::data, &busClock, sizeof(busClock)};
+				if (handleBusClock(packet.value))
+					return {response_t::zeroLength, nullptr, 0};
+				else
+					return {response_t::stall, nullptr, 0};
+			case messages_t::compressedWrite:
+				if (packet.requestType.dir() != endpointDir_t::controllerOut)
+					return {response_t::stall, nullptr, 0};
+				if (setupCompressedWrite(packet.value))
+					return {response_t::zeroLength, nullptr, 0};
+				else
+					return {response_t::stall, nullptr, 0};
+			case messages_t::compressedRead:
+				if (packet.requestType.dir() != endpointDir_t::controllerOut)
+					return {response_t::stall, nullptr, 0};
+				if (setupCompressedRead())
+					return {response_t::zeroLength, nullptr, 0};
+				else
+					return {response_t::stall, nullptr, 0};
+			case messages_t::uniqueID:
+				if (packet.requestType.dir() != endpointDir_t::controllerIn)
+					return {response_t::stall, nullptr, 0};
+				if (readUniqueID())
+					return {response_t::data, &uniqueID, sizeof(uniqueID)};
+				else
+					return {response_t::stall, nullptr, 0};
+			case messages_t::checksum:
+				if (packet.requestType.dir() == endpointDir_t::controllerIn)
+					return {response_t::data, &checksumResult, sizeof(checksumResult)};
+				if (setupChecksum())
+					return {response_t::zeroLength, nullptr, 0};
+				else
+					return {response_t::stall, nullptr, 0};
+			case messages_t::badBlocks:
+				if (packet.requestType.dir() == endpointDir_t::controllerIn)
+				{
+					const auto &listing{badBlockListing(packet.value)};
+					return {response_t::data, &listing, sizeof(listing)};
+				}
+				if (setupBadBlockScan(packet.value != 0U))
+					return {response_t::zeroLength, nullptr, 0};
+				else
+					return {response_t::stall, nullptr, 0};
 		}
 
 		return {response_t::stall, nullptr, 0};
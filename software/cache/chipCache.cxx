@@ -0,0 +1,167 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#include <cstdlib>
+#include <string_view>
+#include <filesystem>
+#include <system_error>
+#include <fmt/core.h>
+#include "crc32.hxx"
+#include "chipCache.hxx"
+
+namespace flashprog::cache
+{
+	// The cache lives in $XDG_CACHE_HOME/flashprog, or ~/.cache/flashprog if that's not set
+	static std::optional<std::filesystem::path> cacheDirectory() noexcept
+	{
+		if (const auto *const cacheHome{std::getenv("XDG_CACHE_HOME")}; cacheHome && *cacheHome)
+			return std::filesystem::path{cacheHome} / "flashprog";
+		if (const auto *const home{std::getenv("HOME")}; home && *home)
+			return std::filesystem::path{home} / ".cache" / "flashprog";
+		return std::nullopt;
+	}
+
+	static std::optional<std::filesystem::path> cachePath(const chipKey_t &chip,
+		const std::string_view extension = ".state") noexcept try
+	{
+		const auto directory{cacheDirectory()};
+		if (!directory)
+			return std::nullopt;
+		std::string name{fmt::format("{:02x}{:02x}-", chip.manufacturer, chip.deviceType)};
+		for (const auto byte : chip.uniqueID)
+			name += fmt::format("{:02x}", byte);
+		return *directory / (name + std::string{extension});
+	}
+	catch (const std::exception &)
+	{
+		return std::nullopt;
+	}
+
+	// Write a cache file out to the side and then move it into place so a reader never sees half of it
+	template<typename writer_t> static bool writeCacheFile(const std::filesystem::path &path,
+		const writer_t &writeContents) noexcept
+	{
+		std::error_code error{};
+		std::filesystem::create_directories(path.parent_path(), error);
+		if (error)
+			return false;
+
+		auto partialPath{path};
+		partialPath += ".new";
+		{
+			const substrate::fd_t file{partialPath, O_WRONLY | O_CREAT | O_TRUNC | O_NOCTTY, substrate::normalMode};
+			if (!file.valid() || !writeContents(file))
+			{
+				std::filesystem::remove(partialPath, error);
+				return false;
+			}
+		}
+		std::filesystem::rename(partialPath, path, error);
+		return !error;
+	}
+
+	std::optional<imageDigest_t> digestImage(const substrate::fd_t &file, const uint32_t length,
+		const uint32_t blockSize) noexcept try
+	{
+		if (!blockSize)
+			return std::nullopt;
+		imageDigest_t digest{length, 0U, blockSize, {}};
+		digest.blockCRCs.reserve((length + blockSize - 1U) / blockSize);
+		std::vector<uint8_t> block(blockSize);
+		checksum::crc32_t imageCRC{};
+		for (uint32_t offset{}; offset < length; offset += blockSize)
+		{
+			const auto blockLength{std::min(length - offset, blockSize)};
+			if (!file.read(block.data(), blockLength))
+				return std::nullopt;
+			imageCRC.update(block.data(), blockLength);
+			digest.blockCRCs.push_back(checksum::crc32(block.data(), blockLength));
+		}
+		digest.crc = imageCRC.value();
+		if (!file.head())
+			return std::nullopt;
+		return digest;
+	}
+	catch (const std::bad_alloc &)
+	{
+		return std::nullopt;
+	}
+
+	std::optional<imageDigest_t> loadDigest(const chipKey_t &chip) noexcept try
+	{
+		const auto path{cachePath(chip)};
+		if (!path)
+			return std::nullopt;
+		const substrate::fd_t file{*path, O_RDONLY | O_NOCTTY};
+		cacheHeader_t header{};
+		if (!file.valid() || !file.read(header) || header.magic != cacheMagic || header.version != cacheVersion ||
+			!header.blockSize || header.blockCount != (header.imageLength + header.blockSize - 1U) / header.blockSize)
+			return std::nullopt;
+		imageDigest_t digest{header.imageLength, header.imageCRC, header.blockSize, {}};
+		digest.blockCRCs.resize(header.blockCount);
+		if (!file.read(digest.blockCRCs.data(), digest.blockCRCs.size() * sizeof(uint32_t)))
+			return std::nullopt;
+		return digest;
+	}
+	catch (const std::bad_alloc &)
+	{
+		return std::nullopt;
+	}
+
+	bool storeDigest(const chipKey_t &chip, const imageDigest_t &digest) noexcept
+	{
+		const auto path{cachePath(chip)};
+		if (!path)
+			return false;
+		return writeCacheFile(*path, [&](const substrate::fd_t &file)
+		{
+			cacheHeader_t header{};
+			header.imageLength = digest.length;
+			header.imageCRC = digest.crc;
+			header.blockSize = digest.blockSize;
+			header.blockCount = static_cast<uint32_t>(digest.blockCRCs.size());
+			return file.write(header) &&
+				file.write(digest.blockCRCs.data(), digest.blockCRCs.size() * sizeof(uint32_t));
+		});
+	}
+
+	void forgetChip(const chipKey_t &chip) noexcept
+	{
+		const auto path{cachePath(chip)};
+		if (!path)
+			return;
+		std::error_code error{};
+		std::filesystem::remove(*path, error);
+	}
+
+	std::optional<std::vector<uint8_t>> loadSFDP(const chipKey_t &chip) noexcept try
+	{
+		const auto path{cachePath(chip, ".sfdp")};
+		if (!path)
+			return std::nullopt;
+		const substrate::fd_t file{*path, O_RDONLY | O_NOCTTY};
+		sfdpHeader_t header{};
+		if (!file.valid() || !file.read(header) || header.magic != sfdpMagic || header.version != sfdpVersion ||
+			!header.length)
+			return std::nullopt;
+		std::vector<uint8_t> sfdp(header.length);
+		if (!file.read(sfdp.data(), sfdp.size()))
+			return std::nullopt;
+		return sfdp;
+	}
+	catch (const std::bad_alloc &)
+	{
+		return std::nullopt;
+	}
+
+	bool storeSFDP(const chipKey_t &chip, const std::vector<uint8_t> &sfdp) noexcept
+	{
+		const auto path{cachePath(chip, ".sfdp")};
+		if (!path)
+			return false;
+		return writeCacheFile(*path, [&](const substrate::fd_t &file)
+		{
+			sfdpHeader_t header{};
+			header.length = static_cast<uint32_t>(sfdp.size());
+			return file.write(header) && file.write(sfdp.data(), sfdp.size());
+		});
+	}
+} // namespace flashprog::cache
@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#ifndef CACHE_CHIP_CACHE_HXX
+#define CACHE_CHIP_CACHE_HXX
+
+#include <cstdint>
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <optional>
+#include <substrate/fd>
+
+namespace flashprog::cache
+{
+	// A chip is known by its JEDEC ID and factory programmed unique ID, which together never repeat
+	struct chipKey_t final
+	{
+		uint8_t manufacturer{};
+		uint8_t deviceType{};
+		std::array<uint8_t, 16> uniqueID{};
+	};
+
+	/*!
+	 * The chip-state cache keeps a file per chip recording the last image flashprog wrote to it.
+	 * Each file is a header followed by the CRC-32 of each erase block of the image in order.
+	 * All values are stored in host byte order.
+	 */
+	constexpr static std::array<char, 4> cacheMagic{{'F', 'P', 'C', 'S'}};
+	constexpr static uint16_t cacheVersion{1U};
+
+	struct cacheHeader_t final
+	{
+		std::array<char, 4> magic{cacheMagic};
+		uint16_t version{cacheVersion};
+		uint16_t reserved{};
+		uint32_t imageLength{};
+		uint32_t imageCRC{};
+		uint32_t blockSize{};
+		uint32_t blockCount{};
+	};
+	static_assert(sizeof(cacheHeader_t) == 24U);
+
+	struct imageDigest_t final
+	{
+		uint32_t length{};
+		uint32_t crc{};
+		uint32_t blockSize{};
+		// The CRC-32 of each blockSize long block, the last of which may be short
+		std::vector<uint32_t> blockCRCs{};
+
+		[[nodiscard]] bool operator ==(const imageDigest_t &other) const noexcept
+		{
+			return length == other.length && crc == other.crc && blockSize == other.blockSize &&
+				blockCRCs == other.blockCRCs;
+		}
+		[[nodiscard]] bool operator !=(const imageDigest_t &other) const noexcept { return !(*this == other); }
+
+		[[nodiscard]] uint32_t blockLength(const size_t block) const noexcept
+			{ return std::min<uint32_t>(blockSize, length - static_cast<uint32_t>(block * blockSize)); }
+	};
+
+	/*!
+	 * Alongside that, the cache keeps a copy of each chip's raw SFDP region, which never changes, so that it need
+	 * only be fetched from the chip the once. These files are a header followed by the region itself.
+	 */
+	constexpr static std::array<char, 4> sfdpMagic{{'F', 'P', 'S', 'F'}};
+	constexpr static uint16_t sfdpVersion{1U};
+
+	struct sfdpHeader_t final
+	{
+		std::array<char, 4> magic{sfdpMagic};
+		uint16_t version{sfdpVersion};
+		uint16_t reserved{};
+		uint32_t length{};
+	};
+	static_assert(sizeof(sfdpHeader_t) == 12U);
+
+	// Compute the digest of the first length bytes of file, leaving the file rewound to its start
+	[[nodiscard]] std::optional<imageDigest_t> digestImage(const substrate::fd_t &file, uint32_t length,
+		uint32_t blockSize) noexcept;
+	[[nodiscard]] std::optional<imageDigest_t> loadDigest(const chipKey_t &chip) noexcept;
+	[[nodiscard]] bool storeDigest(const chipKey_t &chip, const imageDigest_t &digest) noexcept;
+	// Drop what the cache knows about a chip's contents, as they are about to change
+	void forgetChip(const chipKey_t &chip) noexcept;
+	[[nodiscard]] std::optional<std::vector<uint8_t>> loadSFDP(const chipKey_t &chip) noexcept;
+	[[nodiscard]] bool storeSFDP(const chipKey_t &chip, const std::vector<uint8_t> &sfdp) noexcept;
+} // namespace flashprog::cache
+
+#endif /*CACHE_CHIP_CACHE_HXX*/
@@ -0,0 +1,466 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+#include <substrate/console>
+#include <substrate/fd>
+#include <fmt/core.h>
+#include "chipDatabase.hxx"
+#include "builtinChipDB.hxx"
+#include "utils/units.hxx"
+
+using namespace std::literals::chrono_literals;
+using substrate::console;
+using flashprog::utils::humanReadableSize;
+
+namespace flashprog::chipDB
+{
+	// Chips the database doesn't know get treated as taking this long to erase a page or the whole chip, which
+	// polls them as often as flashprog always has, and never gives up on an erase of one as having taken too long
+	constexpr static timing_t unknownPageErase{40ms, 0us};
+	constexpr static timing_t unknownChipErase{1s, 0us};
+	constexpr static uint8_t chipEraseOpcode{0xC7U};
+	// Chips bigger than this need 4-byte addresses to reach all of them
+	constexpr static uint32_t threeByteAddressLimit{16U * 1024U * 1024U};
+
+	microseconds eraseType_t::pollInterval() const noexcept
+		{ return std::clamp<microseconds>(time.typical / 4, 1ms, 125ms); }
+
+	[[nodiscard]] static std::string_view trim(std::string_view text) noexcept
+	{
+		const auto begin{text.find_first_not_of(" \t\r"sv)};
+		if (begin == std::string_view::npos)
+			return {};
+		const auto end{text.find_last_not_of(" \t\r"sv)};
+		return text.substr(begin, end - begin + 1U);
+	}
+
+	[[nodiscard]] static std::vector<std::string_view> splitFields(std::string_view text)
+	{
+		std::vector<std::string_view> fields{};
+		while (!(text = trim(text)).empty())
+		{
+			const auto end{std::min(text.find_first_of(" \t"sv), text.size())};
+			fields.push_back(text.substr(0, end));
+			text.remove_prefix(end);
+		}
+		return fields;
+	}
+
+	// Parse a number with the first of the given suffixes it ends in, scaling it by the amount for that suffix
+	template<size_t count> [[nodiscard]] static std::optional<uint64_t> parseSuffixed(const std::string_view text,
+		const std::array<std::pair<std::string_view, uint64_t>, count> &suffixes)
+	{
+		for (const auto &[suffix, scale] : suffixes)
+		{
+			if (text.size() <= suffix.size() || text.substr(text.size() - suffix.size()) != suffix)
+				continue;
+			const std::string number{text.substr(0, text.size() - suffix.size())};
+			char *end{nullptr};
+			const auto value{std::strtod(number.c_str(), &end)};
+			if (end != number.c_str() + number.size() || !std::isfinite(value) || value < 0.0)
+				return std::nullopt;
+			return static_cast<uint64_t>(std::llround(value * static_cast<double>(scale)));
+		}
+		return std::nullopt;
+	}
+
+	[[nodiscard]] static std::optional<uint32_t> parseSize(const std::string_view text)
+	{
+		constexpr static std::array<std::pair<std::string_view, uint64_t>, 4> sizeSuffixes
+		{{
+			{"KiB"sv, 1024U},
+			{"MiB"sv, 1024U * 1024U},
+			{"GiB"sv, 1024U * 1024U * 1024U},
+			{""sv, 1U},
+		}};
+		const auto size{parseSuffixed(text, sizeSuffixes)};
+		if (!size || !*size || *size > UINT32_MAX)
+			return std::nullopt;
+		return static_cast<uint32_t>(*size);
+	}
+
+	[[nodiscard]] static std::optional<microseconds> parseTime(const std::string_view text)
+	{
+		// "s" must come last so it's not mistaken for the end of "us" or "ms"
+		constexpr static std::array<std::pair<std::string_view, uint64_t>, 3> timeSuffixes
+		{{
+			{"us"sv, 1U},
+			{"ms"sv, 1000U},
+			{"s"sv, 1000U * 1000U},
+		}};
+		const auto time{parseSuffixed(text, timeSuffixes)};
+		if (!time)
+			return std::nullopt;
+		return microseconds{*time};
+	}
+
+	[[nodiscard]] static std::optional<uint8_t> parseHexByte(const std::string_view text)
+	{
+		const std::string number{text};
+		char *end{nullptr};
+		const auto value{std::strtoul(number.c_str(), &end, 16)};
+		if (number.empty() || end != number.c_str() + number.size() || value > UINT8_MAX)
+			return std::nullopt;
+		return static_cast<uint8_t>(value);
+	}
+
+	[[nodiscard]] static std::optional<uint16_t> parseClock(const std::string_view text)
+	{
+		const std::string number{text};
+		char *end{nullptr};
+		const auto value{std::strtoul(number.c_str(), &end, 10)};
+		if (number.empty() || end != number.c_str() + number.size() || value > UINT16_MAX)
+			return std::nullopt;
+		return static_cast<uint16_t>(value);
+	}
+
+	// Parse the value for a key of a chip's entry, returning what was wrong with it if it's not valid
+	[[nodiscard]] static std::string_view parseValue(chipProfile_t &chip, const std::string_view key,
+		const std::string_view value)
+	{
+		const auto fields{splitFields(value)};
+		if (key == "id"sv)
+		{
+			if (fields.size() != 3U)
+				return "the chip's ID must be 3 bytes long"sv;
+			const auto manufacturer{parseHexByte(fields[0])};
+			const auto deviceType{parseHexByte(fields[1])};
+			const auto capacityID{parseHexByte(fields[2])};
+			if (!manufacturer || !deviceType || !capacityID)
+				return "invalid chip ID"sv;
+			chip.manufacturer = *manufacturer;
+			chip.deviceType = *deviceType;
+			chip.capacityID = *capacityID;
+		}
+		else if (key == "capacity"sv || key == "page"sv)
+		{
+			const auto size{parseSize(value)};
+			if (!size)
+				return "invalid size"sv;
+			(key == "page"sv ? chip.pageSize : chip.capacity) = *size;
+		}
+		else if (key == "erase"sv)
+		{
+			if (fields.size() != 4U)
+				return "an erase must be given as its opcode, size, and typical and maximum times"sv;
+			const auto opcode{parseHexByte(fields[0])};
+			const auto size{parseSize(fields[1])};
+			const auto typical{parseTime(fields[2])};
+			const auto maximum{parseTime(fields[3])};
+			if (!opcode || !size || !typical || !maximum)
+				return "invalid erase instruction"sv;
+			chip.eraseTypes.push_back({*opcode, *size, {*typical, *maximum}});
+		}
+		else if (key == "chipErase"sv)
+		{
+			if (fields.size() != 3U)
+				return "a chip erase must be given as its opcode, and typical and maximum times"sv;
+			const auto opcode{parseHexByte(fields[0])};
+			const auto typical{parseTime(fields[1])};
+			const auto maximum{parseTime(fields[2])};
+			if (!opcode || !typical || !maximum)
+				return "invalid chip erase instruction"sv;
+			chip.chipErase = {*opcode, 0U, {*typical, *maximum}};
+		}
+		else if (key == "program"sv)
+		{
+			if (fields.size() != 2U)
+				return "page program time must be given as typical and maximum times"sv;
+			const auto typical{parseTime(fields[0])};
+			const auto maximum{parseTime(fields[1])};
+			if (!typical || !maximum)
+				return "invalid page program time"sv;
+			chip.pageProgram = {*typical, *maximum};
+		}
+		else if (key == "clock"sv)
+		{
+			if (fields.size() != 2U)
+				return "clock must be given as the read and fast read clocks"sv;
+			const auto readMHz{parseClock(fields[0])};
+			const auto fastReadMHz{parseClock(fields[1])};
+			if (!readMHz || !fastReadMHz)
+				return "invalid clock"sv;
+			chip.readMHz = *readMHz;
+			chip.fastReadMHz = *fastReadMHz;
+		}
+		else if (key == "quirks"sv)
+		{
+			for (const auto &quirk : fields)
+			{
+				if (quirk == "pageAddressed"sv)
+					chip.quirks |= uint8_t(quirk_t::pageAddressed);
+				else if (quirk == "continuousRead"sv)
+					chip.quirks |= uint8_t(quirk_t::continuousRead);
+				else if (quirk == "enter4ByteMode"sv)
+					chip.quirks |= uint8_t(quirk_t::enter4ByteMode);
+				else
+					return "unknown quirk"sv;
+			}
+		}
+		else
+			return "unknown key"sv;
+		return {};
+	}
+
+	// Check an entry has everything a chip needs, returning what it's missing if not
+	[[nodiscard]] static std::string_view checkChip(const chipProfile_t &chip) noexcept
+	{
+		if (!chip.manufacturer)
+			return "is missing its ID"sv;
+		if (!chip.capacity || chip.capacity & (chip.capacity - 1U))
+			return "must have a capacity that is a power of 2"sv;
+		if (!chip.pageSize)
+			return "is missing its page size"sv;
+		if (chip.eraseTypes.empty())
+			return "must have at least one erase instruction"sv;
+		if (chip.pageProgram.typical == 0us)
+			return "is missing its page program time"sv;
+		if (!chip.readMHz)
+			return "is missing its clock"sv;
+		return {};
+	}
+
+	std::optional<chipDatabase_t> chipDatabase_t::parse(std::string_view text, const std::string_view source)
+	{
+		chipDatabase_t database{};
+		size_t lineNumber{};
+		const auto checkLast
+		{
+			[&]() -> bool
+			{
+				if (database.chips.empty())
+					return true;
+				const auto &chip{database.chips.back()};
+				if (const auto problem{checkChip(chip)}; !problem.empty())
+				{
+					console.error(source, ": chip "sv, chip.name, ' ', problem);
+					return false;
+				}
+				const auto match
+				{
+					database.find(chip.manufacturer, chip.deviceType, chip.capacity)
+				};
+				if (match != &chip)
+				{
+					console.error(source, ": chips "sv, match->name, " and "sv, chip.name,
+						" have the same ID and capacity"sv);
+					return false;
+				}
+				return true;
+			}
+		};
+
+		while (!text.empty())
+		{
+			++lineNumber;
+			const auto lineEnd{std::min(text.find('\n'), text.size())};
+			auto line{text.substr(0, lineEnd)};
+			text.remove_prefix(std::min(lineEnd + 1U, text.size()));
+			line = trim(line.substr(0, std::min(line.find('#'), line.size())));
+			if (line.empty())
+				continue;
+
+			if (line.front() == '[' && line.back() == ']')
+			{
+				if (!checkLast())
+					return std::nullopt;
+				auto &chip{database.chips.emplace_back()};
+				chip.name = trim(line.substr(1, line.size() - 2U));
+				chip.known = true;
+				continue;
+			}
+
+			const auto problem
+			{
+				[&]() -> std::string_view
+				{
+					if (database.chips.empty())
+						return "value given outside of a chip section"sv;
+					const auto separator{line.find('=')};
+					if (separator == std::string_view::npos)
+						return "expected a \"key = value\" line"sv;
+					return parseValue(database.chips.back(), trim(line.substr(0, separator)),
+						trim(line.substr(separator + 1U)));
+				}()
+			};
+			if (!problem.empty())
+			{
+				console.error(source, ':', lineNumber, ": "sv, problem);
+				return std::nullopt;
+			}
+		}
+		if (!checkLast())
+			return std::nullopt;
+		return database;
+	}
+
+	void chipDatabase_t::merge(chipDatabase_t &&other)
+	{
+		for (auto &chip : other.chips)
+		{
+			const auto existing
+			{
+				std::find_if(chips.begin(), chips.end(), [&](const chipProfile_t &entry)
+				{
+					return entry.manufacturer == chip.manufacturer && entry.deviceType == chip.deviceType &&
+						entry.capacity == chip.capacity;
+				})
+			};
+			if (existing != chips.end())
+				*existing = std::move(chip);
+			else
+				chips.push_back(std::move(chip));
+		}
+	}
+
+	const chipProfile_t *chipDatabase_t::find(const uint8_t manufacturer, const uint8_t deviceType,
+		const uint32_t capacity) const noexcept
+	{
+		for (const auto &chip : chips)
+		{
+			if (chip.manufacturer == manufacturer && chip.deviceType == deviceType && chip.capacity == capacity)
+				return &chip;
+		}
+		return nullptr;
+	}
+
+	// The user's additions live in $XDG_CONFIG_HOME/flashprog/chips.db, or ~/.config/flashprog/chips.db
+	static std::optional<std::filesystem::path> userDatabasePath() noexcept
+	{
+		if (const auto *const configHome{std::getenv("XDG_CONFIG_HOME")}; configHome && *configHome)
+			return std::filesystem::path{configHome} / "flashprog" / "chips.db";
+		if (const auto *const home{std::getenv("HOME")}; home && *home)
+			return std::filesystem::path{home} / ".config" / "flashprog" / "chips.db";
+		return std::nullopt;
+	}
+
+	chipDatabase_t loadDatabase()
+	{
+		// The built-in database is checked as part of building flashprog, so this should never fail
+		auto database{chipDatabase_t::parse(builtinDatabase, "built-in chip database"sv).value_or(chipDatabase_t{})};
+		const auto path{userDatabasePath()};
+		std::error_code error{};
+		if (!path || !std::filesystem::exists(*path, error))
+			return database;
+
+		const substrate::fd_t file{*path, O_RDONLY | O_NOCTTY};
+		const auto length{file.valid() ? file.length() : -1};
+		std::string text(length > 0 ? static_cast<size_t>(length) : 0U, '\0');
+		if (length < 0 || !file.read(text.data(), text.size()))
+		{
+			console.warning("Could not read chip database "sv, path->u8string());
+			return database;
+		}
+		auto userDatabase{chipDatabase_t::parse(text, path->u8string())};
+		if (userDatabase)
+			database.merge(std::move(*userDatabase));
+		else
+			console.warning("Ignoring chip database "sv, path->u8string(), " as it contains errors"sv);
+		return database;
+	}
+
+	// Pick the erase type the programmer erases pages with, by the page size it says it erases in
+	static void resolvePageErase(chipProfile_t &profile, const uint32_t eraseSize) noexcept
+	{
+		const auto eraseType
+		{
+			std::find_if(profile.eraseTypes.begin(), profile.eraseTypes.end(),
+				[&](const eraseType_t &erase) { return erase.size == eraseSize; })
+		};
+		if (eraseType != profile.eraseTypes.end() && eraseType->time.typical != 0us)
+			profile.pageErase = *eraseType;
+		else
+			profile.pageErase = {0U, eraseSize, unknownPageErase};
+	}
+
+	chipProfile_t profileFor(const chipDatabase_t &database, const flashProto::responses::listDevice_t &chipInfo)
+	{
+		const auto *const chip{database.find(chipInfo.manufacturer, chipInfo.deviceType, chipInfo.deviceSize)};
+		auto profile
+		{
+			[&]() -> chipProfile_t
+			{
+				if (chip)
+					return *chip;
+				chipProfile_t unknown{};
+				unknown.manufacturer = chipInfo.manufacturer;
+				unknown.deviceType = chipInfo.deviceType;
+				unknown.capacity = chipInfo.deviceSize;
+				unknown.pageSize = chipInfo.pageSize;
+				return unknown;
+			}()
+		};
+		if (!profile.chipErase)
+			profile.chipErase = {chipEraseOpcode, 0U, unknownChipErase};
+		profile.chipErase->size = profile.capacity;
+		resolvePageErase(profile, chipInfo.eraseSize);
+		return profile;
+	}
+
+	void mergeSFDP(chipProfile_t &profile, const chipProfile_t &sfdpProfile)
+	{
+		for (const auto &sfdpErase : sfdpProfile.eraseTypes)
+		{
+			const auto eraseType
+			{
+				std::find_if(profile.eraseTypes.begin(), profile.eraseTypes.end(),
+					[&](const eraseType_t &erase) { return erase.opcode == sfdpErase.opcode; })
+			};
+			if (eraseType == profile.eraseTypes.end())
+				profile.eraseTypes.push_back(sfdpErase);
+			else if (eraseType->time.typical == 0us)
+				eraseType->time = sfdpErase.time;
+		}
+		if (profile.pageProgram.typical == 0us)
+			profile.pageProgram = sfdpProfile.pageProgram;
+		if (!profile.known && sfdpProfile.chipErase && sfdpProfile.chipErase->time.typical != 0us)
+			profile.chipErase->time = sfdpProfile.chipErase->time;
+		if (!profile.pageSize)
+			profile.pageSize = sfdpProfile.pageSize;
+		if (profile.pageErase.opcode == 0U)
+			resolvePageErase(profile, profile.pageErase.size);
+	}
+
+	std::string formatTime(const microseconds time)
+	{
+		const auto count{static_cast<double>(time.count())};
+		if (time < 1ms)
+			return fmt::format("{}us", time.count());
+		if (time < 1s)
+			return fmt::format("{:g}ms", std::round(count / 100.0) / 10.0);
+		return fmt::format("{:g}s", std::round(count / 100'000.0) / 10.0);
+	}
+
+	std::string formatTiming(const timing_t &timing)
+	{
+		if (timing.maximum == 0us)
+			return formatTime(timing.typical);
+		return fmt::format("{} (at most {})", formatTime(timing.typical), formatTime(timing.maximum));
+	}
+
+	void chipProfile_t::display() const noexcept try
+	{
+		if (!known)
+			return;
+		for (const auto &erase : eraseTypes)
+		{
+			const auto [sizeValue, sizeUnits] = humanReadableSize(erase.size);
+			console.info("\t\tErase "sv, sizeValue, sizeUnits, " - "sv, formatTiming(erase.time));
+		}
+		if (chipErase && chipErase->time.maximum != 0us)
+			console.info("\t\tChip erase - "sv, formatTiming(chipErase->time));
+		console.info("\t\tPage program - "sv, formatTiming(pageProgram));
+		if (capacity > threeByteAddressLimit && !hasQuirk(quirk_t::pageAddressed))
+			console.info("\t\tAddressing - "sv, hasQuirk(quirk_t::enter4ByteMode) ?
+				"switched into 4-byte mode"sv : "4-byte address instructions"sv);
+		console.info("\t\tRated clock - "sv, readMHz, "MHz"sv,
+			fastReadMHz ? fmt::format(", {}MHz fast read", fastReadMHz) : std::string{});
+	}
+	catch (const std::exception &)
+	{
+		return;
+	}
+} // namespace flashprog::chipDB
@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#ifndef CHIP_DB_CHIP_DATABASE_HXX
+#define CHIP_DB_CHIP_DATABASE_HXX
+
+#include <cstdint>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include "usbProtocol.hxx"
+
+namespace flashprog::chipDB
+{
+	using std::chrono::microseconds;
+
+	// How long an operation on a chip typically takes, and the most it may take. A maximum of 0 means unknown.
+	struct timing_t final
+	{
+		microseconds typical{};
+		microseconds maximum{};
+	};
+
+	struct eraseType_t final
+	{
+		uint8_t opcode{};
+		uint32_t size{};
+		timing_t time{};
+
+		/*!
+		 * How often to ask the programmer whether an erase of this type has finished - often enough to notice
+		 * it not long after it typically would, without flooding the programmer with status requests
+		 */
+		[[nodiscard]] microseconds pollInterval() const noexcept;
+	};
+
+	enum class quirk_t : uint8_t
+	{
+		// The chip is a NAND read and written through its page buffer
+		pageAddressed = 1U << 0U,
+		// The chip can run a read on across its pages, so only needs addressing at the start of one
+		continuousRead = 1U << 1U,
+		// The chip has no dedicated 4-byte address instructions, so must be switched into 4-byte addressing
+		enter4ByteMode = 1U << 2U,
+	};
+
+	struct chipProfile_t final
+	{
+		std::string name{};
+		uint8_t manufacturer{};
+		uint8_t deviceType{};
+		uint8_t capacityID{};
+		uint32_t capacity{};
+		uint32_t pageSize{};
+		// Every erase instruction the chip supports, the first being the one the programmer erases pages with
+		std::vector<eraseType_t> eraseTypes{};
+		std::optional<eraseType_t> chipErase{};
+		timing_t pageProgram{};
+		uint16_t readMHz{};
+		uint16_t fastReadMHz{};
+		uint8_t quirks{};
+		// The erase instruction the programmer actually erases pages of this chip with
+		eraseType_t pageErase{};
+		// Whether the chip was found in the database, or this profile was put together from what the programmer
+		// and the chip's SFDP data say with conservative defaults for the rest
+		bool known{false};
+
+		[[nodiscard]] bool hasQuirk(const quirk_t quirk) const noexcept { return quirks & uint8_t(quirk); }
+		void display() const noexcept;
+	};
+
+	struct chipDatabase_t final
+	{
+	private:
+		std::vector<chipProfile_t> chips{};
+
+	public:
+		// Parse the text of a database, reporting any problems found in it against the name of where it came from
+		[[nodiscard]] static std::optional<chipDatabase_t> parse(std::string_view text, std::string_view source);
+		// Add the chips from another database, its entries replacing any for the same chips in this one
+		void merge(chipDatabase_t &&other);
+		[[nodiscard]] const chipProfile_t *find(uint8_t manufacturer, uint8_t deviceType,
+			uint32_t capacity) const noexcept;
+		[[nodiscard]] size_t size() const noexcept { return chips.size(); }
+	};
+
+	// Load the database built into flashprog, along with the user's additions to it if they have any
+	[[nodiscard]] chipDatabase_t loadDatabase();
+	/*!
+	 * Work out the profile for a chip from what the programmer reported for it. Chips not in the database
+	 * get a profile of the geometry the programmer gave and conservative timings.
+	 */
+	[[nodiscard]] chipProfile_t profileFor(const chipDatabase_t &database, const flashProto::responses::listDevice_t &chipInfo);
+	// Fill in what the database doesn't know about a chip from its SFDP data
+	void mergeSFDP(chipProfile_t &profile, const chipProfile_t &sfdpProfile);
+	[[nodiscard]] std::string formatTime(microseconds time);
+	// Format a timing as its typical time, along with its maximum if that's known
+	[[nodiscard]] std::string formatTiming(const timing_t &timing);
+} // namespace flashprog::chipDB
+
+#endif /*CHIP_DB_CHIP_DATABASE_HXX*/
@@ -0,0 +1,177 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#include <cstring>
+#include <algorithm>
+#include <thread>
+#include <substrate/fd>
+#include <substrate/console>
+#include "flashModel.hxx"
+
+using namespace std::literals::string_view_literals;
+using substrate::console;
+
+namespace flashprog::emulator
+{
+	constexpr static uint32_t sfdpTableAddress{0x10U};
+	constexpr static size_t basicTableLength{16U};
+	// The deep power down instructions of the modelled parts
+	constexpr static uint8_t powerDownOpcode{0xB9U};
+	constexpr static uint8_t wakeUpOpcode{0xABU};
+
+	// DWord 14 of the basic parameter table gives the enter instruction in bits 30:23, and the exit one in bits 22:15
+	constexpr static uint32_t powerDownDWord(const uint8_t enterOpcode, const uint8_t exitOpcode) noexcept
+		{ return (uint32_t{enterOpcode} << 23U) | (uint32_t{exitOpcode} << 15U); }
+	static_assert(((powerDownDWord(powerDownOpcode, wakeUpOpcode) >> 23U) & 0xFFU) == powerDownOpcode);
+	static_assert(((powerDownDWord(powerDownOpcode, wakeUpOpcode) >> 15U) & 0xFFU) == wakeUpOpcode);
+
+	static uint8_t log2(uint32_t value) noexcept
+	{
+		uint8_t result{};
+		while (value >>= 1U)
+			++result;
+		return result;
+	}
+
+	flashModel_t::flashModel_t(const flashGeometry_t &geometry, const flashTimings_t &timings) :
+		geometry_{geometry}, timings_{timings}, contents_(geometry.size, 0xFFU)
+		{ buildSFDP(); }
+
+	flashModel_t::~flashModel_t() noexcept
+	{
+		// If we have a backing file, write the final state of the device back out to it
+		if (backingFile_.empty() || contents_.empty())
+			return;
+		const substrate::fd_t file{backingFile_, O_WRONLY | O_CREAT | O_TRUNC | O_NOCTTY, substrate::normalMode};
+		if (!file.valid() ||
+			!file.write(contents_.data(), contents_.size()))
+			console.error("Failed to write emulated Flash contents back to '"sv, backingFile_.u8string(), "'"sv);
+	}
+
+	bool flashModel_t::attachBackingFile(const std::filesystem::path &fileName) noexcept
+	{
+		backingFile_ = fileName;
+		// A backing file that does not yet exist is equivalent to a freshly erased device
+		if (!std::filesystem::exists(fileName))
+			return true;
+		const substrate::fd_t file{fileName, O_RDONLY | O_NOCTTY};
+		if (!file.valid())
+			return false;
+		if (file.length() != static_cast<substrate::off_t>(contents_.size()))
+		{
+			console.error("Emulated Flash backing file '"sv, fileName.u8string(), "' is not "sv,
+				contents_.size(), " bytes long"sv);
+			return false;
+		}
+		return file.read(contents_.data(), contents_.size());
+	}
+
+	// Build a JESD216B compatible SFDP block consisting of the header, a single parameter
+	// header and the basic parameter table which describes the modeled device.
+	void flashModel_t::buildSFDP()
+	{
+		sfdp_.assign(sfdpTableAddress + (basicTableLength * 4U), 0U);
+		const auto writeDWord
+		{
+			[this](const size_t offset, const uint32_t value)
+			{
+				for (size_t byte{}; byte < 4U; ++byte)
+					sfdp_[offset + byte] = uint8_t(value >> (byte * 8U));
+			}
+		};
+
+		// SFDP header: signature, v1.6, 1 parameter header, legacy access protocol
+		writeDWord(0x00U, 0x50444653U);
+		writeDWord(0x04U, 0xFF000106U);
+		// Basic parameter table header: ID 0xFF00, v1.6, 16 DWords long at sfdpTableAddress
+		writeDWord(0x08U, 0x10010600U);
+		writeDWord(0x0CU, 0xFF000000U | sfdpTableAddress);
+
+		const auto fourKiBErase{geometry_.eraseSize == 4096U};
+		const auto needs4ByteAddressing{geometry_.size > (1U << 24U)};
+		const auto table{size_t{sfdpTableAddress}};
+		// DWord 1: erase granularity, write granularity, 4KiB erase opcode, address bytes
+		writeDWord(table + 0x00U, 0xFF000000U |
+			(needs4ByteAddressing ? 0x00020000U : 0x00000000U) |
+			(fourKiBErase ? 0x00002000U | 0xE5U : 0x0000FF00U | 0xE7U));
+		// DWord 2: memory density in bits
+		writeDWord(table + 0x04U, (geometry_.size * 8U) - 1U);
+		// DWord 8 and 9: erase types - list the device's native erase first, and the 64KiB block erase second
+		writeDWord(table + 0x1CU, 0xD8100000U | (uint32_t{geometry_.eraseOpcode} << 8U) |
+			log2(geometry_.eraseSize));
+		// DWord 11: page size
+		writeDWord(table + 0x28U, uint32_t(log2(geometry_.pageSize)) << 4U);
+		// DWord 14: deep power down and wake up opcodes
+		writeDWord(table + 0x34U, powerDownDWord(powerDownOpcode, wakeUpOpcode));
+	}
+
+	void flashModel_t::waitReady() noexcept
+		{ std::this_thread::sleep_until(busyUntil_); }
+
+	void flashModel_t::clockBytes(const size_t count) noexcept
+	{
+		// Accumulate the time spent shifting bytes over the bus, and only actually spend that time
+		// when it adds up to something the scheduler can do something sensible with.
+		busTime_ += std::chrono::nanoseconds{(uint64_t{count} * 8U * 1'000'000'000U) / timings_.clockFrequency};
+		if (busTime_ >= 1ms)
+		{
+			std::this_thread::sleep_for(busTime_);
+			busTime_ = {};
+		}
+	}
+
+	void flashModel_t::read(const uint32_t address, void *const buffer, const size_t length) noexcept
+	{
+		clockBytes(length);
+		auto *const data{static_cast<uint8_t *>(buffer)};
+		// Reads wrap at the end of the device just as they do on real parts
+		for (size_t offset{}; offset < length; ++offset)
+			data[offset] = contents_[(address + offset) % contents_.size()];
+	}
+
+	void flashModel_t::readSFDP(const uint32_t address, void *const buffer, const size_t length) noexcept
+	{
+		clockBytes(length);
+		auto *const data{static_cast<uint8_t *>(buffer)};
+		for (size_t offset{}; offset < length; ++offset)
+		{
+			const auto sfdpAddress{address + offset};
+			data[offset] = sfdpAddress < sfdp_.size() ? sfdp_[sfdpAddress] : 0xFFU;
+		}
+	}
+
+	bool flashModel_t::program(const uint32_t address, const void *const buffer, const size_t length) noexcept
+	{
+		if (address >= contents_.size() || length > geometry_.pageSize)
+			return false;
+		waitReady();
+		clockBytes(length);
+		const auto *const data{static_cast<const uint8_t *>(buffer)};
+		const auto pageBase{address & ~(geometry_.pageSize - 1U)};
+		// Programming can only clear bits, and wraps within the page being programmed
+		for (size_t offset{}; offset < length; ++offset)
+			contents_[pageBase + ((address - pageBase + offset) % geometry_.pageSize)] &= data[offset];
+		busyUntil_ = steadyClock_t::now() + timings_.pageProgram;
+		return true;
+	}
+
+	bool flashModel_t::eraseSector(const uint32_t sector) noexcept
+	{
+		const auto address{size_t{sector} * geometry_.eraseSize};
+		if (address >= contents_.size())
+			return false;
+		const auto begin{contents_.begin() + static_cast<std::ptrdiff_t>(address)};
+		std::fill(begin, begin + geometry_.eraseSize, 0xFFU);
+		queueBusy(timings_.sectorErase);
+		return true;
+	}
+
+	void flashModel_t::eraseChip() noexcept
+	{
+		std::fill(contents_.begin(), contents_.end(), 0xFFU);
+		queueBusy(timings_.chipErase);
+	}
+
+	// Erases are queued back to back after whatever the device is already doing rather than
+	// waited for, so the erase state machine can poll for their completion as on real hardware.
+	void flashModel_t::queueBusy(const std::chrono::nanoseconds duration) noexcept
+		{ busyUntil_ = std::max(steadyClock_t::now(), busyUntil_) + duration; }
+} // namespace flashprog::emulator
@@ -0,0 +1,84 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#ifndef EMULATOR_FLASH_MODEL_HXX
+#define EMULATOR_FLASH_MODEL_HXX
+
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+#include <vector>
+#include <filesystem>
+
+namespace flashprog::emulator
+{
+	using namespace std::literals::chrono_literals;
+	using steadyClock_t = std::chrono::steady_clock;
+
+	struct flashGeometry_t
+	{
+		uint8_t manufacturer{};
+		uint8_t type{};
+		uint8_t capacity{};
+		uint8_t eraseOpcode{};
+		uint32_t size{};
+		uint32_t pageSize{};
+		uint32_t eraseSize{};
+	};
+
+	struct flashTimings_t
+	{
+		// Time taken to program a single page
+		std::chrono::microseconds pageProgram{700us};
+		// Time taken to erase a single erase page (sector)
+		std::chrono::microseconds sectorErase{45ms};
+		// Time taken to erase the whole device
+		std::chrono::milliseconds chipErase{20s};
+		// The SPI clock the device is being run at, in Hz
+		uint32_t clockFrequency{40'000'000U};
+	};
+
+	/*!
+	 * Models a 25-series SPI Flash device in memory. All time-consuming operations
+	 * mark the device busy until they would have completed on real hardware, and the
+	 * time taken to shift data over the SPI bus is accounted for too so that the
+	 * emulated programmer achieves a realistic throughput.
+	 */
+	struct flashModel_t final
+	{
+	private:
+		flashGeometry_t geometry_;
+		flashTimings_t timings_;
+		std::vector<uint8_t> contents_;
+		std::vector<uint8_t> sfdp_{};
+		steadyClock_t::time_point busyUntil_{};
+		std::chrono::nanoseconds busTime_{};
+		std::filesystem::path backingFile_{};
+
+		void buildSFDP();
+		void queueBusy(std::chrono::nanoseconds duration) noexcept;
+
+	public:
+		flashModel_t(const flashGeometry_t &geometry, const flashTimings_t &timings);
+		flashModel_t(const flashModel_t &) = delete;
+		flashModel_t(flashModel_t &&) = default;
+		flashModel_t &operator =(const flashModel_t &) = delete;
+		flashModel_t &operator =(flashModel_t &&) = default;
+		~flashModel_t() noexcept;
+
+		[[nodiscard]] bool attachBackingFile(const std::filesystem::path &fileName) noexcept;
+
+		[[nodiscard]] const flashGeometry_t &geometry() const noexcept { return geometry_; }
+		[[nodiscard]] const flashTimings_t &timings() const noexcept { return timings_; }
+		[[nodiscard]] bool busy() const noexcept { return steadyClock_t::now() < busyUntil_; }
+		[[nodiscard]] steadyClock_t::time_point busyUntil() const noexcept { return busyUntil_; }
+		void waitReady() noexcept;
+		void clockBytes(size_t count) noexcept;
+
+		void read(uint32_t address, void *buffer, size_t length) noexcept;
+		void readSFDP(uint32_t address, void *buffer, size_t length) noexcept;
+		[[nodiscard]] bool program(uint32_t address, const void *buffer, size_t length) noexcept;
+		[[nodiscard]] bool eraseSector(uint32_t sector) noexcept;
+		void eraseChip() noexcept;
+	};
+} // namespace flashprog::emulator
+
+#endif /*EMULATOR_FLASH_MODEL_HXX*/
@@ -0,0 +1,819 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <substrate/console>
+#include <substrate/utility>
+#include <substrate/units>
+#include "crc32.hxx"
+#include "programmer.hxx"
+
+using namespace std::literals::string_view_literals;
+using namespace substrate;
+using namespace flashProto;
+
+namespace flashprog::emulator
+{
+	constexpr static uint16_t maxTransferLength{4096U};
+	constexpr static uint16_t defaultTransferLength{256U};
+	constexpr static uint8_t dataInEndpoint{endpointAddress(endpointDir_t::controllerIn, 1)};
+	constexpr static uint8_t dataOutEndpoint{endpointAddress(endpointDir_t::controllerOut, 1)};
+	// The SSI clock is divided down from the programmer's 80MHz system clock, and can run at half that at most
+	constexpr static uint32_t systemClockKHz{80'000U};
+	constexpr static uint32_t maximumClockKHz{40'000U};
+
+	// The on-board chips are AT25SF641's
+	flashGeometry_t internalFlashGeometry() noexcept
+		{ return {0x1FU, 0x32U, 0x17U, 0x20U, 8_MiB, 256U, 4_KiB}; }
+
+	// Emulate a W25Q128JV on the target bus as it's a very typical part to find there
+	flashGeometry_t externalFlashGeometry() noexcept
+		{ return {0xEFU, 0x40U, 0x18U, 0x20U, 16_MiB, 256U, 4_KiB}; }
+
+	constexpr static flashTimings_t internalFlashTimings{700us, 60ms, 30s, 40'000'000U};
+	constexpr static flashTimings_t externalFlashTimings{700us, 45ms, 40s, 40'000'000U};
+
+	/*!
+	 * Erases take as long as on the real parts, tens of seconds for a whole chip, which makes test runs very slow.
+	 * FLASHPROG_EMULATOR_ERASE_SCALE can be set to a fraction from 0 to 1 to scale the erase times down by.
+	 */
+	static flashTimings_t emulatedTimings(flashTimings_t timings) noexcept
+	{
+		const auto *const scaleValue{std::getenv("FLASHPROG_EMULATOR_ERASE_SCALE")};
+		if (!scaleValue || !*scaleValue)
+			return timings;
+		char *end{};
+		const auto scale{std::strtod(scaleValue, &end)};
+		if (*end || !(scale >= 0.0 && scale <= 1.0))
+		{
+			console.warning("Ignoring invalid FLASHPROG_EMULATOR_ERASE_SCALE '"sv, scaleValue, "'"sv);
+			return timings;
+		}
+		timings.sectorErase = std::chrono::duration_cast<std::chrono::microseconds>(timings.sectorErase * scale);
+		timings.chipErase = std::chrono::duration_cast<std::chrono::milliseconds>(timings.chipErase * scale);
+		return timings;
+	}
+
+	programmer_t::programmer_t(std::optional<flashModel_t> &&externalChip) :
+		internalChips_
+		{{
+			{internalFlashGeometry(), emulatedTimings(internalFlashTimings)},
+			{internalFlashGeometry(), emulatedTimings(internalFlashTimings)},
+		}}, externalChip_{std::move(externalChip)} { }
+
+	bool programmer_t::claimInterface(const int32_t interfaceNumber) noexcept
+	{
+		if (interfaceNumber != 0 || claimed_)
+		{
+			console.error("Failed to claim interface "sv, interfaceNumber, ": emulated interface busy"sv);
+			return false;
+		}
+		claimed_ = true;
+		return true;
+	}
+
+	bool programmer_t::releaseInterface(const int32_t interfaceNumber) noexcept
+	{
+		if (interfaceNumber != 0 || !claimed_)
+		{
+			console.error("Failed to release interface "sv, interfaceNumber, ": interface not claimed"sv);
+			return false;
+		}
+		claimed_ = false;
+		return true;
+	}
+
+	// The programmer does not make use of its interrupt endpoints
+	bool programmer_t::interruptTransfer(const uint8_t endpoint, void *const, const int32_t bufferLen) noexcept
+	{
+		console.error("Failed to complete interrupt transfer of "sv, bufferLen,
+			" byte(s) to endpoint "sv, endpoint & 0x7FU, ", reason: emulated endpoint stalled"sv);
+		return false;
+	}
+
+	bool programmer_t::bulkTransfer(const uint8_t endpoint, void *const bufferPtr, const int32_t bufferLen) noexcept
+	{
+		const auto result
+		{
+			[&]()
+			{
+				if (endpoint == dataInEndpoint)
+					return performRead(bufferPtr, bufferLen);
+				if (endpoint == dataOutEndpoint)
+					return performWrite(bufferPtr, bufferLen);
+				return false;
+			}()
+		};
+		if (!result)
+		{
+			const auto direction{endpointDir_t(endpoint & 0x80U)};
+			console.error("Failed to complete bulk transfer of "sv, bufferLen,
+				" byte(s) to endpoint "sv, endpoint & 0x7FU, ' ',
+				direction == endpointDir_t::controllerIn ? "IN"sv : "OUT"sv,
+				", reason: emulated endpoint stalled"sv);
+		}
+		return result;
+	}
+
+	bool programmer_t::controlTransfer(const requestType_t requestType, const uint8_t request, const uint16_t value,
+		const uint16_t index, void *const bufferPtr, const uint16_t bufferLen) noexcept
+	{
+		const auto result
+		{
+			[&]()
+			{
+				if (!claimed_ ||
+					requestType.recipient() != recipient_t::interface ||
+					requestType.type() != request_t::typeClass ||
+					index != 0)
+					return false;
+
+				const auto dirIn{requestType.dir() == endpointDir_t::controllerIn};
+				switch (static_cast<messages_t>(request))
+				{
+					case messages_t::deviceCount:
+					{
+						if (!dirIn || bufferLen != sizeof(responses::deviceCount_t))
+							return false;
+						responses::deviceCount_t deviceCount{};
+						deviceCount.internalCount = uint8_t(internalChips_.size());
+						deviceCount.externalCount = externalChip_ ? 1U : 0U;
+						std::memcpy(bufferPtr, &deviceCount, sizeof(deviceCount));
+						return true;
+					}
+					case messages_t::listDevice:
+						return dirIn && listDevice(value, bufferPtr, bufferLen);
+					case messages_t::targetDevice:
+						return !dirIn && targetDevice(value);
+					case messages_t::erase:
+						return !dirIn && erase(value, bufferPtr, bufferLen);
+					case messages_t::read:
+						return !dirIn && setupRead(value, bufferPtr, bufferLen);
+					case messages_t::write:
+					case messages_t::verifiedWrite:
+						return !dirIn &&
+							setupWrite(value, static_cast<messages_t>(request) == messages_t::verifiedWrite,
+								bufferPtr, bufferLen);
+					case messages_t::resetTarget:
+						return !dirIn;
+					case messages_t::status:
+						return dirIn && readStatus(bufferPtr, bufferLen);
+					case messages_t::abort:
+						if (dirIn)
+							return false;
+						abort();
+						return true;
+					case messages_t::sfdp:
+						return !dirIn && setupSFDPRead(value, bufferPtr, bufferLen);
+					case messages_t::readRange:
+						return !dirIn && setupReadRange(bufferPtr, bufferLen);
+					case messages_t::stats:
+						// There's no cycle counting to be done here, so only the event counters are reported
+						if (!dirIn || bufferLen != sizeof(stats_))
+							return false;
+						std::memcpy(bufferPtr, &stats_, sizeof(stats_));
+						if (value)
+							stats_ = {};
+						return true;
+					case messages_t::events:
+					{
+						// The emulator keeps no event log, so it's always empty
+						if (!dirIn || bufferLen != sizeof(responses::events_t))
+							return false;
+						const responses::events_t events{};
+						std::memcpy(bufferPtr, &events, sizeof(events));
+						return true;
+					}
+					case messages_t::benchmark:
+					{
+						// There's no SPI bus to time here, so report a benchmark without cycle counts
+						if (!dirIn || bufferLen != sizeof(responses::benchmark_t) || !target_)
+							return false;
+						responses::benchmark_t result{};
+						result.match = 1U;
+						std::memcpy(bufferPtr, &result, sizeof(result));
+						return true;
+					}
+					case messages_t::busClock:
+						return busClock(dirIn, value, bufferPtr, bufferLen);
+					case messages_t::fill:
+						return fill(dirIn, bufferPtr, bufferLen);
+					case messages_t::blankCheck:
+						return blankCheck(dirIn, bufferPtr, bufferLen);
+					case messages_t::compressedWrite:
+						return !dirIn && setupCompressedWrite(value, bufferPtr, bufferLen);
+					case messages_t::compressedRead:
+						return !dirIn && setupCompressedRead(bufferPtr, bufferLen);
+					case messages_t::uniqueID:
+						return dirIn && uniqueID(bufferPtr, bufferLen);
+					case messages_t::checksum:
+						return checksum(dirIn, bufferPtr, bufferLen);
+					case messages_t::badBlocks:
+						return badBlocks(dirIn, bufferPtr, bufferLen);
+				}
+				return false;
+			}()
+		};
+		if (!result)
+			console.error("Failed to complete control transfer of "sv, bufferLen,
+				" bytes(s), reason: emulated request "sv, request, " stalled"sv);
+		return result;
+	}
+
+	flashModel_t *programmer_t::findChip(const flashBus_t bus, const uint8_t number) noexcept
+	{
+		if (bus == flashBus_t::internal && number < internalChips_.size())
+			return &internalChips_[number];
+		if (bus == flashBus_t::external && number == 0 && externalChip_)
+			return &*externalChip_;
+		return nullptr;
+	}
+
+	bool programmer_t::listDevice(const uint16_t value, void *const buffer, const uint16_t length) noexcept
+	{
+		if (length != sizeof(responses::listDevice_t))
+			return false;
+		responses::listDevice_t device{};
+		// Just like the firmware, a request for a non-existant device yields an all-0 response
+		if (const auto *const chip{findChip(static_cast<flashBus_t>(value >> 8U), uint8_t(value))}; chip)
+		{
+			const auto &geometry{chip->geometry()};
+			device.manufacturer = geometry.manufacturer;
+			device.deviceType = geometry.type;
+			device.deviceSize = geometry.size;
+			device.pageSize = geometry.pageSize;
+			device.eraseSize = geometry.eraseSize;
+		}
+		std::memcpy(buffer, &device, sizeof(device));
+		return true;
+	}
+
+	bool programmer_t::targetDevice(const uint16_t value) noexcept
+	{
+		const auto bus{static_cast<flashBus_t>(value >> 8U)};
+		if (bus > flashBus_t::unknown)
+			return false;
+		busClock_ = {};
+		badBlocks_ = {};
+		if (bus == flashBus_t::unknown)
+		{
+			target_ = nullptr;
+			return true;
+		}
+		target_ = findChip(bus, uint8_t(value));
+		// The emulated external chip always trains to the fastest clock, backed off one step as the firmware does
+		if (target_ && bus == flashBus_t::external)
+		{
+			busClock_.ratedKHz = maximumClockKHz;
+			busClock_.fastestKHz = maximumClockKHz;
+			busClock_.trainedKHz = maximumClockKHz / 2U;
+			busClock_.currentKHz = busClock_.trainedKHz;
+		}
+		return target_;
+	}
+
+	bool programmer_t::busClock(const bool dirIn, const uint16_t value, void *const buffer, const uint16_t length) noexcept
+	{
+		if (dirIn)
+		{
+			if (length != sizeof(busClock_))
+				return false;
+			std::memcpy(buffer, &busClock_, sizeof(busClock_));
+			return true;
+		}
+		// Only the external bus has its clock trained, so only it can be overridden
+		if (!busClock_.trainedKHz)
+			return false;
+		const uint32_t clockKHz{value ? value : busClock_.trainedKHz};
+		// Mirror the firmware's choice of the fastest even divider of 80MHz no faster than requested
+		auto divider{(systemClockKHz + clockKHz - 1U) / clockKHz};
+		divider = std::clamp(divider + (divider & 1U), 2U, 254U);
+		busClock_.currentKHz = systemClockKHz / divider;
+		busClock_.overridden = value ? 1U : 0U;
+		return true;
+	}
+
+	bool programmer_t::fill(const bool dirIn, void *const buffer, const uint16_t length) noexcept
+	{
+		if (dirIn)
+		{
+			if (length != sizeof(fillStatus_))
+				return false;
+			std::memcpy(buffer, &fillStatus_, sizeof(fillStatus_));
+			return true;
+		}
+		requests::fill_t fillConfig{};
+		if (length != sizeof(fillConfig))
+			return false;
+		fillStatus_ = {};
+		fillStatus_.writeOK = true;
+		if (!target_ || eraseOperation_ != eraseOperation_t::idle)
+		{
+			fillStatus_.complete = 2;
+			return false;
+		}
+		std::memcpy(&fillConfig, buffer, sizeof(fillConfig));
+
+		const auto &geometry{target_->geometry()};
+		// Just like the firmware, a fill that can't be done fails once started
+		if (!fillConfig.patternLength || fillConfig.patternLength > requests::maxFillPattern ||
+			!fillConfig.length || fillConfig.address >= geometry.size ||
+			fillConfig.length > geometry.size - fillConfig.address)
+		{
+			fillStatus_.complete = 3;
+			return true;
+		}
+
+		// Generate and program the fill a page at a time as the firmware does
+		std::vector<uint8_t> page(geometry.pageSize);
+		while (fillStatus_.bytesWritten < fillConfig.length)
+		{
+			const auto offset{fillStatus_.bytesWritten};
+			const auto address{fillConfig.address + offset};
+			const auto amount{std::min(geometry.pageSize - (address & (geometry.pageSize - 1U)),
+				fillConfig.length - offset)};
+			for (uint32_t idx{}; idx < amount; ++idx)
+				page[idx] = fillConfig.pattern[(offset + idx) % fillConfig.patternLength];
+			if (!target_->program(address, page.data(), amount))
+			{
+				fillStatus_.complete = 3;
+				return true;
+			}
+			if (fillConfig.verify)
+			{
+				std::vector<uint8_t> readBack(amount);
+				target_->waitReady();
+				target_->read(address, readBack.data(), amount);
+				if (!std::equal(readBack.begin(), readBack.end(), page.begin()))
+					fillStatus_.writeOK = false;
+			}
+			fillStatus_.bytesWritten += amount;
+			stats_.bytesWritten += amount;
+			++stats_.pagesProgrammed;
+		}
+		fillStatus_.complete = 1;
+		return true;
+	}
+
+	bool programmer_t::blankCheck(const bool dirIn, void *const buffer, const uint16_t length) noexcept
+	{
+		if (dirIn)
+		{
+			if (length != sizeof(blankResult_))
+				return false;
+			std::memcpy(buffer, &blankResult_, sizeof(blankResult_));
+			return true;
+		}
+		requests::blankCheck_t blankConfig{};
+		if (length != sizeof(blankConfig))
+			return false;
+		blankResult_ = {};
+		if (!target_ || eraseOperation_ != eraseOperation_t::idle)
+		{
+			blankResult_.complete = 2;
+			return false;
+		}
+		std::memcpy(&blankConfig, buffer, sizeof(blankConfig));
+
+		const auto &geometry{target_->geometry()};
+		if (!blankConfig.length || blankConfig.address >= geometry.size ||
+			blankConfig.length > geometry.size - blankConfig.address)
+		{
+			blankResult_.complete = 3;
+			return true;
+		}
+
+		std::vector<uint8_t> data(blankConfig.length);
+		target_->waitReady();
+		target_->read(blankConfig.address, data.data(), data.size());
+		const auto isUsed{[](const uint8_t value) { return value != 0xFFU; }};
+		const auto first{std::find_if(data.begin(), data.end(), isUsed)};
+		blankResult_.bytesScanned = blankConfig.length;
+		blankResult_.blank = first == data.end();
+		if (!blankResult_.blank)
+		{
+			const auto last{std::find_if(data.rbegin(), data.rend(), isUsed)};
+			blankResult_.firstUsed = blankConfig.address + uint32_t(first - data.begin());
+			blankResult_.lastUsed = blankConfig.address + uint32_t(data.rend() - last) - 1U;
+		}
+		blankResult_.complete = 1;
+		return true;
+	}
+
+	bool programmer_t::uniqueID(void *const buffer, const uint16_t length) noexcept
+	{
+		if (length != sizeof(responses::uniqueID_t) || !target_ || eraseOperation_ != eraseOperation_t::idle)
+			return false;
+		// Give each emulated chip its own fixed ID, made from its JEDEC ID and which chip it is
+		const auto &geometry{target_->geometry()};
+		const auto external{externalChip_ && target_ == &*externalChip_};
+		const auto chipNumber{external ? uint8_t{0xFFU} : uint8_t(target_ - internalChips_.data())};
+		responses::uniqueID_t uniqueID{};
+		uniqueID.id = {{geometry.manufacturer, geometry.type, geometry.capacity, chipNumber, 0xE5U, 0x1AU, 0x7CU, 0x3DU}};
+		std::memcpy(buffer, &uniqueID, sizeof(uniqueID));
+		return true;
+	}
+
+	bool programmer_t::checksum(const bool dirIn, void *const buffer, const uint16_t length) noexcept
+	{
+		if (dirIn)
+		{
+			if (length != sizeof(checksumResult_))
+				return false;
+			std::memcpy(buffer, &checksumResult_, sizeof(checksumResult_));
+			return true;
+		}
+		requests::checksum_t checksumConfig{};
+		if (length != sizeof(checksumConfig))
+			return false;
+		checksumResult_ = {};
+		if (!target_ || eraseOperation_ != eraseOperation_t::idle)
+		{
+			checksumResult_.complete = 2;
+			return false;
+		}
+		std::memcpy(&checksumConfig, buffer, sizeof(checksumConfig));
+
+		const auto &geometry{target_->geometry()};
+		if (!checksumConfig.length || checksumConfig.address >= geometry.size ||
+			checksumConfig.length > geometry.size - checksumConfig.address)
+		{
+			checksumResult_.complete = 3;
+			return true;
+		}
+
+		std::vector<uint8_t> data(checksumConfig.length);
+		target_->waitReady();
+		target_->read(checksumConfig.address, data.data(), data.size());
+		checksumResult_.crc = checksum::crc32(data.data(), data.size());
+		checksumResult_.bytesScanned = checksumConfig.length;
+		checksumResult_.complete = 1;
+		return true;
+	}
+
+	bool programmer_t::badBlocks(const bool dirIn, void *const buffer, const uint16_t length) noexcept
+	{
+		if (dirIn)
+		{
+			if (length != sizeof(badBlocks_))
+				return false;
+			std::memcpy(buffer, &badBlocks_, sizeof(badBlocks_));
+			return true;
+		}
+		// The emulated chips are all NOR, so have no bad blocks to scan for
+		badBlocks_ = {};
+		badBlocks_.complete = target_ ? 3U : 2U;
+		return false;
+	}
+
+	bool programmer_t::erase(const uint16_t value, const void *const buffer, const uint16_t length) noexcept
+	{
+		const auto operation{uint8_t(value)};
+		if (operation >= static_cast<uint8_t>(eraseOperation_t::idle))
+			return false;
+		const auto multiRange{static_cast<eraseOperation_t>(operation) == eraseOperation_t::pageRanges};
+		if (length != (multiRange ? sizeof(requests::eraseRanges_t) : sizeof(requests::erase_t)))
+			return false;
+		if (!target_)
+		{
+			eraseOperation_ = eraseOperation_t::idle;
+			status_.eraseComplete = 2;
+			return false;
+		}
+		eraseRanges_ = {};
+		if (multiRange)
+			std::memcpy(&eraseRanges_, buffer, sizeof(eraseRanges_));
+		else
+		{
+			eraseRanges_.count = 1U;
+			std::memcpy(eraseRanges_.ranges.data(), buffer, sizeof(requests::erase_t));
+		}
+
+		status_.eraseComplete = 0;
+		status_.eraseRange = 0;
+		eraseOperation_ = static_cast<eraseOperation_t>(operation);
+		eraseStart_ = steadyClock_t::now();
+		switch (eraseOperation_)
+		{
+			case eraseOperation_t::all:
+				eraseRanges_ = {};
+				target_->eraseChip();
+				break;
+			case eraseOperation_t::page:
+				eraseRanges_.ranges[0].endPage = eraseRanges_.ranges[0].beginPage + 1;
+				[[fallthrough]];
+			case eraseOperation_t::pageRange:
+			case eraseOperation_t::pageRanges:
+				// Just like the firmware, a request with no or too many ranges fails once started
+				if (!eraseRanges_.count || eraseRanges_.count > requests::maxEraseRanges)
+				{
+					eraseOperation_ = eraseOperation_t::idle;
+					status_.eraseComplete = 3;
+					break;
+				}
+				for (uint8_t range{}; range < eraseRanges_.count; ++range)
+				{
+					const uint32_t endPage{eraseRanges_.ranges[range].endPage};
+					for (uint32_t page{eraseRanges_.ranges[range].beginPage}; page < endPage; ++page)
+					{
+						if (!target_->eraseSector(page))
+							break;
+						++stats_.sectorsErased;
+					}
+				}
+				break;
+			default:
+				break;
+		}
+		return true;
+	}
+
+	bool programmer_t::readStatus(void *const buffer, const uint16_t length) noexcept
+	{
+		if (length != sizeof(responses::status_t))
+			return false;
+		if (eraseOperation_ != eraseOperation_t::idle)
+		{
+			++stats_.busyPolls;
+			// Work out how far through the queued sector erases the device would have gotten
+			if (eraseOperation_ != eraseOperation_t::all && target_)
+			{
+				const auto elapsed{steadyClock_t::now() - eraseStart_};
+				auto sectorsErased{static_cast<uint32_t>(elapsed / target_->timings().sectorErase)};
+				for (uint8_t range{}; range < eraseRanges_.count; ++range)
+				{
+					const uint32_t beginPage{eraseRanges_.ranges[range].beginPage};
+					const uint32_t endPage{eraseRanges_.ranges[range].endPage};
+					const auto pages{endPage > beginPage ? endPage - beginPage : 0U};
+					status_.eraseRange = range;
+					status_.erasePage = beginPage + std::min(sectorsErased, pages);
+					if (sectorsErased < pages)
+						break;
+					sectorsErased -= pages;
+				}
+			}
+			status_.eraseComplete = target_ && target_->busy() ? 0 : 1;
+			if (status_.eraseComplete)
+				eraseOperation_ = eraseOperation_t::idle;
+		}
+		std::memcpy(buffer, &status_, sizeof(status_));
+		return true;
+	}
+
+	bool programmer_t::setupRead(const uint16_t count, const void *const buffer, const uint16_t length) noexcept
+	{
+		page_t page{};
+		if (count > maxTransferLength || length != sizeof(page) || !target_)
+			return false;
+		std::memcpy(&page, buffer, sizeof(page));
+		readSFDP_ = false;
+		readCompressed_ = false;
+		readAddress_ = page * target_->geometry().pageSize;
+		readCount_ = count ? count : defaultTransferLength;
+		return true;
+	}
+
+	bool programmer_t::setupSFDPRead(const uint16_t count, const void *const buffer, const uint16_t length) noexcept
+	{
+		uint32_t address{};
+		if (count > maxTransferLength || length != sizeof(address) || !target_)
+			return false;
+		std::memcpy(&address, buffer, sizeof(address));
+		readSFDP_ = true;
+		readCompressed_ = false;
+		readAddress_ = address;
+		readCount_ = count ? count : defaultTransferLength;
+		return true;
+	}
+
+	bool programmer_t::validRange(const uint32_t address, const uint32_t length) const noexcept
+	{
+		if (!target_)
+			return false;
+		const auto &geometry{target_->geometry()};
+		return length && address < geometry.size && length <= geometry.size - address;
+	}
+
+	bool programmer_t::setupReadRange(const void *const buffer, const uint16_t length) noexcept
+	{
+		requests::readRange_t readRange{};
+		if (length != sizeof(readRange))
+			return false;
+		std::memcpy(&readRange, buffer, sizeof(readRange));
+		readSFDP_ = false;
+		readCompressed_ = false;
+		// As with the firmware, a range that can't be read is accepted but flagged in the status area
+		status_.readOK = validRange(readRange.address, readRange.length);
+		readAddress_ = readRange.address;
+		readCount_ = status_.readOK ? readRange.length : 0U;
+		return true;
+	}
+
+	bool programmer_t::setupCompressedRead(const void *const buffer, const uint16_t length) noexcept
+	{
+		requests::compressedRead_t compressedRead{};
+		if (length != sizeof(compressedRead))
+			return false;
+		std::memcpy(&compressedRead, buffer, sizeof(compressedRead));
+		readSFDP_ = false;
+		readCompressed_ = true;
+		status_.readOK = validRange(compressedRead.address, compressedRead.length);
+		readAddress_ = compressedRead.address;
+		readCount_ = status_.readOK ? compressedRead.length : 0U;
+		readFrame_.clear();
+		readFrameOffset_ = 0;
+		return true;
+	}
+
+	// Read and encode the next block of a compressed read into a frame, as the firmware's nextReadFrame() does
+	void programmer_t::nextReadFrame() noexcept
+	{
+		const auto amount{std::min(readCount_, responses::compressedFrameBlock)};
+		std::vector<uint8_t> data(amount);
+		target_->read(readAddress_, data.data(), data.size());
+		readAddress_ += amount;
+		readCount_ -= amount;
+
+		constexpr auto headerLength{sizeof(responses::compressedFrame_t)};
+		readFrame_.assign(headerLength + amount + responses::compressedFrameAlignment, 0U);
+		auto encodedLength{readEncoder_.encode(data.data(), amount, readFrame_.data() + headerLength, amount - 1U)};
+		if (!encodedLength)
+		{
+			std::memcpy(readFrame_.data() + headerLength, data.data(), amount);
+			encodedLength = amount;
+		}
+		const responses::compressedFrame_t header{uint16_t(encodedLength), uint16_t(amount)};
+		std::memcpy(readFrame_.data(), &header, sizeof(header));
+		const auto alignment{responses::compressedFrameAlignment};
+		readFrame_.resize((headerLength + encodedLength + alignment - 1U) / alignment * alignment);
+		readFrameOffset_ = 0;
+		stats_.bytesRead += amount;
+		stats_.compressedBytesRead += amount;
+	}
+
+	// Data is read from the target as the host asks for it, just as the firmware streams it
+	bool programmer_t::performRead(void *const buffer, const int32_t length) noexcept
+	{
+		if (!target_ || length < 0)
+			return false;
+		if (readCompressed_)
+		{
+			auto *const data{static_cast<uint8_t *>(buffer)};
+			for (size_t offset{}; offset < size_t(length);)
+			{
+				if (readFrameOffset_ == readFrame_.size())
+				{
+					if (!readCount_)
+						return false;
+					nextReadFrame();
+				}
+				const auto amount{std::min(size_t(length) - offset, readFrame_.size() - readFrameOffset_)};
+				std::memcpy(data + offset, readFrame_.data() + readFrameOffset_, amount);
+				readFrameOffset_ += amount;
+				offset += amount;
+				stats_.compressedWireRead += uint32_t(amount);
+			}
+			return true;
+		}
+		if (uint32_t(length) > readCount_)
+			return false;
+		if (readSFDP_)
+			target_->readSFDP(readAddress_, buffer, size_t(length));
+		else
+			target_->read(readAddress_, buffer, size_t(length));
+		readAddress_ += uint32_t(length);
+		readCount_ -= uint32_t(length);
+		stats_.bytesRead += uint32_t(length);
+		return true;
+	}
+
+	bool programmer_t::setupWrite(const uint16_t count, const bool verify, const void *const buffer,
+		const uint16_t length) noexcept
+	{
+		page_t page{};
+		if (count > maxTransferLength || length != sizeof(page))
+			return false;
+		std::memcpy(&page, buffer, sizeof(page));
+		writeCount_ = count ? count : defaultTransferLength;
+		writeAddress_ = target_ ? page * target_->geometry().pageSize : 0U;
+		writeBuffer_.clear();
+		writeDecodedLength_.reset();
+		verifyWrite_ = verify;
+		status_.writeOK = true;
+		return true;
+	}
+
+	bool programmer_t::setupCompressedWrite(const uint16_t count, const void *const buffer,
+		const uint16_t length) noexcept
+	{
+		requests::compressedWrite_t compressedWrite{};
+		if (!count || length != sizeof(compressedWrite))
+			return false;
+		std::memcpy(&compressedWrite, buffer, sizeof(compressedWrite));
+		writeCount_ = count;
+		writeAddress_ = target_ ? compressedWrite.page * target_->geometry().pageSize : 0U;
+		writeBuffer_.clear();
+		// Just like the firmware, a block that's too long fails once its data has been received
+		writeDecodedLength_ = compressedWrite.length;
+		verifyWrite_ = compressedWrite.verify;
+		status_.writeOK = compressedWrite.length && compressedWrite.length <= maxTransferLength;
+		return true;
+	}
+
+	bool programmer_t::performWrite(const void *const buffer, const int32_t length) noexcept
+	{
+		if (!target_ || length < 0 || writeBuffer_.size() + size_t(length) > writeCount_)
+			return false;
+		const auto *const data{static_cast<const uint8_t *>(buffer)};
+		writeBuffer_.insert(writeBuffer_.end(), data, data + length);
+		if (!writeDecodedLength_)
+			stats_.bytesWritten += uint32_t(length);
+		if (writeBuffer_.size() != writeCount_)
+			return true;
+		if (!writeDecodedLength_)
+			return programBlock(writeBuffer_);
+
+		// Now we have all the encoded data, decode it and program the result
+		stats_.compressedWireWritten += writeCount_;
+		if (!status_.writeOK)
+			return true;
+		std::vector<uint8_t> block(*writeDecodedLength_);
+		compression::decoder_t decoder{};
+		decoder.reset(block.data(), block.size());
+		if (!decoder.feed(writeBuffer_.data(), writeBuffer_.size()) || !decoder.complete() ||
+			decoder.produced() != block.size())
+		{
+			status_.writeOK = false;
+			return true;
+		}
+		stats_.bytesWritten += uint32_t(block.size());
+		stats_.compressedBytesWritten += uint32_t(block.size());
+		return programBlock(block);
+	}
+
+	// Now we have the complete block, program it a page at a time as the firmware does
+	bool programmer_t::programBlock(const std::vector<uint8_t> &data) noexcept
+	{
+		const auto pageSize{target_->geometry().pageSize};
+		for (size_t offset{}; offset < data.size(); offset += pageSize)
+		{
+			const auto amount{std::min<size_t>(pageSize, data.size() - offset)};
+			if (!target_->program(writeAddress_ + uint32_t(offset), data.data() + offset, amount))
+				return false;
+			++stats_.pagesProgrammed;
+		}
+		target_->waitReady();
+
+		if (verifyWrite_)
+		{
+			std::vector<uint8_t> readBack(data.size());
+			target_->read(writeAddress_, readBack.data(), readBack.size());
+			status_.writeOK = readBack == data;
+		}
+		return true;
+	}
+
+	void programmer_t::abort() noexcept
+	{
+		target_ = nullptr;
+		readSFDP_ = false;
+		readCompressed_ = false;
+		readAddress_ = 0;
+		readCount_ = 0;
+		readFrame_.clear();
+		readFrameOffset_ = 0;
+		writeCount_ = 0;
+		writeBuffer_.clear();
+		writeDecodedLength_.reset();
+		verifyWrite_ = false;
+		eraseOperation_ = eraseOperation_t::idle;
+		status_ = {};
+		busClock_ = {};
+		fillStatus_ = {};
+		blankResult_ = {};
+		checksumResult_ = {};
+		badBlocks_ = {};
+	}
+
+	usbDeviceHandle_t open(const std::filesystem::path &backingFile)
+	{
+		flashModel_t externalChip{externalFlashGeometry(), emulatedTimings(externalFlashTimings)};
+		if (!externalChip.attachBackingFile(backingFile))
+		{
+			console.error("Failed to set up emulated programmer with backing file '"sv,
+				backingFile.u8string(), "'"sv);
+			return {};
+		}
+		if (backingFile.empty())
+			console.info("Using emulated programmer"sv);
+		else
+			console.info("Using emulated programmer with target Flash backed by '"sv, backingFile.u8string(), "'"sv);
+		auto programmer{substrate::make_unique_nothrow<programmer_t>(std::move(externalChip))};
+		if (!programmer)
+		{
+			console.error("Failed to allocate the emulated programmer"sv);
+			return {};
+		}
+		return {std::move(programmer)};
+	}
+} // namespace flashprog::emulator
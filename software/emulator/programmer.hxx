@@ -0,0 +1,104 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#ifndef EMULATOR_PROGRAMMER_HXX
+#define EMULATOR_PROGRAMMER_HXX
+
+#include <cstdint>
+#include <array>
+#include <vector>
+#include <optional>
+#include <filesystem>
+#include "usbTransport.hxx"
+#include "usbProtocol.hxx"
+#include "compression.hxx"
+#include "flashModel.hxx"
+
+namespace flashprog::emulator
+{
+	/*!
+	 * Implements the flashProto message set in-process over a set of flashModel_t's,
+	 * mirroring the behaviour of the firmware in firmware/usb/flashProto.cxx so that
+	 * the host side of the protocol can be exercised and benchmarked without hardware.
+	 */
+	struct programmer_t final : usbTransport_t
+	{
+	private:
+		std::array<flashModel_t, 2> internalChips_;
+		std::optional<flashModel_t> externalChip_;
+		flashModel_t *target_{nullptr};
+		bool claimed_{false};
+
+		bool readSFDP_{false};
+		uint32_t readAddress_{};
+		uint32_t readCount_{};
+		// Compressed reads are served a frame at a time from here, just as the firmware does
+		bool readCompressed_{false};
+		std::vector<uint8_t> readFrame_{};
+		size_t readFrameOffset_{};
+		compression::encoder_t<9U> readEncoder_{};
+
+		uint32_t writeAddress_{};
+		uint32_t writeCount_{};
+		std::vector<uint8_t> writeBuffer_{};
+		bool verifyWrite_{false};
+		// For compressed writes, writeCount_ counts the encoded data and this how many bytes it decodes to
+		std::optional<uint16_t> writeDecodedLength_{};
+
+		flashProto::eraseOperation_t eraseOperation_{flashProto::eraseOperation_t::idle};
+		// Every erase is tracked as a set of ranges, with single page and range erases being just the one
+		flashProto::requests::eraseRanges_t eraseRanges_{};
+		steadyClock_t::time_point eraseStart_{};
+
+		flashProto::responses::status_t status_{};
+		flashProto::responses::stats_t stats_{};
+		flashProto::responses::busClock_t busClock_{};
+		flashProto::responses::fill_t fillStatus_{};
+		flashProto::responses::blankCheck_t blankResult_{};
+		flashProto::responses::checksum_t checksumResult_{};
+		flashProto::responses::badBlocks_t badBlocks_{};
+
+		[[nodiscard]] flashModel_t *findChip(flashProto::flashBus_t bus, uint8_t number) noexcept;
+		[[nodiscard]] bool listDevice(uint16_t value, void *buffer, uint16_t length) noexcept;
+		[[nodiscard]] bool targetDevice(uint16_t value) noexcept;
+		[[nodiscard]] bool erase(uint16_t value, const void *buffer, uint16_t length) noexcept;
+		[[nodiscard]] bool setupRead(uint16_t count, const void *buffer, uint16_t length) noexcept;
+		[[nodiscard]] bool setupWrite(uint16_t count, bool verify, const void *buffer, uint16_t length) noexcept;
+		[[nodiscard]] bool setupSFDPRead(uint16_t count, const void *buffer, uint16_t length) noexcept;
+		[[nodiscard]] bool validRange(uint32_t address, uint32_t length) const noexcept;
+		[[nodiscard]] bool setupReadRange(const void *buffer, uint16_t length) noexcept;
+		[[nodiscard]] bool setupCompressedWrite(uint16_t count, const void *buffer, uint16_t length) noexcept;
+		[[nodiscard]] bool setupCompressedRead(const void *buffer, uint16_t length) noexcept;
+		void nextReadFrame() noexcept;
+		[[nodiscard]] bool readStatus(void *buffer, uint16_t length) noexcept;
+		[[nodiscard]] bool busClock(bool dirIn, uint16_t value, void *buffer, uint16_t length) noexcept;
+		[[nodiscard]] bool fill(bool dirIn, void *buffer, uint16_t length) noexcept;
+		[[nodiscard]] bool blankCheck(bool dirIn, void *buffer, uint16_t length) noexcept;
+		[[nodiscard]] bool uniqueID(void *buffer, uint16_t length) noexcept;
+		[[nodiscard]] bool checksum(bool dirIn, void *buffer, uint16_t length) noexcept;
+		[[nodiscard]] bool badBlocks(bool dirIn, void *buffer, uint16_t length) noexcept;
+		[[nodiscard]] bool performRead(void *buffer, int32_t length) noexcept;
+		[[nodiscard]] bool performWrite(const void *buffer, int32_t length) noexcept;
+		[[nodiscard]] bool programBlock(const std::vector<uint8_t> &data) noexcept;
+		void abort() noexcept;
+
+	public:
+		programmer_t(std::optional<flashModel_t> &&externalChip);
+		programmer_t(const programmer_t &) = delete;
+		programmer_t(programmer_t &&) = delete;
+		~programmer_t() noexcept final = default;
+		programmer_t &operator =(const programmer_t &) = delete;
+		programmer_t &operator =(programmer_t &&) = delete;
+
+		[[nodiscard]] bool claimInterface(int32_t interfaceNumber) noexcept final;
+		[[nodiscard]] bool releaseInterface(int32_t interfaceNumber) noexcept final;
+		[[nodiscard]] bool interruptTransfer(uint8_t endpoint, void *bufferPtr, int32_t bufferLen) noexcept final;
+		[[nodiscard]] bool bulkTransfer(uint8_t endpoint, void *bufferPtr, int32_t bufferLen) noexcept final;
+		[[nodiscard]] bool controlTransfer(requestType_t requestType, uint8_t request, uint16_t value,
+			uint16_t index, void *bufferPtr, uint16_t bufferLen) noexcept final;
+	};
+
+	[[nodiscard]] flashGeometry_t internalFlashGeometry() noexcept;
+	[[nodiscard]] flashGeometry_t externalFlashGeometry() noexcept;
+	[[nodiscard]] usbDeviceHandle_t open(const std::filesystem::path &backingFile);
+} // namespace flashprog::emulator
+
+#endif /*EMULATOR_PROGRAMMER_HXX*/
@@ -1,23 +1,39 @@
 // SPDX-License-Identifier: BSD-3-Clause
 #include <vector>
+#include <algorithm>
+#include <optional>
 #include <thread>
 #include <chrono>
 #include <tuple>
+#include <random>
 #include <string_view>
 #include <stdexcept>
 #include <filesystem>
+#include <unistd.h>
+#include <cerrno>
 #include <substrate/utility>
 #include <substrate/units>
 #include <substrate/console>
 #include <substrate/fd>
 #include <substrate/command_line/arguments>
+#include <fmt/core.h>
 #include <version.hxx>
 #include "options.hxx"
 #include "help.hxx"
 #include "usbContext.hxx"
 #include "usbProtocol.hxx"
+#include "compression.hxx"
 #include "sfdp.hxx"
 #include "progress.hxx"
+#include "emulator/programmer.hxx"
+#include "trace/recorder.hxx"
+#include "trace/replay.hxx"
+#include "trace/chromeTrace.hxx"
+#include "image/imageWriter.hxx"
+#include "image/imageReader.hxx"
+#include "cache/chipCache.hxx"
+#include "chipDB/chipDatabase.hxx"
+#include "nand/badBlocks.hxx"
 #include "utils/units.hxx"
 
 // TODO: Add ChaiScript support for the flashing algorithms.
@@ -38,18 +54,63 @@ using substrate::commandLine::arguments_t;
 using substrate::commandLine::flag_t;
 using substrate::commandLine::choice_t;
 using flashprog::chip_t;
+using flashprog::image::imageWriter_t;
+using flashprog::image::imageFormat_t;
+using flashprog::image::expandImage;
+namespace cache = flashprog::cache;
+namespace chipDB = flashprog::chipDB;
+namespace nand = flashprog::nand;
 
 constexpr static auto transferBlockSize{4_KiB};
+// How much data to take from a streamed input at a time, erasing just what it covers before writing it
+constexpr static auto streamWindowSize{64_KiB};
+// '-' as a file name means to use stdin or stdout, as appropriate, in place of a file
+constexpr static auto standardStreamName{"-"sv};
+// How many erase blocks of a chip to checksum to confirm it still holds the image the chip-state cache says
+constexpr static size_t cacheSampleBlocks{4U};
+// How far past the longest the chip's datasheet says an erase may take to wait before giving up on it
+constexpr static auto eraseDeadlineMargin{1s};
 static arguments_t args{};
 
-auto requestCount(const usbDeviceHandle_t &device)
+// Whether to compress the data for an operation on the wire, and how much that has saved so far
+struct wireCompression_t final
+{
+	bool enabled{false};
+	uint64_t dataBytes{};
+	uint64_t wireBytes{};
+	compression::encoder_t<12U> encoder{};
+	std::array<uint8_t, transferBlockSize> encoded{};
+
+	wireCompression_t(const bool enable) noexcept : enabled{enable} { }
+
+	void display() const noexcept
+	{
+		if (!dataBytes)
+			return;
+		console.info("Compressed "sv, dataBytes, " bytes of data to "sv, wireBytes, " bytes over USB ("sv,
+			(wireBytes * 100U) / dataBytes, "%)"sv);
+	}
+};
+
+auto requestCount(const usbDeviceHandle_t &device, const bool rescan)
 {
 	responses::deviceCount_t deviceCount{};
-	if (!requests::deviceCount_t{}.read(device, 0, deviceCount))
+	// The programmer remembers what it identified the chips as, so only has it look again if asked to
+	if (!requests::deviceCount_t{rescan}.read(device, 0, deviceCount))
 		throw requests::usbError_t{};
 	return std::make_tuple(deviceCount.internalCount, deviceCount.externalCount);
 }
 
+[[nodiscard]] bool isStandardStream(const std::filesystem::path &fileName) noexcept
+	{ return fileName.native() == standardStreamName; }
+
+[[nodiscard]] uint64_t optionalNumber(const commandLine::item_t *const arg, const uint64_t defaultValue)
+{
+	if (!arg)
+		return defaultValue;
+	return std::any_cast<uint64_t>(std::get<flag_t>(*arg).value());
+}
+
 responses::listDevice_t readChipInfo(const usbDeviceHandle_t &device, const chip_t &chip)
 {
 	responses::listDevice_t chipInfo{};
@@ -69,30 +130,108 @@ responses::listDevice_t readChipInfo(const usbDeviceHandle_t &device, const chip
 	return chipInfo;
 }
 
+// The chip database, loaded the first time an operation needs it
+[[nodiscard]] const chipDB::chipDatabase_t &chipDatabase()
+{
+	static const auto database{chipDB::loadDatabase()};
+	return database;
+}
+
+// Identify the targeted chip for the chip-state cache, if it has a unique ID to go by
+[[nodiscard]] std::optional<cache::chipKey_t> readChipKey(const usbDeviceHandle_t &device,
+	const responses::listDevice_t &chipInfo) noexcept
+{
+	responses::uniqueID_t uniqueID{};
+	if (!requests::uniqueID_t{}.read(device, 0, uniqueID))
+		return std::nullopt;
+	// Chips without a unique ID read back all 0's or all 1's
+	const auto &id{uniqueID.id};
+	if (std::all_of(id.begin(), id.end(), [](const uint8_t value) { return value == 0x00U; }) ||
+		std::all_of(id.begin(), id.end(), [](const uint8_t value) { return value == 0xFFU; }))
+		return std::nullopt;
+	return cache::chipKey_t{chipInfo.manufacturer, chipInfo.deviceType, id};
+}
+
+/*!
+ * Work out the profile of the targeted chip, asking the chip's SFDP data for the timings of chips
+ * the chip database doesn't know about
+ */
+[[nodiscard]] chipDB::chipProfile_t readChipProfile(const usbDeviceHandle_t &device,
+	const responses::listDevice_t &chipInfo)
+{
+	auto profile{chipDB::profileFor(chipDatabase(), chipInfo)};
+	if (!profile.known)
+	{
+		const auto sfdp{sfdp::read(device, {0, 1}, readChipKey(device, chipInfo))};
+		if (sfdp && sfdp->hasBasicTable())
+			chipDB::mergeSFDP(profile, sfdp->profile());
+	}
+	return profile;
+}
+
+bool targetDevice(const usbDeviceHandle_t &device, const flashBus_t deviceType, const uint8_t deviceNumber) noexcept
+{
+	if (!requests::targetDevice_t{deviceNumber, deviceType}.write(device, 0))
+		return false;
+	// Targeting an external chip trains the bus clock for it, which the user may want to override
+	const auto *const spiClock{args["spi-clock"sv]};
+	if (deviceType != flashBus_t::external || !spiClock)
+		return true;
+	const auto clockKHz{std::any_cast<uint64_t>(std::get<flag_t>(*spiClock).value())};
+	if (!clockKHz || clockKHz > UINT16_MAX)
+	{
+		console.error("SPI clock must be between 1 and "sv, UINT16_MAX, "kHz"sv);
+		return false;
+	}
+	if (!requests::busClock_t{}.write(device, 0, static_cast<uint16_t>(clockKHz)))
+	{
+		console.error("Failed to override the external SPI bus clock"sv);
+		return false;
+	}
+	return true;
+}
+
+// NAND chips have the programmer scan them for their bad blocks so those can be listed with the rest of the chip
+void displayBadBlocks(const usbDeviceHandle_t &device, const chip_t &chip, const responses::listDevice_t &chipInfo)
+{
+	if (!targetDevice(device, chip.bus, chip.index))
+		return;
+	const auto map{nand::readBadBlockMap(device, chipInfo.eraseSize)};
+	if (map)
+		map->display();
+	else
+		console.warning("\t\tBad blocks - the programmer could not scan for them"sv);
+	// This deselects the device
+	[[maybe_unused]] const auto result{targetDevice(device, flashBus_t::unknown, 0)};
+}
+
 bool listDevice(const usbDeviceHandle_t &device, const chip_t &chip) noexcept
 {
 	try
 	{
 		const auto chipInfo{readChipInfo(device, chip)};
+		const auto profile{chipDB::profileFor(chipDatabase(), chipInfo)};
 		console.info('\t', chip.index, ": Manufacturer - "sv, chipInfo.manufacturer,
 			", Capacity - "sv, chipInfo.deviceSize, ", Page size - "sv, uint32_t{chipInfo.pageSize},
-			", Erase page size - "sv, uint32_t{chipInfo.eraseSize});
+			", Erase page size - "sv, uint32_t{chipInfo.eraseSize},
+			profile.known ? ", Part - "sv : ""sv, profile.name);
+		profile.display();
+		if (profile.hasQuirk(chipDB::quirk_t::pageAddressed))
+			displayBadBlocks(device, chip, chipInfo);
 		return true;
 	}
 	catch (std::exception &)
 		{ return false; }
 }
 
-int32_t listDevices(const usbDevice_t &rawDevice)
+int32_t listDevices(const usbDeviceHandle_t &device, const arguments_t &listArgs)
 {
-	const auto device{rawDevice.open()};
-	if (!device.valid() ||
-		!device.claimInterface(0))
+	if (!device.claimInterface(0))
 		return 1;
 
 	try
 	{
-		const auto &[internalDeviceCount, externalDeviceCount] = requestCount(device);
+		const auto &[internalDeviceCount, externalDeviceCount] = requestCount(device, listArgs["rescan"sv] != nullptr);
 
 		console.info("Programmer has "sv, internalDeviceCount, " internal Flash chips, and "sv,
 			externalDeviceCount, " external Flash chips"sv);
@@ -116,8 +255,146 @@ int32_t listDevices(const usbDevice_t &rawDevice)
 	return 0;
 }
 
-bool targetDevice(const usbDeviceHandle_t &device, const flashBus_t deviceType, const uint8_t deviceNumber) noexcept
-	{ return requests::targetDevice_t{deviceNumber, deviceType}.write(device, 0); }
+/*!
+ * Work out where the image lives on the targeted chip. NAND chips have the programmer scan them for their bad
+ * blocks, which are then worked around as the --bad-blocks strategy asks - writing the first writeLength bytes
+ * of a chip with no strategy is refused if that would touch a bad block. Anything else is one flat block.
+ */
+[[nodiscard]] std::optional<nand::blockLayout_t> chipLayout(const usbDeviceHandle_t &device,
+	const responses::listDevice_t &chipInfo, const arguments_t &opArgs, const uint64_t writeLength = 0U)
+{
+	if (!chipDB::profileFor(chipDatabase(), chipInfo).hasQuirk(chipDB::quirk_t::pageAddressed))
+		return nand::flatLayout(chipInfo.deviceSize, 1U);
+	const auto *const strategyArg{opArgs["bad-blocks"sv]};
+	const auto strategy
+	{
+		strategyArg ? std::any_cast<nand::strategy_t>(std::get<flag_t>(*strategyArg).value()) :
+			nand::strategy_t::skip
+	};
+	const auto map{nand::readBadBlockMap(device, chipInfo.eraseSize)};
+	if (!map)
+	{
+		// Addressing the chip flat doesn't need the map, so carry on without it if asked to
+		if (strategy == nand::strategy_t::none)
+		{
+			console.warning("Failed to scan the chip for bad blocks, addressing it flat without checking for them"sv);
+			return nand::flatLayout(chipInfo.eraseSize, chipInfo.deviceSize / chipInfo.eraseSize);
+		}
+		console.error("Failed to scan the chip for bad blocks"sv);
+		return std::nullopt;
+	}
+
+	if (strategy == nand::strategy_t::none)
+	{
+		const auto blocksWritten{(writeLength + map->blockSize - 1U) / map->blockSize};
+		if (!map->badBlocks.empty() && map->badBlocks.front() < blocksWritten)
+		{
+			console.error("Writing "sv, writeLength, " bytes would write over bad block "sv, map->badBlocks.front(),
+				", use --bad-blocks=skip or --bad-blocks=reserve to work around the chip's bad blocks"sv);
+			return std::nullopt;
+		}
+	}
+	else if (!map->badBlocks.empty())
+		console.info("Working around "sv, map->badBlocks.size(), " bad blocks"sv);
+	const auto reserveBlocks{optionalNumber(opArgs["reserve-blocks"sv], nand::defaultReserveBlocks(map->blockCount))};
+	return nand::layoutFor(*map, strategy, static_cast<uint32_t>(std::min<uint64_t>(reserveBlocks, UINT32_MAX)));
+}
+
+// Ask the programmer for the CRC-32 of a range of the chip, without reading it back
+[[nodiscard]] std::optional<uint32_t> deviceChecksum(const usbDeviceHandle_t &device,
+	const uint32_t address, const uint32_t length) noexcept
+{
+	if (!requests::checksum_t{address, length}.write(device, 0))
+		return std::nullopt;
+	responses::checksum_t result{};
+	while (!result.complete)
+	{
+		std::this_thread::sleep_for(1ms);
+		if (!requests::checksum_t::read(device, 0, result))
+			return std::nullopt;
+	}
+	if (result.complete != 1)
+		return std::nullopt;
+	return result.crc;
+}
+
+// The chip's contents are about to change, so whatever the chip-state cache knows about it is now stale
+void forgetChipState(const usbDeviceHandle_t &device, const responses::listDevice_t &chipInfo) noexcept
+{
+	if (const auto chipKey{readChipKey(device, chipInfo)}; chipKey)
+		cache::forgetChip(*chipKey);
+}
+
+// Checksum one erase block of the image where it lives on the chip, which has to be in one piece to be checked
+[[nodiscard]] std::optional<uint32_t> imageBlockChecksum(const usbDeviceHandle_t &device,
+	const nand::blockLayout_t &layout, const cache::imageDigest_t &digest, const size_t block)
+{
+	const auto extents{layout.extents(static_cast<uint32_t>(block * digest.blockSize), digest.blockLength(block))};
+	if (extents.size() != 1U)
+		return std::nullopt;
+	return deviceChecksum(device, extents[0].physicalAddress, extents[0].length);
+}
+
+/*!
+ * Check with the programmer that the chip still holds the image the chip-state cache says it does.
+ * Verified writes checksum the whole image, otherwise the first and last erase blocks and a few
+ * picked at random are checked, which catches the chip having been rewritten by anything else.
+ * Images laid out around a NAND's bad blocks are checked where each block of them lives on the chip.
+ */
+[[nodiscard]] bool chipHoldsImage(const usbDeviceHandle_t &device, const nand::blockLayout_t &layout,
+	const cache::imageDigest_t &digest, const bool verify)
+{
+	const auto blockCount{digest.blockCRCs.size()};
+	if (verify && layout.isFlat())
+		return deviceChecksum(device, 0, digest.length) == digest.crc;
+	else if (verify)
+	{
+		// The image isn't in one piece on the chip, so checksum all of it a block at a time instead
+		for (size_t block{}; block < blockCount; ++block)
+		{
+			if (imageBlockChecksum(device, layout, digest, block) != digest.blockCRCs[block])
+				return false;
+		}
+		return true;
+	}
+	std::minstd_rand random{std::random_device{}()};
+	for (size_t sample{}; sample < std::min(cacheSampleBlocks, blockCount); ++sample)
+	{
+		const auto block
+		{
+			[&]() -> size_t
+			{
+				if (sample == 0U)
+					return 0U;
+				if (sample == 1U)
+					return blockCount - 1U;
+				return random() % blockCount;
+			}()
+		};
+		if (imageBlockChecksum(device, layout, digest, block) != digest.blockCRCs[block])
+			return false;
+	}
+	return true;
+}
+
+// Erases that run well past the longest the chip's datasheet allows have failed, so give up on them then
+[[nodiscard]] std::optional<std::chrono::steady_clock::time_point> eraseDeadline(const chipDB::timing_t &time,
+	const uint32_t count) noexcept
+{
+	if (time.maximum == 0us)
+		return std::nullopt;
+	return std::chrono::steady_clock::now() + (time.maximum * count) + eraseDeadlineMargin;
+}
+
+[[nodiscard]] int32_t eraseTimedOut(const usbDeviceHandle_t &device, const chipDB::timing_t &time,
+	const uint32_t count)
+{
+	console.error("Erase did not complete within the "sv, chipDB::formatTime(time.maximum * count),
+		" the chip's datasheet allows for it"sv);
+	if (!requests::abort_t{}.write(device, 0) || !device.releaseInterface(0))
+		return 2;
+	return 1;
+}
 
 void displayChipSize(const uint32_t chipSize) noexcept
 {
@@ -125,13 +402,20 @@ void displayChipSize(const uint32_t chipSize) noexcept
 	console.info("Chip is "sv, size, units, " in size"sv);
 }
 
-int32_t eraseDevice(const usbDevice_t &rawDevice, const arguments_t &eraseArgs)
+void displayThroughput(const uint64_t byteCount, const std::chrono::steady_clock::duration elapsedTime) noexcept
+{
+	const auto elapsedMicroseconds{std::chrono::duration_cast<std::chrono::microseconds>(elapsedTime).count()};
+	if (elapsedMicroseconds <= 0)
+		return;
+	const auto bytesPerSecond{(byteCount * 1'000'000U) / uint64_t(elapsedMicroseconds)};
+	console.info("Average throughput: "sv, bytesPerSecond / 1024U, "kiB/s"sv);
+}
+
+int32_t eraseDevice(const usbDeviceHandle_t &device, const arguments_t &eraseArgs)
 {
 	const auto &chip{std::any_cast<chip_t>(std::get<flag_t>(*eraseArgs["chip"sv]).value())};
 
-	const auto device{rawDevice.open()};
-	if (!device.valid() ||
-		!device.claimInterface(0))
+	if (!device.claimInterface(0))
 		return 1;
 
 	if (!requests::abort_t{}.write(device, 0) ||
@@ -142,9 +426,26 @@ int32_t eraseDevice(const usbDevice_t &rawDevice, const arguments_t &eraseArgs)
 		return 1;
 	}
 
+	const auto chipInfo{readChipInfo(device, chip)};
+	forgetChipState(device, chipInfo);
+	const auto profile{readChipProfile(device, chipInfo)};
+	// The chip database fills in a conservative chip erase for chips it doesn't describe one for,
+	// but don't go erasing without knowing how long to wait for it all the same
+	if (!profile.chipErase)
+	{
+		console.error("No chip erase instruction is known for this chip, refusing to erase it"sv);
+		if (!device.releaseInterface(0))
+			return 2;
+		return 1;
+	}
+	const auto &chipErase{*profile.chipErase};
+	if (profile.known)
+		console.info("Chip erase typically takes "sv, chipDB::formatTime(chipErase.time.typical),
+			", and at most "sv, chipDB::formatTime(chipErase.time.maximum));
 	progressBar_t progress{"Erasing chip"sv};
 	progress.display();
 	const auto startTime{std::chrono::steady_clock::now()};
+	const auto deadline{eraseDeadline(chipErase.time, 1U)};
 
 	if (!requests::erase_t{}.write(device, 0, eraseOperation_t::all))
 	{
@@ -157,13 +458,15 @@ int32_t eraseDevice(const usbDevice_t &rawDevice, const arguments_t &eraseArgs)
 	responses::status_t status{};
 	while (!status.eraseComplete)
 	{
-		std::this_thread::sleep_for(125ms);
+		std::this_thread::sleep_for(chipErase.pollInterval());
 		if (!requests::status_t{}.read(device, 0, status))
 		{
 			if (!device.releaseInterface(0))
 				return 2;
 			return 1;
 		}
+		if (!status.eraseComplete && deadline && std::chrono::steady_clock::now() > *deadline)
+			return eraseTimedOut(device, chipErase.time, 1U);
 		++progress;
 	}
 	progress.close();
@@ -189,7 +492,7 @@ int32_t eraseDevice(const usbDevice_t &rawDevice, const arguments_t &eraseArgs)
 }
 
 [[nodiscard]] int32_t readNormalDevice(const usbDeviceHandle_t &device, const responses::listDevice_t &chipInfo,
-	substrate::fd_t &file)
+	imageWriter_t &output)
 {
 	if (chipInfo.deviceSize % transferBlockSize)
 	{
@@ -215,7 +518,7 @@ int32_t eraseDevice(const usbDevice_t &rawDevice, const arguments_t &eraseArgs)
 
 		std::array<std::byte, transferBlockSize> data{};
 		if (!device.readBulk(1, data.data(), data.size()) ||
-			!file.write(data))
+			!output.write(data))
 		{
 			console.error("Failed to read pages "sv, page, ":"sv, page + pagesPerBlock - 1,
 				" back from the device"sv);
@@ -230,7 +533,7 @@ int32_t eraseDevice(const usbDevice_t &rawDevice, const arguments_t &eraseArgs)
 }
 
 [[nodiscard]] int32_t readTinyDevice(const usbDeviceHandle_t &device, const responses::listDevice_t &chipInfo,
-	substrate::fd_t &file)
+	imageWriter_t &output)
 {
 	const uint32_t pageSize{chipInfo.pageSize};
 	const uint32_t pageCount{chipInfo.deviceSize / pageSize};
@@ -248,7 +551,7 @@ int32_t eraseDevice(const usbDevice_t &rawDevice, const arguments_t &eraseArgs)
 		}
 
 		if (!device.readBulk(1, data.get(), static_cast<int32_t>(pageSize)) ||
-			!file.write(data, pageSize))
+			!output.write(data.get(), pageSize))
 		{
 			console.error("Failed to read page "sv, page, " back from the device"sv);
 			if (!device.releaseInterface(0))
@@ -261,9 +564,214 @@ int32_t eraseDevice(const usbDevice_t &rawDevice, const arguments_t &eraseArgs)
 	return 0;
 }
 
-int32_t readDevice(const usbDevice_t &rawDevice, const arguments_t &readArgs)
+// Ask the programmer where the first and last used (not erased) bytes in a range are, without reading it back
+[[nodiscard]] std::optional<responses::blankCheck_t> blankCheck(const usbDeviceHandle_t &device,
+	const uint32_t address, const uint32_t length) noexcept
+{
+	if (!requests::blankCheck_t{address, length}.write(device, 0))
+		return std::nullopt;
+	responses::blankCheck_t result{};
+	while (!result.complete)
+	{
+		std::this_thread::sleep_for(1ms);
+		if (!requests::blankCheck_t::read(device, 0, result))
+			return std::nullopt;
+	}
+	if (result.complete != 1)
+		return std::nullopt;
+	return result;
+}
+
+[[nodiscard]] int32_t readDeviceRange(const usbDeviceHandle_t &device, const uint32_t length,
+	imageWriter_t &output)
+{
+	// Ask for the entire range in one go, and then stream the data back a block at a time
+	const auto blockCount{static_cast<uint32_t>((length + transferBlockSize - 1U) / transferBlockSize)};
+	progressBar_t progress{"Reading chip "sv, blockCount};
+	progress.display();
+	for (uint32_t block{}; block < blockCount; ++block)
+	{
+		const auto address{block * transferBlockSize};
+		const auto byteCount{std::min(length - address, transferBlockSize)};
+		std::array<std::byte, transferBlockSize> data{};
+		if (!device.readBulk(1, data.data(), static_cast<int32_t>(byteCount)) ||
+			!output.write(data.data(), byteCount))
+		{
+			console.error("Failed to read bytes "sv, address, ":"sv, address + byteCount - 1U,
+				" back from the device"sv);
+			if (!device.releaseInterface(0))
+				return 2;
+			return 1;
+		}
+		++progress;
+	}
+	progress.close();
+	return 0;
+}
+
+// Read back and unpack the frames of a compressed range read, checking each fits in what's left of the range
+[[nodiscard]] int32_t readDeviceCompressed(const usbDeviceHandle_t &device, const uint32_t length,
+	imageWriter_t &output, wireCompression_t &compression)
+{
+	constexpr auto headerLength{sizeof(responses::compressedFrame_t)};
+	constexpr auto alignment{responses::compressedFrameAlignment};
+	const auto blockCount{static_cast<uint32_t>((length + transferBlockSize - 1U) / transferBlockSize)};
+	std::array<uint8_t, responses::compressedFrameBlock + alignment> frame{};
+	std::array<uint8_t, responses::compressedFrameBlock> data{};
+	progressBar_t progress{"Reading chip "sv, blockCount};
+	progress.display();
+	for (uint32_t address{}; address < length;)
+	{
+		responses::compressedFrame_t header{};
+		const auto validFrame
+		{
+			[&]()
+			{
+				// Every frame is at least a packet long, and the first packet says how long the rest is
+				if (!device.readBulk(1, frame.data(), alignment))
+					return false;
+				std::memcpy(&header, frame.data(), sizeof(header));
+				if (!header.decodedLength || header.decodedLength > data.size() ||
+					header.decodedLength > length - address || header.length > header.decodedLength)
+					return false;
+				const auto frameLength{(headerLength + header.length + alignment - 1U) / alignment * alignment};
+				if (frameLength > alignment &&
+					!device.readBulk(1, frame.data() + alignment, static_cast<int32_t>(frameLength - alignment)))
+					return false;
+				compression.wireBytes += frameLength;
+				// Frames that didn't get any smaller are sent raw
+				if (header.length == header.decodedLength)
+				{
+					std::memcpy(data.data(), frame.data() + headerLength, header.length);
+					return true;
+				}
+				compression::decoder_t decoder{};
+				decoder.reset(data.data(), header.decodedLength);
+				return decoder.feed(frame.data() + headerLength, header.length) &&
+					decoder.complete() && decoder.produced() == header.decodedLength;
+			}()
+		};
+		if (!validFrame || !output.write(data.data(), header.decodedLength))
+		{
+			console.error("Failed to read bytes "sv, address, " onwards back from the device"sv);
+			if (!device.releaseInterface(0))
+				return 2;
+			return 1;
+		}
+		compression.dataBytes += header.decodedLength;
+		address += header.decodedLength;
+		++progress;
+	}
+	progress.close();
+	return 0;
+}
+
+/*!
+ * Work out how much of the image on the chip to read, stopping at the last used byte if asked to trim the trailing
+ * erased bytes. The runs of the chip the image lives in are checked from the end back until one holds data.
+ */
+[[nodiscard]] uint32_t readLength(const usbDeviceHandle_t &device, const nand::blockLayout_t &layout,
+	const bool trim)
+{
+	if (!trim)
+		return layout.capacity();
+	const auto extents{layout.extents(0U, layout.capacity())};
+	for (auto extent{extents.rbegin()}; extent != extents.rend(); ++extent)
+	{
+		const auto result{blankCheck(device, extent->physicalAddress, extent->length)};
+		if (!result)
+		{
+			console.warning("Programmer could not blank check the chip, reading all of it"sv);
+			return layout.capacity();
+		}
+		if (!result->blank)
+			return extent->logicalAddress + (result->lastUsed - extent->physicalAddress) + 1U;
+	}
+	return 0U;
+}
+
+// Check the programmer accepted a range read before waiting on the data it would stream back
+[[nodiscard]] bool readAccepted(const usbDeviceHandle_t &device, const uint32_t address, const uint32_t length)
+{
+	responses::status_t status{};
+	if (!requests::status_t{}.read(device, 0, status))
+		return false;
+	if (!status.readOK)
+		console.error("Programmer refused to read bytes "sv, address, ":"sv, address + length - 1U,
+			", is the range past the end of the chip?"sv);
+	return status.readOK;
+}
+
+// Read back one run of the chip the image lives in, using the fastest kind of read the programmer supports
+[[nodiscard]] int32_t readExtent(const usbDeviceHandle_t &device, const responses::listDevice_t &chipInfo,
+	const nand::extent_t &extent, imageWriter_t &output, wireCompression_t &compression)
+{
+	if (compression.enabled)
+	{
+		if (requests::compressedRead_t{extent.physicalAddress, extent.length}.write(device, 0))
+		{
+			if (!readAccepted(device, extent.physicalAddress, extent.length))
+			{
+				if (!device.releaseInterface(0))
+					return 2;
+				return 1;
+			}
+			return readDeviceCompressed(device, extent.length, output, compression);
+		}
+		console.warning("Programmer does not support compressed reads, falling back to normal reads"sv);
+		compression.enabled = false;
+	}
+	if (requests::readRange_t{extent.physicalAddress, extent.length}.write(device, 0))
+	{
+		if (!readAccepted(device, extent.physicalAddress, extent.length))
+		{
+			if (!device.releaseInterface(0))
+				return 2;
+			return 1;
+		}
+		return readDeviceRange(device, extent.length, output);
+	}
+	// Block reads always read the whole chip, so can't be used to read around bad blocks
+	if (extent.physicalAddress != extent.logicalAddress)
+	{
+		console.error("Programmer does not support range reads, which reading around bad blocks needs"sv);
+		if (!device.releaseInterface(0))
+			return 2;
+		return 1;
+	}
+	// If the programmer doesn't understand range reads, fall back to reading a block at a time
+	console.warning("Programmer does not support range reads, falling back to block reads"sv);
+	if (chipInfo.deviceSize >= transferBlockSize)
+		return readNormalDevice(device, chipInfo, output);
+	else
+		return readTinyDevice(device, chipInfo, output);
+}
+
+// Work out which format the image file of a read or write is in
+[[nodiscard]] std::optional<imageFormat_t> imageFormat(const arguments_t &fileArgs) noexcept
+{
+	const auto sparse{fileArgs["sparse"sv] != nullptr};
+	const auto extents{fileArgs["extents"sv] != nullptr};
+	if (sparse && extents)
+	{
+		console.error("Only one of --sparse and --extents can be given"sv);
+		return std::nullopt;
+	}
+	if (sparse)
+		return imageFormat_t::sparse;
+	if (extents)
+		return imageFormat_t::extents;
+	return imageFormat_t::raw;
+}
+
+int32_t readDevice(const usbDeviceHandle_t &device, const arguments_t &readArgs)
 {
 	const auto &chip{std::any_cast<chip_t>(std::get<flag_t>(*readArgs["chip"sv]).value())};
+	const auto trim{readArgs["trim"sv] != nullptr};
+	wireCompression_t compression{readArgs["compress"sv] != nullptr};
+	const auto format{imageFormat(readArgs)};
+	if (!format)
+		return 1;
 	const auto &fileName
 	{
 		[](const commandLine::item_t *arg)
@@ -274,13 +782,27 @@ int32_t readDevice(const usbDevice_t &rawDevice, const arguments_t &readArgs)
 		}(readArgs["file"sv])
 	};
 
-	const auto device{rawDevice.open()};
-	if (!device.valid() ||
-		!device.claimInterface(0))
+	if (!device.claimInterface(0))
 		return 1;
 
-	substrate::fd_t file{fileName, O_CREAT | O_WRONLY | O_NOCTTY, substrate::normalMode};
-	if (!file.valid())
+	const auto streamed{isStandardStream(fileName)};
+	if (streamed && *format != imageFormat_t::raw)
+	{
+		console.error("Sparse and extent list output need a seekable file, so can't be written to stdout"sv);
+		if (!device.releaseInterface(0))
+			return 2;
+		return 1;
+	}
+
+	// Truncate the file as a trimmed read may well be shorter than what's already there
+	substrate::fd_t file
+	{
+		streamed ?
+			substrate::fd_t{dup(STDOUT_FILENO)} :
+			substrate::fd_t{fileName, O_CREAT | O_WRONLY | O_TRUNC | O_NOCTTY, substrate::normalMode}
+	};
+	imageWriter_t output{file, *format};
+	if (!file.valid() || !output.begin())
 	{
 		console.error("Failed to open output file '"sv, fileName.u8string(), "'"sv);
 		if (!device.releaseInterface(0))
@@ -288,9 +810,16 @@ int32_t readDevice(const usbDevice_t &rawDevice, const arguments_t &readArgs)
 		return 1;
 	}
 
+	// Abort any stale running command before asking about the chip, so the programmer identifies it
+	// only the once for both that and targeting it
+	if (!requests::abort_t{}.write(device, 0))
+	{
+		if (!device.releaseInterface(0))
+			return 2;
+		return 1;
+	}
 	const auto chipInfo{readChipInfo(device, chip)};
-	if (!requests::abort_t{}.write(device, 0) ||
-		!targetDevice(device, chip.bus, chip.index))
+	if (!targetDevice(device, chip.bus, chip.index))
 	{
 		if (!device.releaseInterface(0))
 			return 2;
@@ -299,23 +828,48 @@ int32_t readDevice(const usbDevice_t &rawDevice, const arguments_t &readArgs)
 
 	displayChipSize(chipInfo.deviceSize);
 	const auto startTime{std::chrono::steady_clock::now()};
+	const auto layout{chipLayout(device, chipInfo, readArgs)};
+	if (!layout)
+	{
+		if (!device.releaseInterface(0))
+			return 2;
+		return 1;
+	}
+	const auto length{readLength(device, *layout, trim)};
+	if (trim)
+		console.info("Reading "sv, length, " bytes up to the last used byte of the chip"sv);
 	const auto result
 	{
 		[&]()
 		{
-			if (chipInfo.deviceSize >= transferBlockSize)
-				return readNormalDevice(device, chipInfo, file);
-			else
-				return readTinyDevice(device, chipInfo, file);
+			for (const auto &extent : layout->extents(0U, length))
+			{
+				const auto extentResult{readExtent(device, chipInfo, extent, output, compression)};
+				if (extentResult)
+					return extentResult;
+			}
+			return 0;
 		}()
 	};
 	if (result != 0)
 		return result;
+	if (!output.finish())
+	{
+		console.error("Failed to finish writing the output file '"sv, fileName.u8string(), "'"sv);
+		if (!device.releaseInterface(0))
+			return 2;
+		return 1;
+	}
 	const auto endTime{std::chrono::steady_clock::now()};
 
 	console.info("Complete"sv);
+	if (output.imageFormat() != imageFormat_t::raw)
+		console.info("Stored "sv, output.storedLength(), " bytes of data for the "sv, output.imageLength(),
+			" byte image"sv);
 	const auto elapsedSeconds{std::chrono::duration_cast<std::chrono::seconds>(endTime - startTime)};
 	console.info("Total time elapsed: "sv, substrate::asTime_t{uint64_t(elapsedSeconds.count())});
+	displayThroughput(length, endTime - startTime);
+	compression.display();
 
 	// This deselects the device
 	if (!targetDevice(device, flashBus_t::unknown, 0))
@@ -330,79 +884,329 @@ int32_t readDevice(const usbDevice_t &rawDevice, const arguments_t &readArgs)
 	return 0;
 }
 
-int32_t erasePages(const usbDeviceHandle_t &device, const responses::listDevice_t chipInfo, size_t fileLength)
+[[nodiscard]] uint32_t rangeLength(const requests::erase_t &range) noexcept
 {
-	responses::status_t status{};
-	const uint32_t pageSize{chipInfo.eraseSize};
-	const uint32_t pageCount
-	{
-		[fileLength, pageSize] () -> uint32_t
-		{
-			const auto pages{fileLength / pageSize};
-			const auto remainder{fileLength % pageSize};
-			return pages + (remainder ? 1U : 0U);
-		}()
-	};
+	const uint32_t beginPage{range.beginPage};
+	const uint32_t endPage{range.endPage};
+	return endPage > beginPage ? endPage - beginPage : 0U;
+}
 
-	progressBar_t progress{"Erasing chip "sv, pageCount};
-	progress.display();
-	if (!requests::erase_t{{}, {pageCount}}.write(device, 0, eraseOperation_t::pageRange))
+[[nodiscard]] bool issueErase(const usbDeviceHandle_t &device, const requests::eraseRanges_t &request,
+	bool &multiRange) noexcept
+{
+	if (multiRange)
 	{
-		if (!device.releaseInterface(0))
-			return 2;
-		return 1;
+		if (request.write(device, 0))
+			return true;
+		// If the programmer doesn't understand multi-range erases, fall back to one range at a time
+		console.warning("Programmer does not support multi-range erases, falling back to single range erases"sv);
+		multiRange = false;
 	}
+	return request.ranges[0].write(device, 0, eraseOperation_t::pageRange);
+}
 
-	page_t currentPage{};
-	while (!status.eraseComplete)
+/*!
+ * Erase the given ranges of erase pages, batching up as many ranges per erase request as the
+ * programmer can take so a sparse erase plan costs one round trip per batch rather than per range.
+ * The programmer is polled for progress as often as the type of erase it uses warrants.
+ */
+int32_t eraseRanges(const usbDeviceHandle_t &device, const std::vector<requests::erase_t> &ranges,
+	const chipDB::eraseType_t &erase, const bool showProgress = true)
+{
+	uint32_t pageCount{};
+	for (const auto &range : ranges)
+		pageCount += rangeLength(range);
+
+	// Erases done as part of another operation leave displaying progress to that operation
+	std::optional<progressBar_t> progress{};
+	if (showProgress)
 	{
-		std::this_thread::sleep_for(10ms);
-		if (!requests::status_t{}.read(device, 0, status))
+		progress.emplace("Erasing chip "sv, pageCount);
+		progress->display();
+	}
+	bool multiRange{true};
+	// How many pages the completed batches covered, and how many pages the progress bar shows as done
+	uint32_t pagesErased{};
+	uint32_t pagesShown{};
+	for (size_t offset{}; offset < ranges.size();)
+	{
+		requests::eraseRanges_t request{};
+		request.count = static_cast<uint8_t>(std::min(requests::maxEraseRanges, ranges.size() - offset));
+		std::copy_n(ranges.begin() + static_cast<ptrdiff_t>(offset), request.count, request.ranges.begin());
+		if (!issueErase(device, request, multiRange))
 		{
 			if (!device.releaseInterface(0))
 				return 2;
 			return 1;
 		}
-		if (currentPage != status.erasePage)
+		if (!multiRange)
+			request.count = 1U;
+		offset += request.count;
+		uint32_t batchPages{};
+		for (size_t range{}; range < request.count; ++range)
+			batchPages += rangeLength(request.ranges[range]);
+		const auto deadline{eraseDeadline(erase.time, batchPages)};
+
+		responses::status_t status{};
+		while (!status.eraseComplete)
 		{
-			progress += status.erasePage - currentPage;
-			currentPage = status.erasePage;
+			std::this_thread::sleep_for(erase.pollInterval());
+			if (!requests::status_t{}.read(device, 0, status))
+			{
+				if (!device.releaseInterface(0))
+					return 2;
+				return 1;
+			}
+			if (!status.eraseComplete && deadline && std::chrono::steady_clock::now() > *deadline)
+				return eraseTimedOut(device, erase.time, batchPages);
+			// Work out how many pages of this batch have been erased from which range the programmer is on
+			const auto rangeIndex{std::min<size_t>(multiRange ? status.eraseRange : 0U, request.count - 1U)};
+			uint32_t pages{pagesErased};
+			for (size_t range{}; range < rangeIndex; ++range)
+				pages += rangeLength(request.ranges[range]);
+			const uint32_t erasePage{status.erasePage};
+			const uint32_t beginPage{request.ranges[rangeIndex].beginPage};
+			pages += std::min(erasePage > beginPage ? erasePage - beginPage : 0U,
+				rangeLength(request.ranges[rangeIndex]));
+			if (!progress)
+				continue;
+			if (pages > pagesShown)
+			{
+				*progress += pages - pagesShown;
+				pagesShown = pages;
+			}
+			else
+				progress->display();
+		}
+		pagesErased += batchPages;
+		if (progress && pagesErased > pagesShown)
+		{
+			*progress += pagesErased - pagesShown;
+			pagesShown = pagesErased;
 		}
-		else
-			progress.display();
 	}
-	progress.close();
 	return 0;
 }
 
-[[nodiscard]] int32_t verifyPages(const usbDeviceHandle_t &device, const uint32_t pagesPerBlock, const uint32_t page)
+/*!
+ * Work out which erase pages from beginPage up to endPage actually hold data and so need erasing.
+ * Each blank check of a part of the range either shows it's blank or finds its first and last used
+ * bytes, pinning down the erase pages holding those as needing erasing, and leaving only the pages
+ * between them to check further. Returns std::nullopt if the programmer can't blank check.
+ */
+[[nodiscard]] std::optional<std::vector<requests::erase_t>> planErase(const usbDeviceHandle_t &device,
+	const uint32_t eraseSize, const uint32_t beginPage, const uint32_t endPage)
 {
-	responses::status_t status{};
-	// Read back the programmer status
-	if (!requests::status_t{}.read(device, 0, status))
+	std::vector<uint32_t> usedPages{};
+	std::vector<std::pair<uint32_t, uint32_t>> unchecked{{beginPage, endPage}};
+	while (!unchecked.empty())
 	{
-		if (!device.releaseInterface(0))
-			return 2;
-		return 1;
+		const auto [begin, end] = unchecked.back();
+		unchecked.pop_back();
+		if (begin >= end)
+			continue;
+		const auto result{blankCheck(device, begin * eraseSize, (end - begin) * eraseSize)};
+		if (!result)
+			return std::nullopt;
+		if (result->blank)
+			continue;
+		const auto firstPage{result->firstUsed / eraseSize};
+		const auto lastPage{result->lastUsed / eraseSize};
+		usedPages.push_back(firstPage);
+		if (lastPage != firstPage)
+			usedPages.push_back(lastPage);
+		unchecked.emplace_back(firstPage + 1U, lastPage);
 	}
-	// Then check the verification status
-	if (!status.writeOK)
+
+	// Turn the used pages into as few ranges as possible
+	std::sort(usedPages.begin(), usedPages.end());
+	std::vector<requests::erase_t> ranges{};
+	for (const auto page : usedPages)
 	{
-		console.error("Verification of data on pages "sv, page, ":"sv,
-			page + pagesPerBlock - 1, " failed"sv);
-		if (!device.releaseInterface(0))
-			return 2;
-		return 1;
+		if (!ranges.empty() && uint32_t{ranges.back().endPage} == page)
+			ranges.back().endPage = page + 1U;
+		else
+			ranges.emplace_back(page, page + 1U);
 	}
-	return 0;
+	return ranges;
 }
 
-[[nodiscard]] int32_t writeNormalDevice(const usbDeviceHandle_t &device, const responses::listDevice_t &chipInfo,
-	const substrate::fd_t &file, const substrate::off_t fileLength, const bool verify)
+/*!
+ * Erase the erase pages from beginPage up to endPage that aren't already blank, if the programmer
+ * can tell us which those are, keeping a tally of how many pages didn't need erasing.
+ */
+int32_t eraseUsedPages(const usbDeviceHandle_t &device, const chipDB::eraseType_t &erase, const uint32_t beginPage,
+	const uint32_t endPage, const bool showProgress, uint32_t &pagesSkipped)
 {
-	if (chipInfo.deviceSize % transferBlockSize)
+	const auto plan{planErase(device, erase.size, beginPage, endPage)};
+	if (!plan)
 	{
-		console.error("Funky device size, is "sv, chipInfo.deviceSize,
+		if (showProgress)
+			console.warning("Programmer does not support blank checks, erasing every page"sv);
+		return eraseRanges(device, {{beginPage, endPage}}, erase, showProgress);
+	}
+	uint32_t pagesToErase{};
+	for (const auto &range : *plan)
+		pagesToErase += rangeLength(range);
+	pagesSkipped += (endPage - beginPage) - pagesToErase;
+	if (plan->empty())
+		return 0;
+	return eraseRanges(device, *plan, erase, showProgress);
+}
+
+// Erase the erase pages that hold data of the runs of the chip that length bytes of the image from address on live in
+int32_t eraseExtents(const usbDeviceHandle_t &device, const chipDB::eraseType_t &erase,
+	const nand::blockLayout_t &layout, const uint32_t address, const uint32_t length, const bool showProgress,
+	uint32_t &pagesSkipped)
+{
+	for (const auto &extent : layout.extents(address, length))
+	{
+		const auto beginPage{extent.physicalAddress / erase.size};
+		const auto endPage{(extent.physicalAddress + extent.length + erase.size - 1U) / erase.size};
+		const auto result{eraseUsedPages(device, erase, beginPage, endPage, showProgress, pagesSkipped)};
+		if (result)
+			return result;
+	}
+	return 0;
+}
+
+int32_t erasePages(const usbDeviceHandle_t &device, const chipDB::eraseType_t &erase,
+	const nand::blockLayout_t &layout, size_t fileLength)
+{
+	const uint32_t pageSize{erase.size};
+	const uint32_t pageCount
+	{
+		[fileLength, pageSize] () -> uint32_t
+		{
+			const auto pages{fileLength / pageSize};
+			const auto remainder{fileLength % pageSize};
+			return pages + (remainder ? 1U : 0U);
+		}()
+	};
+
+	uint32_t pagesSkipped{};
+	const auto result{eraseExtents(device, erase, layout, 0U, pageCount * pageSize, true, pagesSkipped)};
+	if (pagesSkipped)
+		console.info("Skipping "sv, pagesSkipped, " of "sv, pageCount, " erase pages as they're already blank"sv);
+	return result;
+}
+
+[[nodiscard]] int32_t verifyPages(const usbDeviceHandle_t &device, const uint32_t pagesPerBlock, const uint32_t page)
+{
+	responses::status_t status{};
+	// Read back the programmer status
+	if (!requests::status_t{}.read(device, 0, status))
+	{
+		if (!device.releaseInterface(0))
+			return 2;
+		return 1;
+	}
+	// Then check the verification status
+	if (!status.writeOK)
+	{
+		console.error("Verification of data on pages "sv, page, ":"sv,
+			page + pagesPerBlock - 1, " failed"sv);
+		if (!device.releaseInterface(0))
+			return 2;
+		return 1;
+	}
+	return 0;
+}
+
+// Read as much of the requested length as the input has left, coping with pipes handing data over piecemeal
+[[nodiscard]] std::optional<size_t> readInput(const substrate::fd_t &file, void *const buffer,
+	const size_t length) noexcept
+{
+	auto *const data{static_cast<char *>(buffer)};
+	size_t byteCount{};
+	while (byteCount < length)
+	{
+		const auto result{::read(file, data + byteCount, length - byteCount)};
+		if (result < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return std::nullopt;
+		}
+		// End of input
+		if (!result)
+			break;
+		byteCount += static_cast<size_t>(result);
+	}
+	return byteCount;
+}
+
+// Try to send a block compressed, returning std::nullopt if it has to be sent normally instead
+[[nodiscard]] std::optional<int32_t> writeCompressedBlock(const usbDeviceHandle_t &device, const uint32_t page,
+	const uint32_t pagesPerBlock, const void *const data, const uint32_t byteCount, const bool verify,
+	wireCompression_t &compression)
+{
+	// If the block doesn't get any smaller, it's not worth compressing
+	const auto encodedLength
+	{
+		compression.encoder.encode(static_cast<const uint8_t *>(data), byteCount,
+			compression.encoded.data(), byteCount - 1U)
+	};
+	if (!encodedLength)
+		return std::nullopt;
+	if (!requests::compressedWrite_t{page, uint16_t(byteCount), verify}.write(device, 0, uint16_t(encodedLength)))
+	{
+		console.warning("Programmer does not support compressed writes, falling back to normal writes"sv);
+		compression.enabled = false;
+		return std::nullopt;
+	}
+
+	if (!device.writeBulk(1, compression.encoded.data(), static_cast<int32_t>(encodedLength)))
+	{
+		console.error("Failed to write pages "sv, page, ":"sv, page + pagesPerBlock - 1,
+			" to the device"sv);
+		if (!device.releaseInterface(0))
+			return 2;
+		return 1;
+	}
+	compression.dataBytes += byteCount;
+	compression.wireBytes += encodedLength;
+	// The programmer flags data that didn't decode properly the same way as data that failed to verify
+	return verifyPages(device, pagesPerBlock, page);
+}
+
+[[nodiscard]] int32_t writeBlock(const usbDeviceHandle_t &device, const uint32_t page, const uint32_t pagesPerBlock,
+	const void *const data, const uint32_t byteCount, const bool verify, wireCompression_t &compression)
+{
+	if (compression.enabled)
+	{
+		const auto result{writeCompressedBlock(device, page, pagesPerBlock, data, byteCount, verify, compression)};
+		if (result)
+			return *result;
+	}
+
+	if (!requests::write_t{page, verify}.write(device, 0, byteCount))
+	{
+		if (!device.releaseInterface(0))
+			return 2;
+		return 1;
+	}
+
+	if (!device.writeBulk(1, data, static_cast<int32_t>(byteCount)))
+	{
+		console.error("Failed to write pages "sv, page, ":"sv, page + pagesPerBlock - 1,
+			" to the device"sv);
+		if (!device.releaseInterface(0))
+			return 2;
+		return 1;
+	}
+	if (verify)
+		return verifyPages(device, pagesPerBlock, page);
+	return 0;
+}
+
+[[nodiscard]] int32_t writeNormalDevice(const usbDeviceHandle_t &device, const responses::listDevice_t &chipInfo,
+	const nand::blockLayout_t &layout, const substrate::fd_t &file, const substrate::off_t fileLength,
+	const bool verify, wireCompression_t &compression)
+{
+	if (chipInfo.deviceSize % transferBlockSize)
+	{
+		console.error("Funky device size, is "sv, chipInfo.deviceSize,
 			", was expecting a device size that divided by "sv, transferBlockSize);
 		if (!device.releaseInterface(0))
 			return 2;
@@ -422,31 +1226,20 @@ int32_t erasePages(const usbDeviceHandle_t &device, const responses::listDevice_
 	progress.display();
 	for (uint32_t block{}; block < blockCount; ++block)
 	{
-		const auto page{block * pagesPerBlock};
+		const auto page{layout.physicalAddress(block * transferBlockSize) / chipInfo.pageSize};
 		const auto byteCount{std::min(uint32_t(fileLength) - (block * transferBlockSize), transferBlockSize)};
-		if (!requests::write_t{page, verify}.write(device, 0, byteCount))
-		{
-			if (!device.releaseInterface(0))
-				return 2;
-			return 1;
-		}
-
 		std::array<std::byte, transferBlockSize> data{};
-		if (!file.read(data.data(), byteCount) ||
-			!device.writeBulk(1, data.data(), static_cast<int32_t>(byteCount)))
+		if (readInput(file, data.data(), byteCount) != byteCount)
 		{
-			console.error("Failed to write pages "sv, page, ":"sv, page + pagesPerBlock - 1,
-				" to the device"sv);
+			console.error("Failed to read the data for pages "sv, page, ":"sv, page + pagesPerBlock - 1,
+				" from the input"sv);
 			if (!device.releaseInterface(0))
 				return 2;
 			return 1;
 		}
-		if (verify)
-		{
-			const auto result{verifyPages(device, pagesPerBlock, page)};
-			if (result != 0)
-				return result;
-		}
+		const auto result{writeBlock(device, page, pagesPerBlock, data.data(), byteCount, verify, compression)};
+		if (result != 0)
+			return result;
 		++progress;
 	}
 	progress.close();
@@ -480,7 +1273,7 @@ int32_t erasePages(const usbDeviceHandle_t &device, const responses::listDevice_
 			return 1;
 		}
 
-		if (!file.read(data, byteCount) ||
+		if (readInput(file, data.get(), byteCount) != byteCount ||
 			!device.writeBulk(1, data.get(), static_cast<int32_t>(byteCount)))
 		{
 			console.error("Failed to write page "sv, page, " to the device"sv);
@@ -495,7 +1288,89 @@ int32_t erasePages(const usbDeviceHandle_t &device, const responses::listDevice_
 	return 0;
 }
 
-int32_t writeDevice(const usbDevice_t &rawDevice, const arguments_t &writeArgs, const bool verify)
+/*!
+ * Write data of unknown length, such as from a pipe, to the chip. The input is taken a window at a
+ * time, erasing just the erase pages the window covers that hold data before writing it out, so
+ * we never have to know up front how much data there is, nor erase past the end of it.
+ */
+[[nodiscard]] int32_t writeStreamedDevice(const usbDeviceHandle_t &device, const responses::listDevice_t &chipInfo,
+	const chipDB::eraseType_t &erase, const nand::blockLayout_t &layout, const substrate::fd_t &file,
+	const bool verify, wireCompression_t &compression, uint64_t &bytesWritten)
+{
+	if (chipInfo.deviceSize % transferBlockSize)
+	{
+		console.error("Funky device size, is "sv, chipInfo.deviceSize,
+			", was expecting a device size that divided by "sv, transferBlockSize);
+		if (!device.releaseInterface(0))
+			return 2;
+		return 1;
+	}
+	const auto eraseSize{erase.size};
+	const auto pagesPerBlock{static_cast<uint32_t>(transferBlockSize / chipInfo.pageSize)};
+	// The window has to be a whole number of erase pages, which are a whole number of transfer blocks
+	const auto windowSize{std::max<uint32_t>(eraseSize, streamWindowSize)};
+	const auto capacity{layout.capacity()};
+	std::vector<std::byte> window(windowSize);
+	uint32_t pagesSkipped{};
+
+	progressBar_t progress{"Writing chip "sv};
+	progress.display();
+	for (uint32_t address{}; address < capacity; address += windowSize)
+	{
+		const auto length{readInput(file, window.data(), std::min(windowSize, capacity - address))};
+		if (!length)
+		{
+			console.error("Failed to read the data for bytes "sv, address, " onwards from the input"sv);
+			if (!device.releaseInterface(0))
+				return 2;
+			return 1;
+		}
+		if (!*length)
+			break;
+
+		const auto byteCount{static_cast<uint32_t>(*length)};
+		const auto eraseResult{eraseExtents(device, erase, layout, address, byteCount, false, pagesSkipped)};
+		if (eraseResult)
+			return eraseResult;
+
+		for (uint32_t offset{}; offset < byteCount; offset += transferBlockSize)
+		{
+			const auto page{layout.physicalAddress(address + offset) / chipInfo.pageSize};
+			const auto blockLength{std::min(byteCount - offset, transferBlockSize)};
+			const auto result
+			{
+				writeBlock(device, page, pagesPerBlock, window.data() + offset, blockLength, verify, compression)
+			};
+			if (result != 0)
+				return result;
+			++progress;
+		}
+		bytesWritten += byteCount;
+		// A short window means we reached the end of the input
+		if (byteCount < windowSize)
+			break;
+	}
+	progress.close();
+
+	// If the data filled the chip, make sure that really was all of it
+	if (bytesWritten == capacity)
+	{
+		std::byte excess{};
+		const auto excessLength{readInput(file, &excess, 1U)};
+		if (!excessLength || *excessLength)
+		{
+			console.error("The input given is larger than the target device"sv);
+			if (!device.releaseInterface(0))
+				return 2;
+			return 1;
+		}
+	}
+	if (pagesSkipped)
+		console.info("Skipped "sv, pagesSkipped, " erase pages as they were already blank"sv);
+	return 0;
+}
+
+int32_t writeDevice(const usbDeviceHandle_t &device, const arguments_t &writeArgs, const bool verify)
 {
 	const auto &chip{std::any_cast<chip_t>(std::get<flag_t>(*writeArgs["chip"sv]).value())};
 	const auto &fileName
@@ -508,12 +1383,35 @@ int32_t writeDevice(const usbDevice_t &rawDevice, const arguments_t &writeArgs,
 		}(writeArgs["file"sv])
 	};
 
-	const auto device{rawDevice.open()};
-	if (!device.valid() ||
-		!device.claimInterface(0))
+	wireCompression_t compression{writeArgs["compress"sv] != nullptr};
+	const auto format{imageFormat(writeArgs)};
+	if (!format)
+		return 1;
+	if (!device.claimInterface(0))
 		return 1;
 
-	const substrate::fd_t file{fileName, O_RDONLY | O_NOCTTY};
+	const auto streamed{isStandardStream(fileName)};
+	if (streamed && *format != imageFormat_t::raw)
+	{
+		console.error("Sparse and extent list images need expanding from a file, so can't be read from stdin"sv);
+		if (!device.releaseInterface(0))
+			return 2;
+		return 1;
+	}
+	// Images in one of the space saving formats get expanded back out so they can be written like any other
+	const substrate::fd_t file
+	{
+		[&]()
+		{
+			if (streamed)
+				return substrate::fd_t{dup(STDIN_FILENO)};
+			substrate::fd_t input{fileName, O_RDONLY | O_NOCTTY};
+			if (*format == imageFormat_t::raw || !input.valid())
+				return input;
+			auto image{expandImage(input, *format)};
+			return image ? std::move(*image) : substrate::fd_t{};
+		}()
+	};
 	if (!file.valid())
 	{
 		console.error("Failed to open input file '"sv, fileName.u8string(), "'"sv);
@@ -522,18 +1420,44 @@ int32_t writeDevice(const usbDevice_t &rawDevice, const arguments_t &writeArgs,
 		return 1;
 	}
 
+	// Abort any stale running command before asking about the chip, so the programmer identifies it
+	// only the once for both that and targeting it
+	if (!requests::abort_t{}.write(device, 0))
+	{
+		if (!device.releaseInterface(0))
+			return 2;
+		return 1;
+	}
 	const auto chipInfo{readChipInfo(device, chip)};
-	const auto fileLength{file.length()};
-	if (fileLength < 0 || fileLength > chipInfo.deviceSize)
+	// Unless told how much data there is, stdin has to be streamed in as it arrives
+	const auto *const lengthArg{writeArgs["length"sv]};
+	const auto fileLength
+	{
+		[&]() -> std::optional<substrate::off_t>
+		{
+			if (lengthArg)
+				return static_cast<substrate::off_t>(optionalNumber(lengthArg, 0U));
+			if (streamed)
+				return std::nullopt;
+			return file.length();
+		}()
+	};
+	if (fileLength && (*fileLength < 0 || *fileLength > chipInfo.deviceSize))
 	{
 		console.error("The file given is larger than the target device"sv);
 		if (!device.releaseInterface(0))
 			return 2;
 		return 1;
 	}
+	if (!fileLength && chipInfo.deviceSize < transferBlockSize)
+	{
+		console.error("Writing stdin to chips smaller than "sv, transferBlockSize, " bytes requires --length"sv);
+		if (!device.releaseInterface(0))
+			return 2;
+		return 1;
+	}
 
-	if (!requests::abort_t{}.write(device, 0) ||
-		!targetDevice(device, chip.bus, chip.index))
+	if (!targetDevice(device, chip.bus, chip.index))
 	{
 		if (!device.releaseInterface(0))
 			return 2;
@@ -541,29 +1465,77 @@ int32_t writeDevice(const usbDevice_t &rawDevice, const arguments_t &writeArgs,
 	}
 
 	displayChipSize(chipInfo.deviceSize);
+	const auto profile{readChipProfile(device, chipInfo)};
+	const auto layout{chipLayout(device, chipInfo, writeArgs, fileLength ? uint64_t(*fileLength) : chipInfo.deviceSize)};
+	if (!layout)
+	{
+		if (!device.releaseInterface(0))
+			return 2;
+		return 1;
+	}
+	if (fileLength && *fileLength > layout->capacity())
+	{
+		console.error("The file given is larger than the "sv, layout->capacity(),
+			" bytes of the target device left once its bad blocks are set aside"sv);
+		if (!device.releaseInterface(0))
+			return 2;
+		return 1;
+	}
 	const auto startTime{std::chrono::steady_clock::now()};
-	const auto eraseResult{erasePages(device, chipInfo, fileLength)};
-	if (eraseResult)
-		return eraseResult;
+	// Images that can be read twice can be checked against the chip-state cache before writing them
+	const auto chipKey{readChipKey(device, chipInfo)};
+	const auto digest
+	{
+		chipKey && fileLength && *fileLength && !streamed ?
+			cache::digestImage(file, uint32_t(*fileLength), chipInfo.eraseSize) : std::nullopt
+	};
+	const auto unchanged
+	{
+		digest && !writeArgs["force"sv] && cache::loadDigest(*chipKey) == digest &&
+			chipHoldsImage(device, *layout, *digest, verify)
+	};
+	// Make sure a write that fails part way doesn't leave the cache thinking the chip holds the old image
+	if (chipKey && !unchanged)
+		cache::forgetChip(*chipKey);
 
+	uint64_t bytesWritten{};
 	const auto result
 	{
 		[&]()
 		{
+			if (unchanged)
+			{
+				console.info("Chip already holds this image, skipping the write"sv);
+				return 0;
+			}
+			if (!fileLength)
+			{
+				return writeStreamedDevice(device, chipInfo, profile.pageErase, *layout, file, verify, compression,
+					bytesWritten);
+			}
+			const auto eraseResult{erasePages(device, profile.pageErase, *layout, size_t(*fileLength))};
+			if (eraseResult)
+				return eraseResult;
+			bytesWritten = uint64_t(*fileLength);
 			if (chipInfo.deviceSize >= transferBlockSize)
-				return writeNormalDevice(device, chipInfo, file, fileLength, verify);
+				return writeNormalDevice(device, chipInfo, *layout, file, *fileLength, verify, compression);
 			else
-				return writeTinyDevice(device, chipInfo, file, fileLength, verify);
+				return writeTinyDevice(device, chipInfo, file, *fileLength, verify);
 		}()
 	};
 	if (result != 0)
 		return result;
+	if (digest && !unchanged && !cache::storeDigest(*chipKey, *digest))
+		console.warning("Failed to record the image written in the chip-state cache"sv);
 
 	const auto endTime{std::chrono::steady_clock::now()};
 
 	console.info("Complete"sv);
 	const auto elapsedSeconds{std::chrono::duration_cast<std::chrono::seconds>(endTime - startTime)};
 	console.info("Total time elapsed: "sv, substrate::asTime_t{uint64_t(elapsedSeconds.count())});
+	if (!unchanged)
+		displayThroughput(bytesWritten, endTime - startTime);
+	compression.display();
 
 	// This deselects the device
 	if (!targetDevice(device, flashBus_t::unknown, 0))
@@ -579,14 +1551,141 @@ int32_t writeDevice(const usbDevice_t &rawDevice, const arguments_t &writeArgs,
 }
 
 
-int32_t dumpSFDP(const usbDevice_t &rawDevice, const arguments_t &sfdpArgs)
+[[nodiscard]] int32_t waitFill(const usbDeviceHandle_t &device, const uint32_t length, const bool verify)
+{
+	progressBar_t progress{"Filling chip "sv, length};
+	progress.display();
+	responses::fill_t status{};
+	uint32_t bytesShown{};
+	while (!status.complete)
+	{
+		std::this_thread::sleep_for(10ms);
+		if (!requests::fill_t::read(device, 0, status))
+		{
+			if (!device.releaseInterface(0))
+				return 2;
+			return 1;
+		}
+		if (status.bytesWritten > bytesShown)
+		{
+			progress += status.bytesWritten - bytesShown;
+			bytesShown = status.bytesWritten;
+		}
+		else
+			progress.display();
+	}
+	progress.close();
+
+	if (status.complete != 1 || (verify && !status.writeOK))
+	{
+		if (status.complete != 1)
+			console.error("Programmer failed to fill the requested range"sv);
+		else
+			console.error("Verification of the filled range failed"sv);
+		if (!device.releaseInterface(0))
+			return 2;
+		return 1;
+	}
+	return 0;
+}
+
+int32_t fillDevice(const usbDeviceHandle_t &device, const arguments_t &fillArgs)
+{
+	const auto &chip{std::any_cast<chip_t>(std::get<flag_t>(*fillArgs["chip"sv]).value())};
+	const auto &pattern{std::any_cast<flashprog::fillPattern_t>(std::get<flag_t>(*fillArgs["pattern"sv]).value())};
+	const auto verify{fillArgs["verify"sv] != nullptr};
+	const auto erase{fillArgs["no-erase"sv] == nullptr};
+
+	if (!device.claimInterface(0))
+		return 1;
+
+	// Abort any stale running command before asking about the chip, so the programmer identifies it
+	// only the once for both that and targeting it
+	if (!requests::abort_t{}.write(device, 0))
+	{
+		if (!device.releaseInterface(0))
+			return 2;
+		return 1;
+	}
+	const auto chipInfo{readChipInfo(device, chip)};
+	const auto address{optionalNumber(fillArgs["address"sv], 0U)};
+	const auto length{optionalNumber(fillArgs["length"sv], address < chipInfo.deviceSize ? chipInfo.deviceSize - address : 0U)};
+	if (address >= chipInfo.deviceSize || !length || length > chipInfo.deviceSize - address)
+	{
+		console.error("The range to fill must lie within the target device"sv);
+		if (!device.releaseInterface(0))
+			return 2;
+		return 1;
+	}
+	// Erasing works in whole erase pages, so make sure we wouldn't erase anything outside the range
+	if (erase && (address % chipInfo.eraseSize || length % chipInfo.eraseSize))
+	{
+		console.error("The range to fill must start and end on an erase page boundary ("sv,
+			uint32_t{chipInfo.eraseSize}, " bytes) unless --no-erase is given"sv);
+		if (!device.releaseInterface(0))
+			return 2;
+		return 1;
+	}
+
+	if (!targetDevice(device, chip.bus, chip.index))
+	{
+		if (!device.releaseInterface(0))
+			return 2;
+		return 1;
+	}
+
+	forgetChipState(device, chipInfo);
+	displayChipSize(chipInfo.deviceSize);
+	const auto startTime{std::chrono::steady_clock::now()};
+	if (erase)
+	{
+		const auto beginPage{static_cast<uint32_t>(address / chipInfo.eraseSize)};
+		const auto endPage{static_cast<uint32_t>((address + length) / chipInfo.eraseSize)};
+		const auto profile{readChipProfile(device, chipInfo)};
+		const auto eraseResult{eraseRanges(device, {{beginPage, endPage}}, profile.pageErase)};
+		if (eraseResult)
+			return eraseResult;
+	}
+
+	requests::fill_t request{};
+	request.address = static_cast<uint32_t>(address);
+	request.length = static_cast<uint32_t>(length);
+	request.patternLength = pattern.length;
+	request.pattern = pattern.bytes;
+	request.verify = verify;
+	if (!request.write(device, 0))
+	{
+		console.error("Failed to start filling the target device"sv);
+		if (!device.releaseInterface(0))
+			return 2;
+		return 1;
+	}
+	const auto fillResult{waitFill(device, request.length, verify)};
+	if (fillResult)
+		return fillResult;
+	const auto endTime{std::chrono::steady_clock::now()};
+
+	console.info("Complete"sv);
+	const auto elapsedSeconds{std::chrono::duration_cast<std::chrono::seconds>(endTime - startTime)};
+	console.info("Total time elapsed: "sv, substrate::asTime_t{uint64_t(elapsedSeconds.count())});
+	displayThroughput(length, endTime - startTime);
+
+	// This deselects the device
+	if (!targetDevice(device, flashBus_t::unknown, 0))
+	{
+		if (!device.releaseInterface(0))
+			return 2;
+		return 1;
+	}
+	return device.releaseInterface(0) ? 0 : 1;
+}
+
+int32_t dumpSFDP(const usbDeviceHandle_t &device, const arguments_t &sfdpArgs)
 {
 	const auto &chip{std::any_cast<chip_t>(std::get<flag_t>(*sfdpArgs["chip"sv]).value())};
 
 	// Setup the USB interface for use
-	const auto device{rawDevice.open()};
-	if (!device.valid() ||
-		!device.claimInterface(0))
+	if (!device.claimInterface(0))
 		return 1;
 
 	// Abort any stale running command and select the requested Flash chip
@@ -619,6 +1718,225 @@ int32_t dumpSFDP(const usbDevice_t &rawDevice, const arguments_t &sfdpArgs)
 	return device.releaseInterface(0) ? 0 : 1;
 }
 
+void displayCycles(const std::string_view name, const uint64_t cycles, const responses::stats_t &stats) noexcept
+{
+	const auto microseconds{(cycles * 1'000'000U) / stats.cycleFrequency};
+	const auto percentage{stats.totalCycles ? (cycles * 100U) / stats.totalCycles : 0U};
+	console.info(name, cycles, " cycles ("sv, microseconds, "us, "sv, percentage, "%)"sv);
+}
+
+void displayCompression(const std::string_view name, const uint32_t bytes, const uint32_t wireBytes) noexcept
+{
+	const auto percentage{bytes ? (uint64_t{wireBytes} * 100U) / bytes : 0U};
+	console.info(name, bytes, " bytes in "sv, wireBytes, " bytes over USB ("sv, percentage, "%)"sv);
+}
+
+int32_t displayStats(const usbDeviceHandle_t &device, const arguments_t &statsArgs)
+{
+	const auto reset{statsArgs["reset"sv] != nullptr};
+
+	if (!device.claimInterface(0))
+		return 1;
+
+	responses::stats_t stats{};
+	if (!requests::stats_t{}.read(device, 0, stats, reset))
+	{
+		console.error("Failed to read the programmer's performance counters"sv);
+		if (!device.releaseInterface(0))
+			return 2;
+		return 1;
+	}
+
+	// Programmers that can't count cycles report a cycle frequency of 0
+	if (stats.cycleFrequency)
+	{
+		console.info("Time since counters were last reset: "sv, stats.totalCycles, " cycles ("sv,
+			(stats.totalCycles * 1'000U) / stats.cycleFrequency, "ms at "sv, stats.cycleFrequency / 1'000'000U, "MHz)"sv);
+		displayCycles("Time in SPI transfers: "sv, stats.spiCycles, stats);
+		displayCycles("Time busy-polling Flash: "sv, stats.busyCycles, stats);
+		displayCycles("Time handling USB: "sv, stats.usbCycles, stats);
+		displayCycles("Time idle: "sv, stats.idleCycles, stats);
+	}
+	else
+		console.info("Cycle counters are not available on this programmer"sv);
+	console.info("Bytes read: "sv, stats.bytesRead);
+	console.info("Bytes written: "sv, stats.bytesWritten);
+	console.info("Pages programmed: "sv, stats.pagesProgrammed);
+	console.info("Sectors erased: "sv, stats.sectorsErased);
+	console.info("Busy polls: "sv, stats.busyPolls);
+	displayCompression("Compressed reads: "sv, stats.compressedBytesRead, stats.compressedWireRead);
+	displayCompression("Compressed writes: "sv, stats.compressedBytesWritten, stats.compressedWireWritten);
+	if (reset)
+		console.info("Performance counters reset"sv);
+
+	return device.releaseInterface(0) ? 0 : 1;
+}
+
+void displayFrameCycles(const std::string_view name, const uint32_t cycles, const responses::benchmark_t &result) noexcept
+{
+	const auto cyclesPerByte{double(cycles) / double(result.length)};
+	const auto bytesPerSecond{cycles ? (uint64_t{result.length} * result.cycleFrequency) / cycles : 0U};
+	console.info(fmt::format("{:<16} {:>10} cycles, {:>6.2f} cycles/byte, {:>6} kiB/s"sv,
+		name, cycles, cyclesPerByte, bytesPerSecond / 1024U));
+}
+
+int32_t runBenchmark(const usbDeviceHandle_t &device, const arguments_t &benchmarkArgs)
+{
+	const auto &chip{std::any_cast<chip_t>(std::get<flag_t>(*benchmarkArgs["chip"sv]).value())};
+
+	if (!device.claimInterface(0))
+		return 1;
+
+	// Abort any stale running command and select the requested Flash chip
+	if (!requests::abort_t{}.write(device, 0) ||
+		!targetDevice(device, chip.bus, chip.index))
+	{
+		if (!device.releaseInterface(0))
+			return 2;
+		return 1;
+	}
+
+	responses::benchmark_t result{};
+	if (!requests::benchmark_t{}.read(device, 0, result))
+	{
+		console.error("Failed to run the programmer's SPI benchmark"sv);
+		if (!device.releaseInterface(0))
+			return 2;
+		return 1;
+	}
+
+	if (!result.match)
+		console.warning("The 8- and 16-bit frame reads returned different data"sv);
+	// Programmers that can't count cycles report a cycle frequency of 0
+	if (result.cycleFrequency && result.length)
+	{
+		console.info("Read "sv, result.length, " bytes from the start of the chip"sv);
+		displayFrameCycles("8-bit frames:"sv, result.byteCycles, result);
+		displayFrameCycles("16-bit frames:"sv, result.wordCycles, result);
+		if (result.byteCycles)
+			console.info(fmt::format("16-bit frames saved {:.1f}% of the cycles"sv,
+				(double(result.byteCycles) - double(result.wordCycles)) * 100.0 / double(result.byteCycles)));
+	}
+	else
+		console.info("Cycle counters are not available on this programmer"sv);
+
+	// Deselect the Flash chip now we're complete
+	if (!targetDevice(device, flashBus_t::unknown, 0))
+	{
+		if (!device.releaseInterface(0))
+			return 2;
+		return 1;
+	}
+	return device.releaseInterface(0) ? 0 : 1;
+}
+
+int32_t displayBusClock(const usbDeviceHandle_t &device, const arguments_t &clockArgs)
+{
+	const auto &chip{std::any_cast<chip_t>(std::get<flag_t>(*clockArgs["chip"sv]).value())};
+	if (chip.bus != flashBus_t::external)
+	{
+		console.error("Only the external SPI bus has its clock trained"sv);
+		return 1;
+	}
+
+	if (!device.claimInterface(0))
+		return 1;
+
+	// Abort any stale running command and select the requested Flash chip, which trains the bus clock
+	if (!requests::abort_t{}.write(device, 0) ||
+		!targetDevice(device, chip.bus, chip.index))
+	{
+		if (!device.releaseInterface(0))
+			return 2;
+		return 1;
+	}
+
+	responses::busClock_t busClock{};
+	if (!requests::busClock_t{}.read(device, 0, busClock))
+	{
+		console.error("Failed to read the external SPI bus clock"sv);
+		if (!device.releaseInterface(0))
+			return 2;
+		return 1;
+	}
+
+	console.info("Chip is rated for up to "sv, busClock.ratedKHz, "kHz"sv);
+	if (busClock.fastestKHz)
+		console.info("Fastest reliable clock: "sv, busClock.fastestKHz, "kHz"sv);
+	else
+		console.warning("The chip did not read back reliably at any clock tried"sv);
+	console.info("Trained clock: "sv, busClock.trainedKHz, "kHz"sv);
+	console.info("Current clock: "sv, busClock.currentKHz, "kHz"sv, busClock.overridden ? " (overridden)"sv : ""sv);
+
+	// Deselect the Flash chip now we're complete
+	if (!targetDevice(device, flashBus_t::unknown, 0))
+	{
+		if (!device.releaseInterface(0))
+			return 2;
+		return 1;
+	}
+	return device.releaseInterface(0) ? 0 : 1;
+}
+
+// Drain the programmer's event log, handing each chunk to the given function along with the time it was taken at
+template<typename function_t> bool drainEvents(const usbDeviceHandle_t &device, function_t &&handleChunk)
+{
+	responses::events_t chunk{};
+	do
+	{
+		const auto before{std::chrono::steady_clock::now()};
+		if (!requests::events_t{}.read(device, 0, chunk))
+			return false;
+		const auto after{std::chrono::steady_clock::now()};
+		handleChunk(chunk, before + (after - before) / 2);
+	}
+	while (chunk.remaining);
+	return true;
+}
+
+int32_t dumpEvents(const usbDeviceHandle_t &device, const arguments_t &eventsArgs)
+{
+	const auto &fileName{std::any_cast<std::filesystem::path>(std::get<flag_t>(*eventsArgs["file"sv]).value())};
+
+	if (!device.claimInterface(0))
+		return 1;
+
+	flashprog::trace::chromeTrace_t trace{};
+	const auto start{std::chrono::steady_clock::now()};
+	const auto drained
+	{
+		drainEvents(device,
+			[&](const responses::events_t &chunk, const std::chrono::steady_clock::time_point time)
+				{ trace.addDeviceEvents(chunk, time - start); })
+	};
+	if (!drained)
+	{
+		console.error("Failed to read the programmer's event log"sv);
+		if (!device.releaseInterface(0))
+			return 2;
+		return 1;
+	}
+
+	console.info("Read "sv, trace.deviceEvents(), " events from the programmer's event log"sv);
+	if (!trace.write(fileName))
+	{
+		if (!device.releaseInterface(0))
+			return 2;
+		return 1;
+	}
+	return device.releaseInterface(0) ? 0 : 1;
+}
+
+// When recording, pull the programmer's event log into the trace so flashtrace can show it alongside the host's timings
+void captureEvents(const usbDeviceHandle_t &device) noexcept
+{
+	if (!device.claimInterface(0))
+		return;
+	if (!drainEvents(device, [](const responses::events_t &, const std::chrono::steady_clock::time_point) { }))
+		console.warning("Failed to capture the programmer's event log into the trace"sv);
+	static_cast<void>(device.releaseInterface(0));
+}
+
 /*!
  * flashprog usage:
  *
@@ -626,14 +1944,78 @@ int32_t dumpSFDP(const usbDevice_t &rawDevice, const arguments_t &sfdpArgs)
  * listDevices - List the available SPIFlashProgrammer v2's
  * --device N - Selects which SPIFlashProgrammer to use
  * list - List the available flash on a given device
+ * --rescan - Have the programmer identify the chips again rather than use what it last found
  * erase N - Erases the contents of the given device
  * read N file - Reads the contents of the given device into the given file
  * write N file - Writes the contents of the given file into the selected device
  * verifiedWrite N file - writes the contents of the given file into the
  *     selected device, verifying the writes as it does.
  * sfdp N - Dump the SFDP data for the given device
+ * fill N - Fill a range of the given device with a repeating pattern
+ * stats - Display the programmer's performance counters
+ * benchmark N - Time reading the given device with 8- and 16-bit SPI frames
+ * clock N - Display the external SPI bus clock trained for the given device
+ * events file - Drain the programmer's event log into the given Chrome trace-event JSON file
+ * --emulate file - Use an emulated programmer whose target Flash is backed by the given file
+ * --record file - Record the traffic to and from the programmer into the given trace file
+ * --replay file - Use the programmer responses recorded in the given trace file
+ * --spi-clock kHz - Override the trained external SPI bus clock
  */
 
+// Check if the operation is a read with its output going to stdout
+[[nodiscard]] bool readsToStdout(const choice_t &operation)
+{
+	if (operation.value() != "read"sv)
+		return false;
+	const auto *const file{operation.arguments()["file"sv]};
+	return file && isStandardStream(std::any_cast<std::filesystem::path>(std::get<flag_t>(*file).value()));
+}
+
+int32_t runOperation(const usbDeviceHandle_t &device, const choice_t &operation)
+{
+	if (operation.value() == "listDevices"sv || operation.value() == "list"sv)
+		return listDevices(device, operation.arguments());
+	if (operation.value() == "erase"sv)
+		return eraseDevice(device, operation.arguments());
+	if (operation.value() == "read"sv)
+		return readDevice(device, operation.arguments());
+	if (operation.value() == "write"sv)
+		return writeDevice(device, operation.arguments(), false);
+	if (operation.value() == "verifiedWrite"sv)
+		return writeDevice(device, operation.arguments(), true);
+	if (operation.value() == "sfdp"sv)
+		return dumpSFDP(device, operation.arguments());
+	if (operation.value() == "fill"sv)
+		return fillDevice(device, operation.arguments());
+	if (operation.value() == "stats"sv)
+		return displayStats(device, operation.arguments());
+	if (operation.value() == "events"sv)
+		return dumpEvents(device, operation.arguments());
+	if (operation.value() == "benchmark"sv)
+		return runBenchmark(device, operation.arguments());
+	if (operation.value() == "clock"sv)
+		return displayBusClock(device, operation.arguments());
+	return 0;
+}
+
+int32_t runRecordedOperation(const usbDeviceHandle_t &device, const choice_t &operation)
+{
+	const auto result{runOperation(device, operation)};
+	if (args["record"sv] && operation.value() != "events"sv && operation.value() != "listDevices"sv)
+		captureEvents(device);
+	return result;
+}
+
+// If we've been asked to record the traffic to the programmer, wrap the device's transport to do so
+usbDeviceHandle_t recordIfRequested(usbDeviceHandle_t &&device) noexcept
+{
+	const auto *const record{args["record"sv]};
+	if (!record || !device.valid())
+		return std::move(device);
+	const auto &traceFile{std::any_cast<std::filesystem::path>(std::get<flag_t>(*record).value())};
+	return flashprog::trace::record(std::move(device), traceFile);
+}
+
 const static commandLine::item_t defaultOperation{commandLine::choice_t{"action"sv, "listDevices"sv, {}}};
 
 int main(const int argCount, const char *const *const argList) noexcept
@@ -661,6 +2043,28 @@ int main(const int argCount, const char *const *const argList) noexcept
 	const auto *operation{args["action"sv]};
 	if (!operation)
 		operation = &defaultOperation;
+	// If the chip contents are going to stdout, keep our own output out of the way of them
+	if (readsToStdout(std::get<choice_t>(*operation)))
+		console = {stderr, stderr};
+
+	// If we've been asked to use an emulated programmer, skip device discovery and use that instead
+	if (const auto *const emulate{args["emulate"sv]}; emulate)
+	{
+		const auto &backingFile{std::any_cast<std::filesystem::path>(std::get<flag_t>(*emulate).value())};
+		const auto device{recordIfRequested(flashprog::emulator::open(backingFile))};
+		if (!device.valid())
+			return 1;
+		return runRecordedOperation(device, std::get<choice_t>(*operation));
+	}
+	// Likewise if we've been asked to replay a trace
+	if (const auto *const replay{args["replay"sv]}; replay)
+	{
+		const auto &traceFile{std::any_cast<std::filesystem::path>(std::get<flag_t>(*replay).value())};
+		const auto device{recordIfRequested(flashprog::trace::openReplay(traceFile))};
+		if (!device.valid())
+			return 1;
+		return runRecordedOperation(device, std::get<choice_t>(*operation));
+	}
 
 	usbContext_t context{};
 	if (!context.valid())
@@ -679,19 +2083,10 @@ int main(const int argCount, const char *const *const argList) noexcept
 
 	if (devices.size() == 1)
 	{
-		const auto &operationArg{std::get<choice_t>(*operation)};
-		if (operationArg.value() == "listDevices"sv)
-			return listDevices(devices[0]);
-		if (operationArg.value() == "erase"sv)
-			return eraseDevice(devices[0], operationArg.arguments());
-		if (operationArg.value() == "read"sv)
-			return readDevice(devices[0], operationArg.arguments());
-		if (operationArg.value() == "write"sv)
-			return writeDevice(devices[0], operationArg.arguments(), false);
-		if (operationArg.value() == "verifiedWrite"sv)
-			return writeDevice(devices[0], operationArg.arguments(), true);
-		if (operationArg.value() == "sfdp"sv)
-			return dumpSFDP(devices[0], operationArg.arguments());
+		const auto device{recordIfRequested(devices[0].open())};
+		if (!device.valid())
+			return 1;
+		return runRecordedOperation(device, std::get<choice_t>(*operation));
 	}
 
 	return 0;
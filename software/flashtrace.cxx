@@ -0,0 +1,123 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#include <any>
+#include <filesystem>
+#include <substrate/console>
+#include <substrate/command_line/arguments>
+#include <version.hxx>
+#include "trace/options.hxx"
+#include "trace/help.hxx"
+#include "trace/traceFile.hxx"
+#include "trace/replay.hxx"
+#include "trace/profile.hxx"
+#include "trace/chromeTrace.hxx"
+#include "emulator/programmer.hxx"
+
+using namespace std::literals::string_view_literals;
+using namespace substrate;
+using substrate::commandLine::arguments_t;
+using substrate::commandLine::flag_t;
+using substrate::commandLine::choice_t;
+using namespace flashprog::trace;
+
+constexpr static uint32_t defaultTolerance{5U};
+static arguments_t args{};
+
+[[nodiscard]] static std::filesystem::path pathArgument(const arguments_t &arguments, const std::string_view name)
+	{ return std::any_cast<std::filesystem::path>(std::get<flag_t>(*arguments[name]).value()); }
+
+[[nodiscard]] static uint32_t tolerance(const arguments_t &arguments)
+{
+	if (const auto *const tolerance{arguments["tolerance"sv]}; tolerance)
+		return static_cast<uint32_t>(std::any_cast<uint64_t>(std::get<flag_t>(*tolerance).value()));
+	return defaultTolerance;
+}
+
+int32_t reportTrace(const arguments_t &reportArgs)
+{
+	const auto transactions{readTrace(pathArgument(reportArgs, "trace"sv))};
+	if (!transactions)
+		return 1;
+	console.info("Trace contains "sv, transactions->size(), " operations"sv);
+	displayProfile(buildProfile(*transactions));
+	return 0;
+}
+
+int32_t replayTrace(const arguments_t &replayArgs)
+{
+	const auto transactions{readTrace(pathArgument(replayArgs, "trace"sv))};
+	if (!transactions)
+		return 1;
+
+	const auto *const emulate{replayArgs["emulate"sv]};
+	auto device{flashprog::emulator::open(emulate ? pathArgument(replayArgs, "emulate"sv) : std::filesystem::path{})};
+	if (!device.valid())
+		return 1;
+	const auto transport{device.releaseTransport()};
+
+	console.info("Replaying "sv, transactions->size(), " operations against the emulated programmer"sv);
+	const auto replayed{replayAgainst(*transport, *transactions)};
+	if (!replayed)
+		return 1;
+	if (replayArgs["output"sv] && !writeTrace(pathArgument(replayArgs, "output"sv), *replayed))
+		return 1;
+	return compareProfiles(buildProfile(*transactions), buildProfile(*replayed), tolerance(replayArgs)) ? 0 : 1;
+}
+
+int32_t compareTraces(const arguments_t &compareArgs)
+{
+	const auto baseline{readTrace(pathArgument(compareArgs, "baseline"sv))};
+	const auto current{readTrace(pathArgument(compareArgs, "trace"sv))};
+	if (!baseline || !current)
+		return 1;
+	return compareProfiles(buildProfile(*baseline), buildProfile(*current), tolerance(compareArgs)) ? 0 : 1;
+}
+
+int32_t convertTrace(const arguments_t &chromeArgs)
+{
+	const auto transactions{readTrace(pathArgument(chromeArgs, "trace"sv))};
+	if (!transactions)
+		return 1;
+	chromeTrace_t trace{};
+	trace.addTransactions(*transactions);
+	console.info("Converted "sv, transactions->size(), " operations and "sv, trace.deviceEvents(),
+		" programmer events"sv);
+	return trace.write(pathArgument(chromeArgs, "output"sv)) ? 0 : 1;
+}
+
+int main(const int argCount, const char *const *const argList) noexcept
+{
+	console = {stdout, stderr};
+	if (const auto parsedArgs{parseArguments(argCount, argList, programOptions)}; !parsedArgs)
+	{
+		console.error("Failed to parse arguments"sv);
+		return 1;
+	}
+	else
+		args = *parsedArgs;
+	const auto &version{args.find("version"sv)};
+	const auto &help{args.find("help"sv)};
+	if (version != args.end() && help != args.end())
+	{
+		console.error("Can only specify one of --help and --version, not both."sv);
+		return 1;
+	}
+	if (version != args.end())
+		return flashprog::versionInfo::printVersion();
+	const auto *const operation{args["action"sv]};
+	if (help != args.end() || !operation)
+	{
+		console.info(helpString);
+		return help != args.end() ? 0 : 1;
+	}
+
+	const auto &action{std::get<choice_t>(*operation)};
+	if (action.value() == "report"sv)
+		return reportTrace(action.arguments());
+	if (action.value() == "replay"sv)
+		return replayTrace(action.arguments());
+	if (action.value() == "compare"sv)
+		return compareTraces(action.arguments());
+	if (action.value() == "chrome"sv)
+		return convertTrace(action.arguments());
+	return 0;
+}
@@ -0,0 +1,158 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#include <cerrno>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+#include <unistd.h>
+#include <substrate/console>
+#include "imageReader.hxx"
+
+using namespace std::literals::string_view_literals;
+using substrate::console;
+
+namespace flashprog::image
+{
+	// How much of the image to move through memory at a time while expanding it
+	constexpr static size_t expandChunkSize{65536U};
+
+	// Make a temporary file that goes away again as soon as it's closed
+	static std::optional<substrate::fd_t> temporaryFile()
+	{
+		std::error_code error{};
+		const auto directory{std::filesystem::temp_directory_path(error)};
+		if (error)
+			return std::nullopt;
+		auto fileName{(directory / "flashprog-XXXXXX").string()};
+		substrate::fd_t file{mkstemp(fileName.data())};
+		if (!file.valid())
+			return std::nullopt;
+		static_cast<void>(unlink(fileName.c_str()));
+		return file;
+	}
+
+	static bool copyData(const substrate::fd_t &file, const substrate::fd_t &image, uint64_t length)
+	{
+		std::vector<uint8_t> buffer(std::min<uint64_t>(length, expandChunkSize));
+		while (length)
+		{
+			const auto amount{std::min<size_t>(length, buffer.size())};
+			if (!file.read(buffer.data(), amount) || !image.write(buffer.data(), amount))
+				return false;
+			length -= amount;
+		}
+		return true;
+	}
+
+	static bool fillData(const substrate::fd_t &image, const uint8_t value, uint64_t length)
+	{
+		const std::vector<uint8_t> buffer(std::min<uint64_t>(length, expandChunkSize), value);
+		while (length)
+		{
+			const auto amount{std::min<size_t>(length, buffer.size())};
+			if (!image.write(buffer.data(), amount))
+				return false;
+			length -= amount;
+		}
+		return true;
+	}
+
+	// The holes of a sparse image stand for erased bytes, so they expand out to runs of erasedValue
+	static bool expandSparse(const substrate::fd_t &file, const substrate::fd_t &image)
+	{
+		const auto length{file.length()};
+		if (length < 0)
+			return false;
+		for (substrate::off_t offset{}; offset < length;)
+		{
+			auto dataBegin{lseek(file, offset, SEEK_DATA)};
+			// ENXIO means all that's left is a trailing hole. Anything else means the file
+			// system can't tell us where the holes are, so treat the rest as data
+			if (dataBegin < 0)
+				dataBegin = errno == ENXIO ? length : offset;
+			auto dataEnd{dataBegin < length ? lseek(file, dataBegin, SEEK_HOLE) : length};
+			if (dataEnd <= dataBegin)
+				dataEnd = length;
+			if (!fillData(image, erasedValue, uint64_t(dataBegin - offset)))
+				return false;
+			if (dataEnd > dataBegin &&
+				(file.seek(dataBegin, SEEK_SET) != dataBegin || !copyData(file, image, uint64_t(dataEnd - dataBegin))))
+				return false;
+			offset = dataEnd;
+		}
+		return true;
+	}
+
+	static bool expandExtents(const substrate::fd_t &file, const substrate::fd_t &image)
+	{
+		extentHeader_t header{};
+		if (!file.read(header) || header.magic != extentMagic || header.version != extentVersion)
+		{
+			console.error("Input file is not a flashprog extent list"sv);
+			return false;
+		}
+
+		uint32_t offset{};
+		for (uint32_t index{}; index < header.extentCount; ++index)
+		{
+			extentRecord_t extent{};
+			// Extents have to follow on from each other in order, and not run past the end of the image
+			if (!file.read(extent) || extent.offset != offset || extent.length > header.imageLength - offset ||
+				(extent.kind != extentKind_t::data && extent.kind != extentKind_t::fill))
+			{
+				console.error("Extent list is corrupt at extent "sv, index);
+				return false;
+			}
+			const auto expanded
+			{
+				extent.kind == extentKind_t::data ?
+					copyData(file, image, extent.length) :
+					fillData(image, extent.fillValue, extent.length)
+			};
+			if (!expanded)
+				return false;
+			offset += extent.length;
+		}
+		if (offset != header.imageLength)
+		{
+			console.error("Extent list is truncated, its extents only cover "sv, offset, " of its "sv,
+				header.imageLength, " bytes"sv);
+			return false;
+		}
+		return true;
+	}
+
+	std::optional<substrate::fd_t> expandImage(const substrate::fd_t &file, const imageFormat_t format)
+	{
+		auto image{temporaryFile()};
+		if (!image)
+		{
+			console.error("Failed to create a temporary file to expand the image into"sv);
+			return std::nullopt;
+		}
+		const auto expanded
+		{
+			[&]()
+			{
+				switch (format)
+				{
+					case imageFormat_t::raw:
+						return copyData(file, *image, uint64_t(std::max<substrate::off_t>(file.length(), 0)));
+					case imageFormat_t::sparse:
+						return expandSparse(file, *image);
+					case imageFormat_t::extents:
+						return expandExtents(file, *image);
+				}
+				return false;
+			}()
+		};
+		if (!expanded || !image->head())
+		{
+			console.error("Failed to expand the input image"sv);
+			return std::nullopt;
+		}
+		return image;
+	}
+} // namespace flashprog::image
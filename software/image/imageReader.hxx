@@ -0,0 +1,20 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#ifndef IMAGE_IMAGE_READER_HXX
+#define IMAGE_IMAGE_READER_HXX
+
+#include <cstdint>
+#include <optional>
+#include <substrate/fd>
+#include "imageWriter.hxx"
+
+namespace flashprog::image
+{
+	/*!
+	 * Expands an image stored by imageWriter_t in one of the space saving formats back out into a raw
+	 * image in an anonymous temporary file, which is handed back positioned at its start. This lets the
+	 * write paths, which need to know the image length and read it more than once, treat it as any other file.
+	 */
+	[[nodiscard]] std::optional<substrate::fd_t> expandImage(const substrate::fd_t &file, imageFormat_t format);
+} // namespace flashprog::image
+
+#endif /*IMAGE_IMAGE_READER_HXX*/
@@ -0,0 +1,143 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#include "imageWriter.hxx"
+
+namespace flashprog::image
+{
+	// How many bytes to check between chances to bail out early on finding data
+	constexpr static size_t uniformStride{256U};
+
+	/*!
+	 * Checks if a block of data is all one byte value, and if it is, returns that value.
+	 * Each stride is compared against the first byte, accumulating the differences without
+	 * branching so the compiler can vectorise the loop into wide compares and ORs.
+	 * Only between strides do we stop to see if we've found data yet.
+	 */
+	std::optional<uint8_t> uniformValue(const void *const data, const size_t length) noexcept
+	{
+		if (!length)
+			return std::nullopt;
+		const auto *const bytes{static_cast<const uint8_t *>(data)};
+		const auto value{bytes[0]};
+
+		size_t offset{};
+		// Whole strides have a fixed trip count, which lets the compiler vectorise them without an epilogue
+		for (; offset + uniformStride <= length; offset += uniformStride)
+		{
+			uint8_t difference{};
+			for (size_t index{}; index < uniformStride; ++index)
+				difference |= bytes[offset + index] ^ value;
+			if (difference)
+				return std::nullopt;
+		}
+
+		uint8_t difference{};
+		for (; offset < length; ++offset)
+			difference |= bytes[offset] ^ value;
+		if (difference)
+			return std::nullopt;
+		return value;
+	}
+
+	bool imageWriter_t::begin() noexcept
+	{
+		if (format != imageFormat_t::extents)
+			return true;
+		// Write a placeholder header that gets filled in properly by finish()
+		return file.write(extentHeader_t{});
+	}
+
+	bool imageWriter_t::write(const void *const data, const size_t length) noexcept
+	{
+		const auto byteCount{static_cast<uint32_t>(length)};
+		switch (format)
+		{
+			case imageFormat_t::raw:
+				return writeData(data, byteCount);
+			case imageFormat_t::sparse:
+				// Holes stand for erased blocks, so the image has to be expanded again by write --sparse
+				if (uniformValue(data, length) == erasedValue)
+				{
+					offset += byteCount;
+					return file.seek(byteCount, SEEK_CUR) == substrate::off_t{offset};
+				}
+				return writeData(data, byteCount);
+			case imageFormat_t::extents:
+				return writeExtent(data, byteCount);
+		}
+		return false;
+	}
+
+	bool imageWriter_t::writeData(const void *const data, const uint32_t length) noexcept
+	{
+		offset += length;
+		bytesStored += length;
+		return file.write(data, length);
+	}
+
+	bool imageWriter_t::writeExtent(const void *const data, const uint32_t length) noexcept
+	{
+		const auto value{uniformValue(data, length)};
+		const auto kind{value ? extentKind_t::fill : extentKind_t::data};
+		// If this block doesn't continue the current extent, start a new one
+		if (!extent || extent->kind != kind || (value && extent->fillValue != *value))
+		{
+			if (!closeExtent())
+				return false;
+			extent = extentRecord_t{offset, 0U, kind, value.value_or(0U), 0U};
+			if (kind == extentKind_t::data)
+			{
+				// Data extents get their record written up front so their contents can follow it
+				extentPosition = file.tell();
+				if (!file.write(*extent))
+					return false;
+			}
+		}
+
+		extent->length += length;
+		if (kind == extentKind_t::fill)
+		{
+			offset += length;
+			return true;
+		}
+		return writeData(data, length);
+	}
+
+	bool imageWriter_t::closeExtent() noexcept
+	{
+		if (!extent)
+			return true;
+		++extentCount;
+		const auto record{*extent};
+		extent.reset();
+		if (record.kind == extentKind_t::fill)
+			return file.write(record);
+
+		// Go back and fill in the now known length of the data extent
+		const auto end{file.tell()};
+		return file.seek(extentPosition, SEEK_SET) == extentPosition &&
+			file.write(record) &&
+			file.seek(end, SEEK_SET) == end;
+	}
+
+	bool imageWriter_t::finish() noexcept
+	{
+		switch (format)
+		{
+			case imageFormat_t::raw:
+				return true;
+			case imageFormat_t::sparse:
+				// Make sure the file is the full image length even if it ends in a hole
+				return file.resize(offset);
+			case imageFormat_t::extents:
+			{
+				if (!closeExtent())
+					return false;
+				extentHeader_t header{};
+				header.imageLength = offset;
+				header.extentCount = extentCount;
+				return file.head() && file.write(header);
+			}
+		}
+		return false;
+	}
+} // namespace flashprog::image
@@ -0,0 +1,99 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#ifndef IMAGE_IMAGE_WRITER_HXX
+#define IMAGE_IMAGE_WRITER_HXX
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <optional>
+#include <substrate/fd>
+
+namespace flashprog::image
+{
+	enum class imageFormat_t : uint8_t
+	{
+		// Every byte of the image is written to the file
+		raw,
+		// Blocks of erased bytes are seeked over so the file system can leave holes for them
+		sparse,
+		// The image is stored as an extent list, with runs of a single byte value stored only as their value
+		extents
+	};
+
+	// What erased Flash reads back as, and so what the holes of a sparse image stand for
+	constexpr static uint8_t erasedValue{0xFFU};
+
+	/*!
+	 * Extent images are a header followed by a sequence of extents that cover the image in order.
+	 * Data extents are immediately followed by their contents, while fill extents stand for a run of a
+	 * single byte value and carry no payload. All values are stored in host byte order.
+	 */
+	constexpr static std::array<char, 4> extentMagic{{'F', 'P', 'E', 'X'}};
+	constexpr static uint16_t extentVersion{1U};
+
+	enum class extentKind_t : uint8_t
+	{
+		data,
+		fill
+	};
+
+	struct extentHeader_t final
+	{
+		std::array<char, 4> magic{extentMagic};
+		uint16_t version{extentVersion};
+		uint16_t reserved{};
+		// How many bytes long the image is once all the extents are expanded
+		uint32_t imageLength{};
+		uint32_t extentCount{};
+	};
+	static_assert(sizeof(extentHeader_t) == 16U);
+
+	struct extentRecord_t final
+	{
+		uint32_t offset{};
+		uint32_t length{};
+		extentKind_t kind{};
+		uint8_t fillValue{};
+		uint16_t reserved{};
+	};
+	static_assert(sizeof(extentRecord_t) == 12U);
+
+	/*!
+	 * Takes the data read from a Flash chip in order, a block at a time, and stores it to the
+	 * output file in the requested format. Blocks are only ever elided whole, so the block size
+	 * used for reading the chip is the granularity of the holes and fill extents made.
+	 */
+	struct imageWriter_t final
+	{
+	private:
+		substrate::fd_t &file;
+		imageFormat_t format;
+		uint32_t offset{};
+		uint32_t bytesStored{};
+		uint32_t extentCount{};
+		std::optional<extentRecord_t> extent{};
+		substrate::off_t extentPosition{};
+
+		[[nodiscard]] bool writeData(const void *data, uint32_t length) noexcept;
+		[[nodiscard]] bool writeExtent(const void *data, uint32_t length) noexcept;
+		[[nodiscard]] bool closeExtent() noexcept;
+
+	public:
+		imageWriter_t(substrate::fd_t &file_, imageFormat_t format_) noexcept : file{file_}, format{format_} { }
+
+		[[nodiscard]] bool begin() noexcept;
+		[[nodiscard]] bool write(const void *data, size_t length) noexcept;
+		template<typename T, size_t N> [[nodiscard]] bool write(const std::array<T, N> &data) noexcept
+			{ return write(data.data(), N * sizeof(T)); }
+		[[nodiscard]] bool finish() noexcept;
+
+		[[nodiscard]] imageFormat_t imageFormat() const noexcept { return format; }
+		[[nodiscard]] uint32_t imageLength() const noexcept { return offset; }
+		// How many bytes of the image actually had to be written out as data
+		[[nodiscard]] uint32_t storedLength() const noexcept { return bytesStored; }
+	};
+
+	[[nodiscard]] std::optional<uint8_t> uniformValue(const void *data, size_t length) noexcept;
+} // namespace flashprog::image
+
+#endif /*IMAGE_IMAGE_WRITER_HXX*/
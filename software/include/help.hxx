@@ -17,21 +17,44 @@ Usage:
 Options:
 	--version       Print the version information for flashprog
 	-h, --help      Prints this help message
+	--emulate file  Use an emulated programmer in place of real hardware, with the
+	                target Flash chip backed by the given file
+	--record file   Record all traffic between flashprog and the programmer to the given
+	                trace file for later analysis with flashtrace. The programmer's event log
+	                is drained into the trace at the end of the operation
+	--replay file   Use the programmer responses recorded in the given trace file in place
+	                of real hardware
+	--spi-clock kHz Run the external SPI bus at no faster than the given clock in place of the
+	                clock the programmer trained for the target Flash chip when selecting it
 
 Operations:
 	listDevices     Lists the available SPIFlashProgrammers attached to your system
 	                (This is the default if no operation is given)
-	list            Lists the available Flash chips a given SPIFlashProgrammer can see
+	list            Lists the available Flash chips a given SPIFlashProgrammer can see, along with
+	                the timings flashprog's chip database has for them. Chips can be added to the
+	                database in ~/.config/flashprog/chips.db, in the same format as the built-in one
 	read            Reads the contents of a specific Flash chip into the requested file
 	write           Writes the contents of the requested file into a specific Flash chip
 	verifiedWrite   Does the same as write, but verifies the contents of the Flash chip after writing
 	erase           Performs a full chip erases on the requested Flash chip
 	sfdp            Reads and dumps the SFDP data from the requested Flash chip
+	fill            Fills a range of the requested Flash chip with a repeating pattern generated by
+	                the programmer, so no data has to be sent over USB
+	stats           Displays the performance counters of a given SPIFlashProgrammer
+	benchmark       Times reading a specific Flash chip using 8- and 16-bit SPI frames
+	clock           Displays the external SPI bus clock the programmer trained for a specific
+	                Flash chip, along with the fastest reliable and rated clocks for it
+	events          Drains the event log of a given SPIFlashProgrammer into a Chrome trace-event
+	                JSON file. When recording with --record, the event log is also captured into
+	                the trace at the end of each operation for use with flashtrace chrome
 
-Options for list, read, write, verifiedWrite, erase and sfdp:
+Options for list, read, write, verifiedWrite, erase, sfdp, fill, stats, benchmark, clock and events:
 	--device        The SPIFlashProgrammer to use for the operation
 
-Options for read, write, verifiedWrite, erase and sfdp:
+Options for stats:
+	--reset         Reset the performance counters once they have been read
+
+Options for read, write, verifiedWrite, erase, sfdp, fill, benchmark and clock:
 	--chip bus:N    Specifies what Flash chip on which bus you want to target.
 	                The chip specification works as follows:
 	                'bus' can be one of 'int' or 'ext' representing the internal (on-chip)
@@ -40,7 +63,51 @@ Options for read, write, verifiedWrite, erase and sfdp:
 	                listDevices operation
 
 Options for read, write and verifiedWrite:
-	file            The local file to use for the operation
+	file            The local file to use for the operation. Giving - has read write to stdout and
+	                write read from stdin, so chip contents can be piped to and from other tools
+	--compress      Compress the data sent over USB, which speeds up transfers of images holding
+	                erased or repetitive data. Falls back to uncompressed transfers if the
+	                programmer doesn't support them
+	--bad-blocks strategy
+	                How to lay the image out over a NAND chip's bad blocks, which the programmer
+	                scans for from their factory markers and the chip's bad block look-up table.
+	                'skip' (the default) puts the image in the good blocks in order, skipping the
+	                bad ones. 'reserve' keeps the image's blocks where they are, standing in good
+	                blocks from a reserve area at the end of the chip for the bad ones. 'none'
+	                treats the chip as a flat array, and refuses to write over bad blocks
+	--reserve-blocks N
+	                How many blocks at the end of the chip make up the reserve area for
+	                --bad-blocks=reserve (defaults to 2% of the chip)
+
+Options for write and verifiedWrite:
+	--length N      How many bytes of the file to write. Without this, writes from stdin erase and
+	                write the chip a window at a time as the data arrives, until stdin ends
+	--sparse        The file is a sparse image from read --sparse, whose holes stand for erased bytes
+	--extents       The file is a flashprog extent list from read --extents
+	--force         Write the image even if the chip already holds it. Chips with a unique ID have
+	                the last image written to them recorded in a cache in ~/.cache/flashprog, and
+	                writing that image again is skipped once a checksum of some of the chip (or all
+	                of it for verifiedWrite) taken by the programmer confirms it's still there
+
+Options for read:
+	--trim          Stop reading at the last used byte of the chip rather than reading the
+	                trailing erased bytes, which the programmer finds without sending them over USB
+	--sparse        Write the file as a sparse file, seeking over erased blocks so the file system
+	                can leave holes for them. The holes read back as 0x00's to other tools, so
+	                write the file back with write --sparse, which expands them into erased bytes
+	--extents       Write the file as a flashprog extent list rather than a raw image. Blocks all of
+	                one byte value, such as erased 0xFF's, are stored as just that value
+
+Options for fill:
+	--pattern hex   The pattern to fill with, given as up to 16 bytes of hex (eg, A5 or DEADBEEF)
+	--address N     The byte address to start the fill at (defaults to 0)
+	--length N      How many bytes to fill (defaults to the rest of the chip)
+	--verify        Verify the contents of the Flash chip after filling
+	--no-erase      Don't erase the range before filling it. Without this, the range must
+	                start and end on erase page boundaries
+
+Options for events:
+	file            The Chrome trace-event JSON file to write the events to
 
 This utility is licensed under BSD-3-Clase
 Report bugs using https://github.com/bad-alloc-heavy-industries/flashprog/issues)"sv
@@ -4,91 +4,63 @@
 
 #include <string_view>
 #include <utility>
+#include <memory>
 #include <libusb.h>
 #include <substrate/console>
+#include <substrate/utility>
+#include "usbTransport.hxx"
 
 using namespace std::literals::string_view_literals;
 using substrate::console;
 
-enum class endpointDir_t : uint8_t
-{
-	controllerOut = 0x00U,
-	controllerIn = 0x80U
-};
-
-constexpr static const uint8_t endpointDirMask{0x7F};
-constexpr inline uint8_t endpointAddress(const endpointDir_t dir, const uint8_t number) noexcept
-	{ return uint8_t(dir) | (number & endpointDirMask); }
-
-enum class request_t : uint8_t
-{
-	typeStandard = 0x00,
-	typeClass = 0x20U,
-	typeVendor = 0x40U
-};
-
-enum class recipient_t : uint8_t
-{
-	device = 0,
-	interface = 1,
-	endpoint = 2,
-	other = 3
-};
-
-struct requestType_t final
+struct libusbTransport_t final : usbTransport_t
 {
 private:
-	uint8_t value{};
+	libusb_device_handle *device{nullptr};
 
 public:
-	constexpr requestType_t() noexcept = default;
-	constexpr requestType_t(const recipient_t recipient, const request_t type) noexcept :
-		requestType_t{recipient, type, endpointDir_t::controllerOut} { }
-	constexpr requestType_t(const recipient_t recipient, const request_t type, const endpointDir_t direction) noexcept :
-		value(static_cast<uint8_t>(recipient) | static_cast<uint8_t>(type) | static_cast<uint8_t>(direction)) { }
+	libusbTransport_t(libusb_device_handle *const device_) noexcept : device{device_}
+		{ autoDetachKernelDriver(true); }
+	libusbTransport_t(const libusbTransport_t &) = delete;
+	libusbTransport_t(libusbTransport_t &&) = delete;
+	libusbTransport_t &operator =(const libusbTransport_t &) = delete;
+	libusbTransport_t &operator =(libusbTransport_t &&) = delete;
 
-	void recipient(const recipient_t recipient) noexcept
+	~libusbTransport_t() noexcept final
 	{
-		value &= 0xE0U;
-		value |= static_cast<uint8_t>(recipient);
+		if (device)
+			libusb_close(device);
 	}
 
-	void type(const request_t type) noexcept
+	// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+	void autoDetachKernelDriver(bool autoDetach) const noexcept
 	{
-		value &= 0x9FU;
-		value |= static_cast<uint8_t>(type);
+		if (const auto result{libusb_set_auto_detach_kernel_driver(device, autoDetach)}; result)
+			console.warning("Automatic detach of kernel driver not supported on this platform"sv);
 	}
 
-	void dir(const endpointDir_t direction) noexcept
+	[[nodiscard]] bool claimInterface(const int32_t interfaceNumber) noexcept final
 	{
-		value &= 0x7FU;
-		value |= static_cast<uint8_t>(direction);
+		const auto result{libusb_claim_interface(device, interfaceNumber)};
+		if (result)
+			console.error("Failed to claim interface "sv, interfaceNumber, ": "sv, libusb_error_name(result));
+		return !result;
 	}
 
-	[[nodiscard]] recipient_t recipient() const noexcept
-		{ return static_cast<recipient_t>(value & 0x1FU); }
-	[[nodiscard]] request_t type() const noexcept
-		{ return static_cast<request_t>(value & 0x60U); }
-	[[nodiscard]] endpointDir_t dir() const noexcept
-		{ return static_cast<endpointDir_t>(value & 0x80U); }
-	[[nodiscard]] operator uint8_t() const noexcept { return value; }
-};
-
-struct usbDeviceHandle_t final
-{
-private:
-	libusb_device_handle *device{nullptr};
+	[[nodiscard]] bool releaseInterface(const int32_t interfaceNumber) noexcept final
+	{
+		const auto result{libusb_release_interface(device, interfaceNumber)};
+		if (result)
+			console.error("Failed to release interface "sv, interfaceNumber, ": "sv, libusb_error_name(result));
+		return !result;
+	}
 
-	// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
-	[[nodiscard]] bool interruptTransfer(const uint8_t endpoint, const void *const bufferPtr,
-		const int32_t bufferLen) const noexcept
+	[[nodiscard]] bool interruptTransfer(const uint8_t endpoint, void *const bufferPtr,
+		const int32_t bufferLen) noexcept final
 	{
-		// The const-cast here is required becasue libusb is not const-correct. It is UB, but we cannot avoid it.
 		const auto result
 		{
-			libusb_interrupt_transfer(device, endpoint,
-				// NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
-				const_cast<uint8_t *>(static_cast<const uint8_t *>(bufferPtr)), bufferLen, nullptr, 0)
+			libusb_interrupt_transfer(device, endpoint, static_cast<uint8_t *>(bufferPtr), bufferLen, nullptr, 0)
 		};
 
 		if (result)
@@ -103,16 +75,12 @@ private:
 		return !result;
 	}
 
-	// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
-	[[nodiscard]] bool bulkTransfer(const uint8_t endpoint, const void *const bufferPtr,
-		const int32_t bufferLen) const noexcept
+	[[nodiscard]] bool bulkTransfer(const uint8_t endpoint, void *const bufferPtr,
+		const int32_t bufferLen) noexcept final
 	{
-		// The const-cast here is required becasue libusb is not const-correct. It is UB, but we cannot avoid it.
 		const auto result
 		{
-			libusb_bulk_transfer(device, endpoint,
-				// NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
-				const_cast<uint8_t *>(static_cast<const uint8_t *>(bufferPtr)), bufferLen, nullptr, 0)
+			libusb_bulk_transfer(device, endpoint, static_cast<uint8_t *>(bufferPtr), bufferLen, nullptr, 0)
 		};
 		if (result)
 		{
@@ -126,16 +94,13 @@ private:
 		return !result;
 	}
 
-	// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
 	[[nodiscard]] bool controlTransfer(const requestType_t requestType, const uint8_t request, const uint16_t value,
-		const uint16_t index, const void *const bufferPtr, const uint16_t bufferLen) const noexcept
+		const uint16_t index, void *const bufferPtr, const uint16_t bufferLen) noexcept final
 	{
-		// The const-cast here is required becasue libusb is not const-correct. It is UB, but we cannot avoid it.
 		const auto result
 		{
 			libusb_control_transfer(device, requestType, request, value, index,
-				// NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
-				const_cast<uint8_t *>(static_cast<const uint8_t *>(bufferPtr)), bufferLen, 0)
+				static_cast<uint8_t *>(bufferPtr), bufferLen, 0)
 		};
 		if (result < 0)
 		{
@@ -149,37 +114,45 @@ private:
 		}
 		return result == bufferLen;
 	}
+};
 
-public:
-	usbDeviceHandle_t() noexcept = default;
-	usbDeviceHandle_t(libusb_device_handle *const device_) noexcept : device{device_}
-		{ autoDetachKernelDriver(true); }
-	[[nodiscard]] bool valid() const noexcept { return device; }
+struct usbDeviceHandle_t final
+{
+private:
+	std::unique_ptr<usbTransport_t> transport{};
 
-	// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
-	void autoDetachKernelDriver(bool autoDetach) const noexcept
+	// The const-casts in these are required because the transports are not const-correct
+	// as they have to handle both directions of transfer. It is UB, but we cannot avoid it.
+	[[nodiscard]] bool interruptTransfer(const uint8_t endpoint, const void *const bufferPtr,
+		const int32_t bufferLen) const noexcept
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+		{ return transport->interruptTransfer(endpoint, const_cast<void *>(bufferPtr), bufferLen); }
+
+	[[nodiscard]] bool bulkTransfer(const uint8_t endpoint, const void *const bufferPtr,
+		const int32_t bufferLen) const noexcept
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+		{ return transport->bulkTransfer(endpoint, const_cast<void *>(bufferPtr), bufferLen); }
+
+	[[nodiscard]] bool controlTransfer(const requestType_t requestType, const uint8_t request, const uint16_t value,
+		const uint16_t index, const void *const bufferPtr, const uint16_t bufferLen) const noexcept
 	{
-		if (const auto result{libusb_set_auto_detach_kernel_driver(device, autoDetach)}; result)
-			console.warning("Automatic detach of kernel driver not supported on this platform"sv);
+		return transport->controlTransfer(requestType, request, value, index,
+			// NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+			const_cast<void *>(bufferPtr), bufferLen);
 	}
 
-	// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+public:
+	usbDeviceHandle_t() noexcept = default;
+	usbDeviceHandle_t(std::unique_ptr<usbTransport_t> &&transport_) noexcept : transport{std::move(transport_)} { }
+	[[nodiscard]] bool valid() const noexcept { return bool(transport); }
+	// Gives up ownership of the transport so it may be wrapped by another (such as for tracing)
+	[[nodiscard]] std::unique_ptr<usbTransport_t> releaseTransport() noexcept { return std::move(transport); }
+
 	[[nodiscard]] bool claimInterface(const int32_t interfaceNumber) const noexcept
-	{
-		const auto result{libusb_claim_interface(device, interfaceNumber)};
-		if (result)
-			console.error("Failed to claim interface "sv, interfaceNumber, ": "sv, libusb_error_name(result));
-		return !result;
-	}
+		{ return transport->claimInterface(interfaceNumber); }
 
-	// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
 	[[nodiscard]] bool releaseInterface(const int32_t interfaceNumber) const noexcept
-	{
-		const auto result{libusb_release_interface(device, interfaceNumber)};
-		if (result)
-			console.error("Failed to release interface "sv, interfaceNumber, ": "sv, libusb_error_name(result));
-		return !result;
-	}
+		{ return transport->releaseInterface(interfaceNumber); }
 
 	[[nodiscard]] bool writeInterrupt(const uint8_t endpoint, const void *const bufferPtr, const int32_t bufferLen) const noexcept
 		{ return interruptTransfer(endpointAddress(endpointDir_t::controllerOut, endpoint), bufferPtr, bufferLen); }
@@ -276,7 +249,13 @@ public:
 			console.error("Failed to open requested device: "sv, libusb_error_name(result));
 			return {};
 		}
-		return {handle};
+		auto transport{substrate::make_unique_nothrow<libusbTransport_t>(handle)};
+		if (!transport)
+		{
+			libusb_close(handle);
+			return {};
+		}
+		return {std::move(transport)};
 	}
 
 	void swap(usbDevice_t &other) noexcept
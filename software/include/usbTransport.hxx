@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#ifndef USB_TRANSPORT_HXX
+#define USB_TRANSPORT_HXX
+
+#include <cstdint>
+
+enum class endpointDir_t : uint8_t
+{
+	controllerOut = 0x00U,
+	controllerIn = 0x80U
+};
+
+constexpr static const uint8_t endpointDirMask{0x7F};
+constexpr inline uint8_t endpointAddress(const endpointDir_t dir, const uint8_t number) noexcept
+	{ return uint8_t(dir) | (number & endpointDirMask); }
+
+enum class request_t : uint8_t
+{
+	typeStandard = 0x00,
+	typeClass = 0x20U,
+	typeVendor = 0x40U
+};
+
+enum class recipient_t : uint8_t
+{
+	device = 0,
+	interface = 1,
+	endpoint = 2,
+	other = 3
+};
+
+struct requestType_t final
+{
+private:
+	uint8_t value{};
+
+public:
+	constexpr requestType_t() noexcept = default;
+	constexpr requestType_t(const recipient_t recipient, const request_t type) noexcept :
+		requestType_t{recipient, type, endpointDir_t::controllerOut} { }
+	constexpr requestType_t(const recipient_t recipient, const request_t type, const endpointDir_t direction) noexcept :
+		value(static_cast<uint8_t>(recipient) | static_cast<uint8_t>(type) | static_cast<uint8_t>(direction)) { }
+
+	void recipient(const recipient_t recipient) noexcept
+	{
+		value &= 0xE0U;
+		value |= static_cast<uint8_t>(recipient);
+	}
+
+	void type(const request_t type) noexcept
+	{
+		value &= 0x9FU;
+		value |= static_cast<uint8_t>(type);
+	}
+
+	void dir(const endpointDir_t direction) noexcept
+	{
+		value &= 0x7FU;
+		value |= static_cast<uint8_t>(direction);
+	}
+
+	[[nodiscard]] recipient_t recipient() const noexcept
+		{ return static_cast<recipient_t>(value & 0x1FU); }
+	[[nodiscard]] request_t type() const noexcept
+		{ return static_cast<request_t>(value & 0x60U); }
+	[[nodiscard]] endpointDir_t dir() const noexcept
+		{ return static_cast<endpointDir_t>(value & 0x80U); }
+	[[nodiscard]] operator uint8_t() const noexcept { return value; }
+};
+
+/*!
+ * Defines the interface usbDeviceHandle_t uses to actually move data to and from a programmer.
+ * This is implemented by libusbTransport_t for real hardware, and by the emulated programmer
+ * for exercising the host side of the protocol without any hardware attached.
+ *
+ * Endpoint numbers passed to the transfer functions are full endpoint addresses
+ * (that is, including the direction bit).
+ */
+struct usbTransport_t
+{
+	usbTransport_t() noexcept = default;
+	usbTransport_t(const usbTransport_t &) = delete;
+	usbTransport_t(usbTransport_t &&) = delete;
+	virtual ~usbTransport_t() noexcept = default;
+	usbTransport_t &operator =(const usbTransport_t &) = delete;
+	usbTransport_t &operator =(usbTransport_t &&) = delete;
+
+	[[nodiscard]] virtual bool claimInterface(int32_t interfaceNumber) noexcept = 0;
+	[[nodiscard]] virtual bool releaseInterface(int32_t interfaceNumber) noexcept = 0;
+	[[nodiscard]] virtual bool interruptTransfer(uint8_t endpoint, void *bufferPtr, int32_t bufferLen) noexcept = 0;
+	[[nodiscard]] virtual bool bulkTransfer(uint8_t endpoint, void *bufferPtr, int32_t bufferLen) noexcept = 0;
+	[[nodiscard]] virtual bool controlTransfer(requestType_t requestType, uint8_t request, uint16_t value,
+		uint16_t index, void *bufferPtr, uint16_t bufferLen) noexcept = 0;
+};
+
+#endif /*USB_TRANSPORT_HXX*/
@@ -0,0 +1,159 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <numeric>
+#include <iterator>
+#include <thread>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <substrate/console>
+#include <fmt/core.h>
+#include "badBlocks.hxx"
+#include "usbProtocol.hxx"
+
+using namespace std::literals::string_view_literals;
+using namespace std::literals::chrono_literals;
+using substrate::console;
+using namespace flashProto;
+
+namespace flashprog::nand
+{
+	bool badBlockMap_t::isBad(const uint32_t block) const noexcept
+		{ return std::binary_search(badBlocks.begin(), badBlocks.end(), block); }
+
+	void badBlockMap_t::display() const noexcept try
+	{
+		if (badBlocks.empty())
+		{
+			console.info("\t\tBad blocks - none of "sv, blockCount);
+			return;
+		}
+		std::string blockList{};
+		for (const auto block : badBlocks)
+			blockList += fmt::format(blockList.empty() ? "{}" : ", {}", block);
+		console.info("\t\tBad blocks - "sv, badBlocks.size(), " of "sv, blockCount, ": "sv, blockList);
+	}
+	catch (const std::exception &)
+	{
+		return;
+	}
+
+	bool blockLayout_t::isFlat() const noexcept
+	{
+		for (size_t block{}; block < blocks.size(); ++block)
+		{
+			if (blocks[block] != block)
+				return false;
+		}
+		return true;
+	}
+
+	uint32_t blockLayout_t::physicalAddress(const uint32_t address) const noexcept
+		{ return (blocks[address / blockSize] * blockSize) + (address % blockSize); }
+
+	std::vector<extent_t> blockLayout_t::extents(const uint32_t address, const uint32_t length) const
+	{
+		std::vector<extent_t> result{};
+		for (uint32_t offset{}; offset < length;)
+		{
+			const auto logical{address + offset};
+			const auto physical{physicalAddress(logical)};
+			const auto amount{std::min(blockSize - (logical % blockSize), length - offset)};
+			// Blocks that follow on from each other on the chip make for one longer run
+			if (!result.empty() && result.back().physicalAddress + result.back().length == physical)
+				result.back().length += amount;
+			else
+				result.push_back({logical, physical, amount});
+			offset += amount;
+		}
+		return result;
+	}
+
+	std::optional<badBlockMap_t> readBadBlockMap(const usbDeviceHandle_t &device, const uint32_t blockSize,
+		const bool rescan)
+	{
+		if (!requests::badBlocks_t{rescan}.write(device, 0))
+			return std::nullopt;
+		responses::badBlocks_t result{};
+		while (!result.complete)
+		{
+			std::this_thread::sleep_for(1ms);
+			if (!requests::badBlocks_t::read(device, 0, 0U, result))
+				return std::nullopt;
+		}
+		if (result.complete == 4U)
+			console.error("The chip has more than the "sv, result.badCount,
+				" bad blocks the programmer can keep track of"sv);
+		if (result.complete != 1U)
+			return std::nullopt;
+
+		// The first chunk of the list came back with the scan's completion, so fetch the rest after it
+		badBlockMap_t map{blockSize, result.blockCount, {}};
+		map.badBlocks.reserve(result.badCount);
+		while (true)
+		{
+			std::copy_n(result.blocks.begin(), std::min<size_t>(result.count, result.blocks.size()),
+				std::back_inserter(map.badBlocks));
+			if (map.badBlocks.size() >= result.badCount || !result.count)
+				break;
+			if (!requests::badBlocks_t::read(device, 0, static_cast<uint16_t>(map.badBlocks.size()), result))
+				return std::nullopt;
+		}
+		if (map.badBlocks.size() != result.badCount)
+			return std::nullopt;
+		return map;
+	}
+
+	blockLayout_t flatLayout(const uint32_t blockSize, const uint32_t blockCount)
+	{
+		blockLayout_t layout{blockSize, std::vector<uint32_t>(blockCount)};
+		std::iota(layout.blocks.begin(), layout.blocks.end(), 0U);
+		return layout;
+	}
+
+	std::optional<blockLayout_t> layoutFor(const badBlockMap_t &map, const strategy_t strategy,
+		const uint32_t reserveBlocks)
+	{
+		if (strategy == strategy_t::none)
+			return flatLayout(map.blockSize, map.blockCount);
+
+		blockLayout_t layout{map.blockSize, {}};
+		if (strategy == strategy_t::skip)
+		{
+			for (uint32_t block{}; block < map.blockCount; ++block)
+			{
+				if (!map.isBad(block))
+					layout.blocks.push_back(block);
+			}
+			return layout;
+		}
+
+		if (reserveBlocks >= map.blockCount)
+		{
+			console.error("A reserve area of "sv, reserveBlocks, " blocks leaves none of the chip's "sv,
+				map.blockCount, " blocks for the image"sv);
+			return std::nullopt;
+		}
+		// Each bad block before the reserve area is stood in for by the next good block of the reserve area
+		const auto userBlocks{map.blockCount - reserveBlocks};
+		auto spareBlock{userBlocks};
+		for (uint32_t block{}; block < userBlocks; ++block)
+		{
+			if (!map.isBad(block))
+			{
+				layout.blocks.push_back(block);
+				continue;
+			}
+			while (spareBlock < map.blockCount && map.isBad(spareBlock))
+				++spareBlock;
+			if (spareBlock == map.blockCount)
+			{
+				console.error("The "sv, reserveBlocks, " block reserve area does not have enough good blocks "
+					"to stand in for the chip's bad ones"sv);
+				return std::nullopt;
+			}
+			layout.blocks.push_back(spareBlock++);
+		}
+		return layout;
+	}
+} // namespace flashprog::nand
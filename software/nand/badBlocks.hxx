@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#ifndef NAND_BAD_BLOCKS_HXX
+#define NAND_BAD_BLOCKS_HXX
+
+#include <cstdint>
+#include <vector>
+#include <optional>
+#include "usbContext.hxx"
+
+namespace flashprog::nand
+{
+	// How to lay an image out over a NAND that has bad blocks
+	enum class strategy_t : uint8_t
+	{
+		// Address the chip as a flat array, bad blocks and all
+		none,
+		// Put the image in the good blocks in order, skipping over the bad ones
+		skip,
+		// Keep the image's blocks where they are, swapping out bad ones for good ones from the end of the chip
+		reserve,
+	};
+
+	// The bad blocks of a NAND, as the programmer scanned for them
+	struct badBlockMap_t final
+	{
+		uint32_t blockSize{};
+		uint32_t blockCount{};
+		// In ascending order
+		std::vector<uint32_t> badBlocks{};
+
+		[[nodiscard]] bool isBad(uint32_t block) const noexcept;
+		void display() const noexcept;
+	};
+
+	// A run of the image that lives in one contiguous run of the chip
+	struct extent_t final
+	{
+		uint32_t logicalAddress{};
+		uint32_t physicalAddress{};
+		uint32_t length{};
+	};
+
+	// Which block of the chip each block of the image lives in
+	struct blockLayout_t final
+	{
+		uint32_t blockSize{};
+		std::vector<uint32_t> blocks{};
+
+		[[nodiscard]] uint32_t capacity() const noexcept { return blockSize * static_cast<uint32_t>(blocks.size()); }
+		[[nodiscard]] bool isFlat() const noexcept;
+		[[nodiscard]] uint32_t physicalAddress(uint32_t address) const noexcept;
+		// Split length bytes of the image from address on into the runs of the chip they live in
+		[[nodiscard]] std::vector<extent_t> extents(uint32_t address, uint32_t length) const;
+	};
+
+	// The reserve area is, unless told otherwise, 2% of the chip - what NAND makers allow to go bad over its life
+	[[nodiscard]] constexpr inline uint32_t defaultReserveBlocks(const uint32_t blockCount) noexcept
+		{ return (blockCount + 49U) / 50U; }
+
+	// Have the programmer scan the targeted NAND for its bad blocks, or hand back what it found when it last did
+	[[nodiscard]] std::optional<badBlockMap_t> readBadBlockMap(const usbDeviceHandle_t &device, uint32_t blockSize,
+		bool rescan = false);
+	// The layout of a chip that has no bad blocks to work around
+	[[nodiscard]] blockLayout_t flatLayout(uint32_t blockSize, uint32_t blockCount);
+	// Lay the image out over the chip's good blocks as the strategy asks, failing if the reserve area is too small
+	[[nodiscard]] std::optional<blockLayout_t> layoutFor(const badBlockMap_t &map, strategy_t strategy,
+		uint32_t reserveBlocks);
+} // namespace flashprog::nand
+
+#endif /*NAND_BAD_BLOCKS_HXX*/
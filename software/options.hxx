@@ -2,6 +2,7 @@
 #include <substrate/command_line/options>
 #include <substrate/conversions>
 #include "usbProtocol.hxx"
+#include "nand/badBlocks.hxx"
 
 namespace flashprog
 {
@@ -40,6 +41,55 @@ namespace flashprog
 		return chip_t{bus[0] == 'i' ? chipBus_t::internal : chipBus_t::external, static_cast<uint8_t>(number)};
 	}
 
+	struct fillPattern_t
+	{
+		std::array<uint8_t, flashProto::requests::maxFillPattern> bytes{};
+		uint8_t length{};
+	};
+
+	[[nodiscard]] static inline std::optional<uint8_t> hexDigit(const char digit) noexcept
+	{
+		if (digit >= '0' && digit <= '9')
+			return uint8_t(digit - '0');
+		if (digit >= 'a' && digit <= 'f')
+			return uint8_t(digit - 'a' + 10);
+		if (digit >= 'A' && digit <= 'F')
+			return uint8_t(digit - 'A' + 10);
+		return std::nullopt;
+	}
+
+	static inline std::optional<std::any> fillPatternParser(const std::string_view &pattern) noexcept
+	{
+		auto value{pattern};
+		// Allow the pattern to be written with or without a leading "0x"
+		if (value.size() > 2 && value[0] == '0' && (value[1] == 'x' || value[1] == 'X'))
+			value.remove_prefix(2);
+		// The pattern must be a whole number of bytes, and fit in a fill request
+		if (value.empty() || value.size() % 2U || value.size() / 2U > flashProto::requests::maxFillPattern)
+			return std::nullopt;
+		fillPattern_t result{};
+		for (size_t idx{}; idx < value.size(); idx += 2U)
+		{
+			const auto upper{hexDigit(value[idx])};
+			const auto lower{hexDigit(value[idx + 1U])};
+			if (!upper || !lower)
+				return std::nullopt;
+			result.bytes[result.length++] = uint8_t((*upper << 4U) | *lower);
+		}
+		return result;
+	}
+
+	static inline std::optional<std::any> badBlockStrategyParser(const std::string_view &value) noexcept
+	{
+		if (value == "skip"sv)
+			return nand::strategy_t::skip;
+		if (value == "reserve"sv)
+			return nand::strategy_t::reserve;
+		if (value == "none"sv)
+			return nand::strategy_t::none;
+		return std::nullopt;
+	}
+
 	constexpr static auto deviceOption
 	{
 		option_t
@@ -72,12 +122,141 @@ namespace flashprog
 		options
 		(
 			deviceOptions,
-			option_t{optionValue_t{"file"sv}, "The local file to use for the operation"sv}
+			option_t{optionValue_t{"file"sv}, "The local file to use for the operation, or - for stdin/stdout"sv}
 				.valueType(optionValueType_t::path).required()
 		)
 	};
 
-	constexpr static auto listOptions{options(deviceOption)};
+	constexpr static auto compressOption
+	{
+		option_t
+		{
+			"--compress"sv,
+			"Compress the data sent over USB, falling back to uncompressed transfers if the\n"
+			"programmer doesn't support them"sv
+		}
+	};
+
+	constexpr static auto badBlockOptions
+	{
+		options
+		(
+			option_t
+			{
+				"--bad-blocks"sv,
+				"How to lay the image out over a NAND chip's bad blocks - one of 'skip' (the default),\n"
+				"'reserve' or 'none'"sv
+			}.takesParameter(optionValueType_t::userDefined, badBlockStrategyParser),
+			option_t
+			{
+				"--reserve-blocks"sv,
+				"How many blocks at the end of the chip make up the reserve area for --bad-blocks=reserve"sv
+			}.takesParameter(optionValueType_t::unsignedInt)
+		)
+	};
+
+	constexpr static auto fillOptions
+	{
+		options
+		(
+			deviceOptions,
+			option_t
+			{
+				"--pattern"sv,
+				"The pattern to fill with, given as up to 16 bytes of hex (eg, A5 or DEADBEEF)"sv
+			}.takesParameter(optionValueType_t::userDefined, fillPatternParser).required(),
+			option_t{"--address"sv, "The byte address to start the fill at (defaults to 0)"sv}
+				.takesParameter(optionValueType_t::unsignedInt),
+			option_t{"--length"sv, "How many bytes to fill (defaults to the rest of the chip)"sv}
+				.takesParameter(optionValueType_t::unsignedInt),
+			option_t{"--verify"sv, "Verify the contents of the Flash chip after filling"sv},
+			option_t
+			{
+				"--no-erase"sv,
+				"Don't erase the range before filling it. Without this, the range must start and end\n"
+				"on erase page boundaries"sv
+			}
+		)
+	};
+
+	constexpr static auto readOptions
+	{
+		options
+		(
+			fileOptions,
+			option_t
+			{
+				"--trim"sv,
+				"Stop reading at the last used byte of the chip rather than reading the trailing erased bytes"sv
+			},
+			option_t{"--sparse"sv, "Write the file as a sparse file, leaving holes for erased blocks"sv},
+			option_t
+			{
+				"--extents"sv,
+				"Write the file as an extent list, storing runs of a single byte value as just that value"sv
+			},
+			compressOption,
+			badBlockOptions
+		)
+	};
+
+	constexpr static auto writeOptions
+	{
+		options
+		(
+			fileOptions,
+			option_t
+			{
+				"--length"sv,
+				"How many bytes of the file to write (defaults to all of it, streaming stdin until it ends)"sv
+			}.takesParameter(optionValueType_t::unsignedInt),
+			option_t
+			{
+				"--sparse"sv,
+				"The file is a sparse image from read --sparse, its holes standing for erased bytes"sv
+			},
+			option_t{"--extents"sv, "The file is an extent list from read --extents"sv},
+			compressOption,
+			option_t
+			{
+				"--force"sv,
+				"Write the image even if the chip-state cache says the chip already holds it"sv
+			},
+			badBlockOptions
+		)
+	};
+
+	constexpr static auto listOptions
+	{
+		options
+		(
+			deviceOption,
+			option_t
+			{
+				"--rescan"sv,
+				"Have the programmer identify the chips afresh, for when one has been swapped since it last looked"sv
+			}
+		)
+	};
+
+	constexpr static auto statsOptions
+	{
+		options
+		(
+			deviceOption,
+			option_t{"--reset"sv, "Reset the performance counters once they have been read"sv}
+		)
+	};
+
+	constexpr static auto eventsOptions
+	{
+		options
+		(
+			deviceOption,
+			option_t{optionValue_t{"file"sv}, "The Chrome trace-event JSON file to write the events to"sv}
+				.valueType(optionValueType_t::path).required()
+		)
+	};
 
 	constexpr static auto actions
 	{
@@ -87,6 +266,7 @@ namespace flashprog
 				"listDevices"sv,
 				"Lists the available SPIFlashProgrammers attached to your system\n"
 				"(This is the default if no operation is given)"sv,
+				listOptions,
 			},
 			{
 				"list"sv,
@@ -96,17 +276,17 @@ namespace flashprog
 			{
 				"read"sv,
 				"Reads the contents of a specific Flash chip into the requested file"sv,
-				fileOptions,
+				readOptions,
 			},
 			{
 				"write"sv,
 				"Writes the contents of the requested file into a specific Flash chip"sv,
-				fileOptions,
+				writeOptions,
 			},
 			{
 				"verifiedWrite"sv,
 				"Does the same as write, but verifies the contents of the Flash chip after writing"sv,
-				fileOptions,
+				writeOptions,
 			},
 			{
 				"erase"sv,
@@ -118,6 +298,31 @@ namespace flashprog
 				"Read and display the SFDP (Serial Flash Discoverable Parameters) data for a specific Flash chip"sv,
 				deviceOptions,
 			},
+			{
+				"stats"sv,
+				"Displays the performance counters of a given SPIFlashProgrammer"sv,
+				statsOptions,
+			},
+			{
+				"benchmark"sv,
+				"Times reading a specific Flash chip using 8- and 16-bit SPI frames"sv,
+				deviceOptions,
+			},
+			{
+				"fill"sv,
+				"Fills a range of a specific Flash chip with a repeating pattern generated by the programmer"sv,
+				fillOptions,
+			},
+			{
+				"clock"sv,
+				"Displays the external SPI bus clock the programmer trained for a specific Flash chip"sv,
+				deviceOptions,
+			},
+			{
+				"events"sv,
+				"Drains the event log of a given SPIFlashProgrammer into a Chrome trace-event JSON file"sv,
+				eventsOptions,
+			},
 		})
 	};
 
@@ -127,6 +332,29 @@ namespace flashprog
 		(
 			option_t{optionFlagPair_t{"-h"sv, "--help"sv}, "Display this help message and exit"sv},
 			option_t{"--version"sv, "Display the version information for flashprog and exit"sv},
+			option_t
+			{
+				"--emulate"sv,
+				"Use an emulated programmer in place of real hardware, with the target Flash chip\n"
+				"backed by the given file (which is created if it does not exist)"sv
+			}.takesParameter(optionValueType_t::path),
+			option_t
+			{
+				"--record"sv,
+				"Record all traffic between flashprog and the programmer to the given trace file\n"
+				"for later analysis with flashtrace"sv
+			}.takesParameter(optionValueType_t::path),
+			option_t
+			{
+				"--replay"sv,
+				"Use the programmer responses recorded in the given trace file in place of real hardware"sv
+			}.takesParameter(optionValueType_t::path),
+			option_t
+			{
+				"--spi-clock"sv,
+				"Run the external SPI bus at no faster than the given clock (in kHz) in place of\n"
+				"the clock the programmer trained for the target Flash chip"sv
+			}.takesParameter(optionValueType_t::unsignedInt),
 			optionSet_t{"action"sv, actions}
 		)
 	};
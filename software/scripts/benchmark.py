@@ -0,0 +1,53 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: BSD-3-Clause
+from argparse import ArgumentParser
+from pathlib import Path
+from subprocess import run
+from tempfile import TemporaryDirectory
+from random import Random
+from sys import exit
+
+parser = ArgumentParser(
+	description = 'Exercises flashprog end-to-end against its emulated programmer and reports the throughput achieved',
+	allow_abbrev = False
+)
+parser.add_argument('flashprog', type = Path, help = 'Path to the flashprog binary to benchmark')
+parser.add_argument('--size', type = int, default = 1024 * 1024,
+	help = 'Number of bytes of test data to write to the emulated Flash chip')
+parser.add_argument('--chip', type = str, default = 'ext:0', help = 'The emulated Flash chip to operate on')
+args = parser.parse_args()
+
+def flashprog(backingFile, *arguments):
+	print('>>> flashprog', ' '.join(str(argument) for argument in arguments), flush = True)
+	result = run([args.flashprog, '--emulate', backingFile, *arguments])
+	if result.returncode != 0:
+		print(f'flashprog exited with code {result.returncode}')
+		exit(1)
+
+def readBack(backingFile, workDir, name):
+	readFile = workDir / name
+	flashprog(backingFile, 'read', '--chip', args.chip, readFile)
+	return readFile.read_bytes()
+
+with TemporaryDirectory() as workDir:
+	workDir = Path(workDir)
+	backingFile = workDir / 'flash.bin'
+	# Build a test image that is mostly random, but has a run of blank space in the middle
+	# to resemble a typical firmware image
+	generator = Random(0x5F1A5)
+	testData = bytearray(generator.getrandbits(8) for _ in range(args.size))
+	testData[args.size // 2:(args.size * 3) // 4] = b'\xFF' * ((args.size * 3) // 4 - args.size // 2)
+	testFile = workDir / 'input.bin'
+	testFile.write_bytes(testData)
+
+	flashprog(backingFile, 'sfdp', '--chip', args.chip)
+	flashprog(backingFile, 'write', '--chip', args.chip, testFile)
+	flashprog(backingFile, 'verifiedWrite', '--chip', args.chip, testFile)
+	if readBack(backingFile, workDir, 'written.bin')[:args.size] != testData:
+		print('Data read back from the emulated Flash chip did not match what was written')
+		exit(1)
+	flashprog(backingFile, 'erase', '--chip', args.chip)
+	if any(byte != 0xFF for byte in readBack(backingFile, workDir, 'erased.bin')):
+		print('Emulated Flash chip was not blank after erasing it')
+		exit(1)
+	print('Benchmark complete, all operations succeeded')
@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: BSD-3-Clause
+from argparse import ArgumentParser
+from pathlib import Path
+from subprocess import run
+from tempfile import TemporaryDirectory
+from random import Random
+from sys import exit
+
+parser = ArgumentParser(
+	description = 'Checks images read in each of flashprog\'s image formats write back to the emulated programmer intact',
+	allow_abbrev = False
+)
+parser.add_argument('flashprog', type = Path, help = 'Path to the flashprog binary to test')
+parser.add_argument('--size', type = int, default = 256 * 1024,
+	help = 'Number of bytes of test data to write to the emulated Flash chip')
+parser.add_argument('--chip', type = str, default = 'ext:0', help = 'The emulated Flash chip to operate on')
+args = parser.parse_args()
+
+def flashprog(backingFile, *arguments):
+	print('>>> flashprog', ' '.join(str(argument) for argument in arguments), flush = True)
+	result = run([args.flashprog, '--emulate', backingFile, *arguments])
+	if result.returncode != 0:
+		print(f'flashprog exited with code {result.returncode}')
+		exit(1)
+
+def check(condition, message):
+	if not condition:
+		print(message)
+		exit(1)
+
+with TemporaryDirectory() as workDir:
+	workDir = Path(workDir)
+	# Build a test image with runs of both erased space and 0x00's in it, ending in data so --trim keeps all of it
+	generator = Random(0x1A6E5)
+	testData = bytearray(generator.getrandbits(8) for _ in range(args.size))
+	testData[args.size // 8:args.size // 2] = b'\xFF' * (args.size // 2 - args.size // 8)
+	testData[(args.size * 5) // 8:(args.size * 3) // 4] = b'\x00' * ((args.size * 3) // 4 - (args.size * 5) // 8)
+	testData[-1] = 0x5A
+	testFile = workDir / 'input.bin'
+	testFile.write_bytes(testData)
+
+	sourceBacking = workDir / 'source.bin'
+	flashprog(sourceBacking, 'write', '--chip', args.chip, testFile)
+	rawFile = workDir / 'image.bin'
+	flashprog(sourceBacking, 'read', '--chip', args.chip, rawFile, '--trim')
+	check(rawFile.read_bytes() == testData, 'Raw image read back did not match what was written')
+
+	for format in ('sparse', 'extents'):
+		imageFile = workDir / f'image.{format}'
+		flashprog(sourceBacking, 'read', '--chip', args.chip, imageFile, '--trim', f'--{format}')
+		if format == 'extents':
+			check(imageFile.stat().st_size < len(testData), 'Extent list was not smaller than the raw image')
+
+		# Put the image on a fresh chip and check it reads back as the original data
+		targetBacking = workDir / f'target.{format}.bin'
+		flashprog(targetBacking, 'write', '--chip', args.chip, imageFile, f'--{format}')
+		readFile = workDir / f'readBack.{format}.bin'
+		flashprog(targetBacking, 'read', '--chip', args.chip, readFile, '--trim')
+		check(readFile.read_bytes() == testData, f'Image written back from --{format} did not match the original')
+	print('All image formats round-tripped intact')
@@ -0,0 +1,46 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: BSD-3-Clause
+from argparse import ArgumentParser
+from pathlib import Path
+from subprocess import run
+from tempfile import TemporaryDirectory
+from random import Random
+from sys import exit
+
+parser = ArgumentParser(
+	description = 'Checks flashprog\'s verifiedWrite programs and verifies images against the emulated programmer',
+	allow_abbrev = False
+)
+parser.add_argument('flashprog', type = Path, help = 'Path to the flashprog binary to test')
+parser.add_argument('--size', type = int, default = 64 * 1024 + 123,
+	help = 'Number of bytes of test data to write, which should not be a whole number of pages')
+parser.add_argument('--chip', type = str, default = 'ext:0', help = 'The emulated Flash chip to operate on')
+args = parser.parse_args()
+
+def flashprog(backingFile, *arguments):
+	print('>>> flashprog', ' '.join(str(argument) for argument in arguments), flush = True)
+	result = run([args.flashprog, '--emulate', backingFile, *arguments])
+	if result.returncode != 0:
+		print(f'flashprog exited with code {result.returncode}')
+		exit(1)
+
+def check(condition, message):
+	if not condition:
+		print(message)
+		exit(1)
+
+with TemporaryDirectory() as workDir:
+	workDir = Path(workDir)
+	backingFile = workDir / 'flash.bin'
+	generator = Random(0x7E51F)
+	# Write two different images in turn, so the second has to replace the first rather than landing on a blank chip
+	for image in range(2):
+		testData = bytes(generator.getrandbits(8) for _ in range(args.size))
+		testFile = workDir / f'input{image}.bin'
+		testFile.write_bytes(testData)
+
+		flashprog(backingFile, 'verifiedWrite', '--chip', args.chip, testFile)
+		readFile = workDir / f'readBack{image}.bin'
+		flashprog(backingFile, 'read', '--chip', args.chip, readFile)
+		check(readFile.read_bytes()[:args.size] == testData, f'Image {image} read back did not match what was verified')
+	print('Verified writes all succeeded')
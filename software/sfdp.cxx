@@ -1,4 +1,8 @@
 // SPDX-License-Identifier: BSD-3-Clause
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <utility>
 #include <string_view>
 #include <substrate/console>
 #include <substrate/index_sequence>
@@ -15,102 +19,547 @@ using substrate::indexSequence_t;
 using substrate::indexedIterator_t;
 using namespace flashProto;
 using flashprog::utils::humanReadableSize;
+namespace chipDB = flashprog::chipDB;
+namespace cache = flashprog::cache;
 
 namespace sfdp
 {
 	constexpr static uint32_t sfdpHeaderAddress{0U};
 	constexpr static uint32_t tableHeaderAddress{sizeof(sfdpHeader_t)};
+	// Nearly every chip's SFDP region fits in this, letting it be fetched in a single transfer
+	constexpr static size_t initialFetchLength{512U};
+	// The most SFDP data the programmer will return for a single request
+	constexpr static size_t maximumFetchLength{4096U};
+	// Parameter tables beyond this are ignored rather than fetching a chip's whole SFDP address space for them
+	constexpr static size_t maximumRegionLength{65536U};
 
 	constexpr static std::array<char, 4> sfdpMagic{{'S', 'F', 'D', 'P'}};
 	constexpr static uint16_t basicSPIParameterTable{0xFF00U};
+	constexpr static uint16_t sectorMapParameterTable{0xFF81U};
+	constexpr static uint16_t fourByteInstructionParameterTable{0xFF84U};
+	// Basic parameter tables from before JESD216A stop at DWord 9, without the timings or page size
+	constexpr static size_t timedTableLength{offsetof(basicParameterTable_t, suspendResume)};
+	// JESD216A brought the table up to 16 DWords, adding suspend/resume, quad enable and 4-byte addressing
+	constexpr static size_t jesd216ATableLength{offsetof(basicParameterTable_t, fastOctalOutput)};
+	// JESD216C added the octal fast reads in DWord 17
+	constexpr static size_t octalTableLength{offsetof(basicParameterTable_t, xspiModes)};
+	constexpr static uint32_t defaultPageSize{256U};
+	constexpr static uint8_t chipEraseOpcode{0xC7U};
+
+	// The dedicated 4-byte address instructions, in the order of their support bits in the 4BAIT
+	constexpr static std::array<std::string_view, 25> fourByteInstructionNames
+	{{
+		"1-1-1 read (13)"sv, "1-1-1 fast read (0C)"sv, "1-1-2 fast read (3C)"sv, "1-2-2 fast read (BC)"sv,
+		"1-1-4 fast read (6C)"sv, "1-4-4 fast read (EC)"sv, "1-1-1 page program (12)"sv,
+		"1-1-4 page program (34)"sv, "1-4-4 page program (3E)"sv, "erase type 1"sv, "erase type 2"sv,
+		"erase type 3"sv, "erase type 4"sv, "1-1-1 DTR read (0E)"sv, "1-2-2 DTR read (BE)"sv,
+		"1-4-4 DTR read (EE)"sv, "volatile sector lock read (E0)"sv, "volatile sector lock write (E1)"sv,
+		"non-volatile sector lock read (E2)"sv, "non-volatile sector lock write (E3)"sv,
+		"1-1-8 fast read (7C)"sv, "1-8-8 fast read (CC)"sv, "1-8-8 DTR read (FD)"sv,
+		"1-1-8 page program (84)"sv, "1-8-8 page program (8E)"sv,
+	}};
+
+	constexpr static std::array<std::string_view, 8> quadEnableDescriptions
+	{{
+		"no quad enable bit"sv,
+		"bit 1 of status register 2, which writing only status register 1 clears"sv,
+		"bit 6 of status register 1"sv,
+		"bit 7 of status register 2, written with 3E and read with 3F"sv,
+		"bit 1 of status register 2, written along with status register 1"sv,
+		"bit 1 of status register 2, read with 35 and written along with status register 1"sv,
+		"bit 1 of status register 2, read with 35 and written with 31"sv,
+		"reserved"sv,
+	}};
+
+	constexpr static std::array<std::string_view, 7> fourByteEntryDescriptions
+	{{
+		"instruction B7"sv, "write enable then B7"sv, "extended address register (C5/C8)"sv,
+		"bank register (17/16)"sv, "non-volatile configuration register (B1/B5)"sv,
+		"dedicated 4-byte instructions"sv, "always in 4-byte mode"sv,
+	}};
+
+	constexpr static std::array<std::string_view, 8> fourByteExitDescriptions
+	{{
+		"instruction E9"sv, "write enable then E9"sv, "extended address register (C5/C8)"sv,
+		"bank register (17/16)"sv, "non-volatile configuration register (B1/B5)"sv, "hardware reset"sv,
+		"software reset"sv, "power cycle"sv,
+	}};
 
 	[[nodiscard]] static bool sfdpRead(const usbDeviceHandle_t &device, const usbDataSource_t &dataSource,
 		const uint32_t address, void *const buffer, const size_t bufferLen)
 	{
 		return
-			requests::sfdp_t{}.write(device, dataSource.interface, bufferLen, address) &&
+			requests::sfdp_t{}.write(device, dataSource.interface, static_cast<uint16_t>(bufferLen), address) &&
 			device.readBulk(dataSource.endpoint, buffer, bufferLen);
 	}
 
-	template<typename T> [[nodiscard]] static bool sfdpRead(const usbDeviceHandle_t &device,
-		const usbDataSource_t &dataSource, const uint32_t address, T &buffer)
-			{ return sfdpRead(device, dataSource, address, &buffer, sizeof(T)); }
+	// Pull a structure out of the SFDP region, with any of it past length or the end of the region left zeroed
+	template<typename T> [[nodiscard]] static T extract(const std::vector<uint8_t> &data, const size_t address,
+		const size_t length = sizeof(T)) noexcept
+	{
+		T result{};
+		if (address < data.size())
+			std::memcpy(&result, data.data() + address, std::min({length, sizeof(T), data.size() - address}));
+		return result;
+	}
 
-	static void displayHeader(const sfdpHeader_t &header)
+	[[nodiscard]] static size_t headersLength(const std::vector<uint8_t> &data) noexcept
 	{
-		console.info("SFDP Header:"sv);
-		console.info("-> magic '"sv, header.magic, "'"sv);
-		console.info("-> version "sv, header.versionMajor, '.', header.versionMinor);
-		console.info("-> "sv, header.parameterHeadersCount(), " parameter headers"sv);
-		console.info("-> access protocol "sv, asHex_t<2, '0'>{uint8_t(header.accessProtocol)});
+		const auto header{extract<sfdpHeader_t>(data, sfdpHeaderAddress)};
+		return tableHeaderAddress + (header.parameterHeadersCount() * sizeof(parameterTableHeader_t));
 	}
 
-	static void displayTableHeader(const parameterTableHeader_t &header, const size_t index)
+	// Work out how much of the SFDP address space the region spans, given its headers have been fetched
+	[[nodiscard]] static size_t regionLength(const std::vector<uint8_t> &data) noexcept
 	{
-		console.info("Parameter table header "sv, index, ":"sv);
-		console.info("-> type "sv, asHex_t<4, '0'>{header.jedecParameterID()});
-		console.info("-> version "sv, header.versionMajor, '.', header.versionMinor);
-		console.info("-> table is "sv, header.tableLength(), " bytes long"sv);
-		console.info("-> table SFDP address: "sv, uint32_t{header.tableAddress});
+		const auto header{extract<sfdpHeader_t>(data, sfdpHeaderAddress)};
+		auto length{headersLength(data)};
+		for (const auto idx : indexSequence_t{header.parameterHeadersCount()})
+		{
+			const auto tableHeader
+				{extract<parameterTableHeader_t>(data, tableHeaderAddress + (sizeof(parameterTableHeader_t) * idx))};
+			const auto tableEnd{tableHeader.tableAddress + tableHeader.tableLength()};
+			if (tableEnd <= maximumRegionLength)
+				length = std::max(length, tableEnd);
+		}
+		return length;
 	}
 
-	static bool displayBasicParameterTable(const usbDeviceHandle_t &device, const usbDataSource_t &dataSource,
-		const uint32_t address, const size_t length)
+	std::optional<std::vector<uint8_t>> fetch(const usbDeviceHandle_t &device, const usbDataSource_t dataSource)
 	{
-		basicParameterTable_t parameterTable{};
-		if (!sfdpRead(device, dataSource, address, &parameterTable, std::min(sizeof(basicParameterTable_t), length)))
-			return false;
+		std::vector<uint8_t> data{};
+		// Extend the data fetched so far to cover at least length bytes of the region
+		const auto fetchTo
+		{
+			[&](const size_t length)
+			{
+				while (data.size() < length)
+				{
+					const auto address{data.size()};
+					const auto amount{std::min(length - address, maximumFetchLength)};
+					data.resize(address + amount);
+					if (!sfdpRead(device, dataSource, static_cast<uint32_t>(address), data.data() + address, amount))
+						return false;
+				}
+				return true;
+			}
+		};
+
+		if (!fetchTo(initialFetchLength))
+			return std::nullopt;
+		// If the chip has no SFDP, hand back what was found there so the caller can see as much
+		if (extract<sfdpHeader_t>(data, sfdpHeaderAddress).magic != sfdpMagic)
+			return data;
+		// Otherwise make sure we have all the parameter headers, then all the tables they describe
+		if (!fetchTo(headersLength(data)))
+			return std::nullopt;
+		const auto length{regionLength(data)};
+		if (!fetchTo(length))
+			return std::nullopt;
+		data.resize(length);
+		return data;
+	}
+
+	static void parseBasicTable(model_t &model, const std::vector<uint8_t> &data, const parameterTable_t &table)
+	{
+		const auto length{std::min<size_t>(sizeof(basicParameterTable_t), table.length)};
+		const auto parameterTable{extract<basicParameterTable_t>(data, table.address, length)};
+		model.basicTableLength = table.length;
+		model.capacity = static_cast<uint32_t>(parameterTable.flashMemoryDensity.capacity());
+		model.addressing = static_cast<addressing_t>(std::min<uint8_t>(parameterTable.addressBytes(), 2U));
+		model.supportsDTR = parameterTable.supportsDTR();
+		// Only trust the 4KiB erase opcode if the chip says 4KiB erases are uniformly available
+		if ((parameterTable.value1 & 0x03U) == 0x01U)
+			model.sectorEraseOpcode = parameterTable.sectorEraseOpcode;
+
+		const auto addFastRead
+		{
+			[&](const bool supported, const readMode_t mode, const timingsAndOpcode_t &read)
+			{
+				if (supported)
+					model.fastReads.push_back({mode, read.opcode, read.modeClocks(), read.waitStates()});
+			}
+		};
+		addFastRead(parameterTable.supportsDualOutput(), readMode_t::dualOutput, parameterTable.fastDualOutput);
+		addFastRead(parameterTable.supportsDualIO(), readMode_t::dualIO, parameterTable.fastDualIO);
+		addFastRead(parameterTable.supportsQuadOutput(), readMode_t::quadOutput, parameterTable.fastQuadOutput);
+		addFastRead(parameterTable.supportsQuadIO(), readMode_t::quadIO, parameterTable.fastQuadIO);
+		addFastRead(parameterTable.supportsDPI(), readMode_t::dpi, parameterTable.fastDualDPI);
+		addFastRead(parameterTable.supportsQPI(), readMode_t::qpi, parameterTable.fastQuadQPI);
+		// The octal reads have no support bits, an opcode of 0 meaning the mode is not supported
+		if (length >= octalTableLength)
+		{
+			addFastRead(parameterTable.fastOctalOutput.opcode != 0U, readMode_t::octalOutput,
+				parameterTable.fastOctalOutput);
+			addFastRead(parameterTable.fastOctalIO.opcode != 0U, readMode_t::octalIO, parameterTable.fastOctalIO);
+		}
+
+		const auto &eraseTiming{parameterTable.eraseTiming};
+		const auto &programTiming{parameterTable.programmingAndChipEraseTiming};
+		const auto haveTimings{length >= timedTableLength && eraseTiming.valid()};
+		model.pageSize = length >= timedTableLength ? static_cast<uint32_t>(programTiming.pageSize()) : defaultPageSize;
+		for (const auto &[idx, eraseType] : indexedIterator_t{parameterTable.eraseTypes})
+		{
+			if (eraseType.eraseSizeExponent == 0U)
+				continue;
+			chipDB::timing_t time{};
+			if (haveTimings)
+			{
+				time.typical = eraseTiming.typical(idx);
+				time.maximum = time.typical * eraseTiming.maximumMultiplier();
+			}
+			model.eraseTypes[idx] = eraseType_t{eraseType.opcode, static_cast<uint32_t>(eraseType.eraseSize()), time};
+		}
+		if (haveTimings)
+		{
+			const auto programTypical{programTiming.pageProgramTypical()};
+			model.pageProgram = chipDB::timing_t{programTypical, programTypical * programTiming.programMaximumMultiplier()};
+			const auto chipEraseTypical{programTiming.chipEraseTypical()};
+			model.chipErase = chipDB::timing_t{chipEraseTypical, chipEraseTypical * eraseTiming.maximumMultiplier()};
+		}
+
+		if (length < jesd216ATableLength)
+			return;
+		const auto &suspendResume{parameterTable.suspendResume};
+		// Some tables leave these DWords zeroed, which would otherwise read as supporting suspend with no opcodes
+		if (suspendResume.supported() && parameterTable.suspendOpcode != 0U)
+		{
+			model.suspendResume = suspendResume_t
+			{
+				parameterTable.programSuspendOpcode, parameterTable.programResumeOpcode,
+				parameterTable.suspendOpcode, parameterTable.resumeOpcode,
+				suspendResume.programSuspendLatency(), suspendResume.eraseSuspendLatency(),
+				suspendResume.programResumeToSuspend(), suspendResume.eraseResumeToSuspend(),
+			};
+		}
+		if (parameterTable.deepPowerdown.supported())
+		{
+			model.powerDownOpcode = parameterTable.deepPowerdown.enterInstruction();
+			model.wakeUpOpcode = parameterTable.deepPowerdown.exitInstruction();
+		}
+		model.quadEnableRequirements = parameterTable.quadEnableRequirements();
+		model.fourByteEntryMethods = parameterTable.fourByteEntryMethods();
+		model.fourByteExitMethods = parameterTable.fourByteExitMethods();
+	}
+
+	static void parseSectorMap(model_t &model, const std::vector<uint8_t> &data, const parameterTable_t &table)
+	{
+		const auto tableEnd{table.address + table.length};
+		for (auto address{table.address}; address + sizeof(sectorMapDescriptor_t) <= tableEnd;)
+		{
+			const auto descriptor{extract<sectorMapDescriptor_t>(data, address)};
+			address += sizeof(sectorMapDescriptor_t);
+			if (descriptor.isMap())
+			{
+				sectorMap_t map{descriptor.configurationID(), {}};
+				for (size_t region{}; region < descriptor.regionCount() &&
+					address + sizeof(sectorMapRegion_t) <= tableEnd; ++region)
+				{
+					const auto regionInfo{extract<sectorMapRegion_t>(data, address)};
+					map.regions.push_back({static_cast<uint32_t>(regionInfo.size()), regionInfo.eraseTypes()});
+					address += sizeof(sectorMapRegion_t);
+				}
+				model.sectorMaps.push_back(std::move(map));
+			}
+			else
+			{
+				// Configuration detection commands are followed by the address to run them against
+				++model.sectorMapDetectionCommands;
+				address += sizeof(uint32_t);
+			}
+			if (descriptor.last())
+				break;
+		}
+	}
+
+	static void parseFourByteInstructions(model_t &model, const std::vector<uint8_t> &data,
+		const parameterTable_t &table)
+	{
+		const auto instructionTable{extract<fourByteInstructionTable_t>(data, table.address, table.length)};
+		const auto supported{[&](const size_t bit) { return bool(instructionTable.support & (1U << bit)); }};
+		fourByteInstructions_t instructions{};
+		instructions.support = instructionTable.support;
+		if (supported(0U))
+			instructions.read = 0x13U;
+		if (supported(1U))
+			instructions.fastRead = 0x0CU;
+		if (supported(6U))
+			instructions.pageProgram = 0x12U;
+		for (const auto &[idx, opcode] : indexedIterator_t{instructionTable.eraseOpcodes})
+		{
+			if (supported(9U + idx))
+				instructions.eraseOpcodes[idx] = opcode;
+		}
+		model.fourByteInstructions = instructions;
+	}
+
+	std::optional<model_t> parse(const std::vector<uint8_t> &data)
+	{
+		const auto header{extract<sfdpHeader_t>(data, sfdpHeaderAddress)};
+		if (data.size() < sizeof(sfdpHeader_t) || header.magic != sfdpMagic)
+			return std::nullopt;
+
+		model_t model{};
+		model.versionMajor = header.versionMajor;
+		model.versionMinor = header.versionMinor;
+		model.accessProtocol = static_cast<uint8_t>(header.accessProtocol);
+		// A chip may carry several basic parameter tables for different revisions of the standard, the newest winning
+		std::optional<parameterTable_t> basicTable{};
+		for (const auto idx : indexSequence_t{header.parameterHeadersCount()})
+		{
+			const auto headerAddress{tableHeaderAddress + (sizeof(parameterTableHeader_t) * idx)};
+			if (headerAddress + sizeof(parameterTableHeader_t) > data.size())
+				break;
+			const auto tableHeader{extract<parameterTableHeader_t>(data, headerAddress)};
+			const parameterTable_t table
+			{
+				tableHeader.jedecParameterID(), tableHeader.versionMajor, tableHeader.versionMinor,
+				tableHeader.tableAddress, static_cast<uint32_t>(tableHeader.tableLength())
+			};
+			model.tables.push_back(table);
+			// Skip over any tables that lie outside the region that was fetched
+			if (table.address + table.length > data.size())
+				continue;
+
+			if (table.id == basicSPIParameterTable)
+			{
+				if (!basicTable || std::make_pair(table.versionMajor, table.versionMinor) >=
+					std::make_pair(basicTable->versionMajor, basicTable->versionMinor))
+					basicTable = table;
+			}
+			else if (table.id == sectorMapParameterTable)
+				parseSectorMap(model, data, table);
+			else if (table.id == fourByteInstructionParameterTable)
+				parseFourByteInstructions(model, data, table);
+		}
+		if (basicTable)
+			parseBasicTable(model, data, *basicTable);
+		return model;
+	}
 
-		console.info("Basic parameter table:");
-		const auto [capacityValue, capacityUnits] = humanReadableSize(parameterTable.flashMemoryDensity.capacity());
+	std::optional<model_t> read(const usbDeviceHandle_t &device, const usbDataSource_t dataSource,
+		const std::optional<cache::chipKey_t> &chip)
+	{
+		if (chip)
+		{
+			// A chip's SFDP data never changes, so if we've seen this chip before we can skip fetching it
+			if (const auto data{cache::loadSFDP(*chip)}; data)
+			{
+				if (auto model{parse(*data)}; model)
+					return model;
+			}
+		}
+
+		const auto data{fetch(device, dataSource)};
+		if (!data)
+			return std::nullopt;
+		auto model{parse(*data)};
+		if (model && chip)
+			static_cast<void>(cache::storeSFDP(*chip, *data));
+		return model;
+	}
+
+	[[nodiscard]] static std::string_view readModeName(const readMode_t mode) noexcept
+	{
+		switch (mode)
+		{
+			case readMode_t::dualOutput:
+				return "1-1-2"sv;
+			case readMode_t::dualIO:
+				return "1-2-2"sv;
+			case readMode_t::quadOutput:
+				return "1-1-4"sv;
+			case readMode_t::quadIO:
+				return "1-4-4"sv;
+			case readMode_t::dpi:
+				return "2-2-2"sv;
+			case readMode_t::qpi:
+				return "4-4-4"sv;
+			case readMode_t::octalOutput:
+				return "1-1-8"sv;
+			case readMode_t::octalIO:
+				return "1-8-8"sv;
+		}
+		return "unknown"sv;
+	}
+
+	[[nodiscard]] static std::string_view addressingName(const addressing_t addressing) noexcept
+	{
+		switch (addressing)
+		{
+			case addressing_t::threeByte:
+				return "3-byte only"sv;
+			case addressing_t::threeOrFourByte:
+				return "3- or 4-byte"sv;
+			case addressing_t::fourByte:
+				return "4-byte only"sv;
+		}
+		return "unknown"sv;
+	}
+
+	// List out which of a set of methods a chip supports, one per line
+	template<size_t count> static void displayMethods(const std::string_view title, const uint32_t methods,
+		const std::array<std::string_view, count> &descriptions)
+	{
+		if (!methods)
+			return;
+		console.info(title);
+		for (const auto &[bit, description] : indexedIterator_t{descriptions})
+		{
+			if (methods & (1U << bit))
+				console.info("\t-> "sv, description);
+		}
+	}
+
+	static void displayBasicParameterTable(const model_t &model)
+	{
+		console.info("Basic parameter table:"sv);
+		const auto [capacityValue, capacityUnits] = humanReadableSize(model.capacity);
 		console.info("-> capacity "sv, capacityValue, capacityUnits);
-		console.info("-> program page size: "sv, parameterTable.programmingAndChipEraseTiming.pageSize());
-		console.info("-> sector erase opcode: "sv, asHex_t<2, '0'>(parameterTable.sectorEraseOpcode));
+		console.info("-> program page size: "sv, model.pageSize);
+		console.info("-> addressing: "sv, addressingName(model.addressing));
+		if (model.supportsDTR)
+			console.info("-> supports DTR operation"sv);
+		if (model.sectorEraseOpcode)
+			console.info("-> sector erase opcode: "sv, asHex_t<2, '0'>(*model.sectorEraseOpcode));
+		if (!model.fastReads.empty())
+		{
+			console.info("-> fast read modes:"sv);
+			for (const auto &read : model.fastReads)
+				console.info("\t-> "sv, readModeName(read.mode), ": opcode "sv, asHex_t<2, '0'>(read.opcode), ", "sv,
+					read.modeClocks, " mode clocks, "sv, read.waitStates, " wait states"sv);
+		}
 		console.info("-> supported erase types:"sv);
-		for (const auto &[idx, eraseType] : indexedIterator_t{parameterTable.eraseTypes})
+		for (const auto &[idx, eraseType] : indexedIterator_t{model.eraseTypes})
 		{
 			console.info("\t-> "sv, idx + 1U, ": "sv, nullptr);
-			if (eraseType.eraseSizeExponent != 0U)
+			if (eraseType)
 			{
-				const auto [sizeValue, sizeUnits] = humanReadableSize(eraseType.eraseSize());
-				console.writeln("opcode "sv, asHex_t<2, '0'>(eraseType.opcode), ", erase size: "sv,
-					sizeValue, sizeUnits);
+				const auto [sizeValue, sizeUnits] = humanReadableSize(eraseType->size);
+				console.writeln("opcode "sv, asHex_t<2, '0'>(eraseType->opcode), ", erase size: "sv,
+					sizeValue, sizeUnits, eraseType->time.typical.count() ?
+					", takes " + chipDB::formatTiming(eraseType->time) : std::string{});
 			}
 			else
 				console.writeln("invalid erase type"sv);
 		}
-		console.info("-> power down opcode: "sv, asHex_t<2, '0'>(parameterTable.deepPowerdown.enterInstruction()));
-		console.info("-> wake up opcode: "sv, asHex_t<2, '0'>(parameterTable.deepPowerdown.exitInstruction()));
-		return true;
+		if (model.pageProgram)
+			console.info("-> page program takes "sv, chipDB::formatTiming(*model.pageProgram));
+		if (model.chipErase)
+			console.info("-> chip erase takes "sv, chipDB::formatTiming(*model.chipErase));
+		if (const auto &suspendResume{model.suspendResume}; suspendResume)
+		{
+			console.info("-> program suspend opcode: "sv, asHex_t<2, '0'>(suspendResume->programSuspendOpcode),
+				", resume opcode: "sv, asHex_t<2, '0'>(suspendResume->programResumeOpcode));
+			console.info("\t-> suspends within "sv, chipDB::formatTime(suspendResume->programSuspendLatency),
+				", may be suspended again "sv, chipDB::formatTime(suspendResume->programResumeToSuspend),
+				" after resuming"sv);
+			console.info("-> erase suspend opcode: "sv, asHex_t<2, '0'>(suspendResume->eraseSuspendOpcode),
+				", resume opcode: "sv, asHex_t<2, '0'>(suspendResume->eraseResumeOpcode));
+			console.info("\t-> suspends within "sv, chipDB::formatTime(suspendResume->eraseSuspendLatency),
+				", may be suspended again "sv, chipDB::formatTime(suspendResume->eraseResumeToSuspend),
+				" after resuming"sv);
+		}
+		if (model.powerDownOpcode && model.wakeUpOpcode)
+		{
+			console.info("-> power down opcode: "sv, asHex_t<2, '0'>(*model.powerDownOpcode));
+			console.info("-> wake up opcode: "sv, asHex_t<2, '0'>(*model.wakeUpOpcode));
+		}
+		if (model.basicTableLength >= jesd216ATableLength)
+			console.info("-> quad enable: "sv, quadEnableDescriptions[model.quadEnableRequirements]);
+		displayMethods("-> enters 4-byte addressing by:"sv, model.fourByteEntryMethods, fourByteEntryDescriptions);
+		displayMethods("-> leaves 4-byte addressing by:"sv, model.fourByteExitMethods, fourByteExitDescriptions);
+	}
+
+	static void displaySectorMaps(const model_t &model)
+	{
+		console.info("Sector map table:"sv);
+		console.info("-> "sv, model.sectorMapDetectionCommands, " configuration detection commands"sv);
+		for (const auto &map : model.sectorMaps)
+		{
+			console.info("-> configuration "sv, map.configurationID, ":"sv);
+			uint64_t address{};
+			for (const auto &region : map.regions)
+			{
+				console.info("\t-> "sv, asHex_t<8, '0'>{address}, ": "sv, region.size / 1024U,
+					"KiB, erase types "sv, asHex_t<1, '0'>{region.eraseTypes});
+				address += region.size;
+			}
+		}
+	}
+
+	static void displayFourByteInstructions(const fourByteInstructions_t &instructions)
+	{
+		displayMethods("4-byte address instruction table:"sv, instructions.support, fourByteInstructionNames);
+		for (const auto &[idx, opcode] : indexedIterator_t{instructions.eraseOpcodes})
+		{
+			if (opcode)
+				console.info("-> erase type "sv, idx + 1U, " opcode: "sv, asHex_t<2, '0'>(*opcode));
+		}
+	}
+
+	void model_t::display() const noexcept try
+	{
+		console.info("SFDP Header:"sv);
+		console.info("-> magic '"sv, sfdpMagic, "'"sv);
+		console.info("-> version "sv, versionMajor, '.', versionMinor);
+		console.info("-> "sv, tables.size(), " parameter headers"sv);
+		console.info("-> access protocol "sv, asHex_t<2, '0'>{accessProtocol});
+
+		for (const auto &[idx, table] : indexedIterator_t{tables})
+		{
+			console.info("Parameter table header "sv, idx + 1U, ":"sv);
+			console.info("-> type "sv, asHex_t<4, '0'>{table.id});
+			console.info("-> version "sv, table.versionMajor, '.', table.versionMinor);
+			console.info("-> table is "sv, table.length, " bytes long"sv);
+			console.info("-> table SFDP address: "sv, table.address);
+		}
+
+		if (hasBasicTable())
+			displayBasicParameterTable(*this);
+		if (!sectorMaps.empty())
+			displaySectorMaps(*this);
+		if (fourByteInstructions)
+			displayFourByteInstructions(*fourByteInstructions);
+	}
+	catch (const std::exception &)
+	{
+		return;
+	}
+
+	chipDB::chipProfile_t model_t::profile() const
+	{
+		chipDB::chipProfile_t profile{};
+		profile.capacity = capacity;
+		profile.pageSize = pageSize;
+		for (const auto &eraseType : eraseTypes)
+		{
+			if (eraseType)
+				profile.eraseTypes.push_back({eraseType->opcode, eraseType->size, eraseType->time});
+		}
+		if (pageProgram)
+			profile.pageProgram = *pageProgram;
+		if (chipErase)
+			profile.chipErase = chipDB::eraseType_t{chipEraseOpcode, capacity, *chipErase};
+		return profile;
 	}
 
 	bool readAndDisplay(const usbDeviceHandle_t &device, const usbDataSource_t dataSource)
 	{
 		console.info("Reading SFDP data for device"sv);
-		sfdpHeader_t header{};
-		if (!sfdpRead(device, dataSource, sfdpHeaderAddress, header))
+		const auto data{fetch(device, dataSource)};
+		if (!data)
 			return false;
-		if (header.magic != sfdpMagic)
+		const auto model{parse(*data)};
+		if (!model)
 		{
+			const auto header{extract<sfdpHeader_t>(*data, sfdpHeaderAddress)};
 			console.error("Device does not have a valid SFDP block"sv);
 			console.error(" -> Read signature '"sv, header.magic, "'");
 			console.error(" -> Expected signature '"sv, sfdpMagic, "'");
 			return true;
 		}
-		displayHeader(header);
-
-		for (const auto idx : indexSequence_t{header.parameterHeadersCount()})
-		{
-			parameterTableHeader_t tableHeader{};
-			if (!sfdpRead(device, dataSource, tableHeaderAddress + (sizeof(parameterTableHeader_t) * idx), tableHeader))
-				return false;
-			displayTableHeader(tableHeader, idx + 1U);
-			if (tableHeader.jedecParameterID() == basicSPIParameterTable)
-			{
-				if (!displayBasicParameterTable(device, dataSource, tableHeader.tableAddress, tableHeader.tableLength()))
-					return false;
-			}
-		}
+		model->display();
 		return true;
 	}
 } // namespace sfdp
@@ -3,7 +3,13 @@
 #define SFDP_HXX
 
 #include <cstdint>
+#include <array>
+#include <chrono>
+#include <vector>
+#include <optional>
 #include "usbContext.hxx"
+#include "chipDB/chipDatabase.hxx"
+#include "cache/chipCache.hxx"
 
 namespace sfdp
 {
@@ -13,6 +19,135 @@ namespace sfdp
 		uint8_t endpoint;
 	};
 
+	enum class addressing_t : uint8_t
+	{
+		threeByte,
+		threeOrFourByte,
+		fourByte
+	};
+
+	// The bus widths used for the instruction, address and data of a fast read
+	enum class readMode_t : uint8_t
+	{
+		dualOutput, // 1-1-2
+		dualIO, // 1-2-2
+		quadOutput, // 1-1-4
+		quadIO, // 1-4-4
+		dpi, // 2-2-2
+		qpi, // 4-4-4
+		octalOutput, // 1-1-8
+		octalIO, // 1-8-8
+	};
+
+	struct fastRead_t final
+	{
+		readMode_t mode{};
+		uint8_t opcode{};
+		uint8_t modeClocks{};
+		uint8_t waitStates{};
+	};
+
+	struct eraseType_t final
+	{
+		uint8_t opcode{};
+		uint32_t size{};
+		flashprog::chipDB::timing_t time{};
+	};
+
+	struct suspendResume_t final
+	{
+		uint8_t programSuspendOpcode{};
+		uint8_t programResumeOpcode{};
+		uint8_t eraseSuspendOpcode{};
+		uint8_t eraseResumeOpcode{};
+		std::chrono::microseconds programSuspendLatency{};
+		std::chrono::microseconds eraseSuspendLatency{};
+		// How long the chip must be left to get on with an operation after resuming it before it can be suspended again
+		std::chrono::microseconds programResumeToSuspend{};
+		std::chrono::microseconds eraseResumeToSuspend{};
+	};
+
+	struct sectorRegion_t final
+	{
+		uint32_t size{};
+		// Which of the erase types work on this region, bit n for erase type n + 1
+		uint8_t eraseTypes{};
+	};
+
+	struct sectorMap_t final
+	{
+		uint8_t configurationID{};
+		std::vector<sectorRegion_t> regions{};
+	};
+
+	// The dedicated 4-byte address instructions a chip has, from its 4-byte address instruction table
+	struct fourByteInstructions_t final
+	{
+		std::optional<uint8_t> read{};
+		std::optional<uint8_t> fastRead{};
+		std::optional<uint8_t> pageProgram{};
+		std::array<std::optional<uint8_t>, 4> eraseOpcodes{};
+		// The raw support bits, for the instructions not broken out above
+		uint32_t support{};
+	};
+
+	struct parameterTable_t final
+	{
+		uint16_t id{};
+		uint8_t versionMajor{};
+		uint8_t versionMinor{};
+		uint32_t address{};
+		uint32_t length{};
+	};
+
+	// Everything flashprog understands about a chip from its SFDP data
+	struct model_t final
+	{
+		uint8_t versionMajor{};
+		uint8_t versionMinor{};
+		uint8_t accessProtocol{};
+		std::vector<parameterTable_t> tables{};
+
+		// The basic parameter table's length, 0 if the chip does not have one, in which case nothing below is valid
+		uint32_t basicTableLength{};
+		uint32_t capacity{};
+		uint32_t pageSize{};
+		addressing_t addressing{addressing_t::threeByte};
+		bool supportsDTR{false};
+		std::optional<uint8_t> sectorEraseOpcode{};
+		std::vector<fastRead_t> fastReads{};
+		// Erase types 1 through 4, which the sector map refers to by number
+		std::array<std::optional<eraseType_t>, 4> eraseTypes{};
+		std::optional<flashprog::chipDB::timing_t> pageProgram{};
+		std::optional<flashprog::chipDB::timing_t> chipErase{};
+		std::optional<suspendResume_t> suspendResume{};
+		std::optional<uint8_t> powerDownOpcode{};
+		std::optional<uint8_t> wakeUpOpcode{};
+		uint8_t quadEnableRequirements{};
+		uint8_t fourByteEntryMethods{};
+		uint16_t fourByteExitMethods{};
+		std::optional<fourByteInstructions_t> fourByteInstructions{};
+		// The chip's erase layout for each of its configurations, empty if it is uniform
+		std::vector<sectorMap_t> sectorMaps{};
+		// How many commands must be run against the chip to tell which configuration it is in
+		size_t sectorMapDetectionCommands{};
+
+		[[nodiscard]] bool hasBasicTable() const noexcept { return basicTableLength != 0U; }
+		// The geometry and timings the basic parameter table gives, in the form the chip database uses
+		[[nodiscard]] flashprog::chipDB::chipProfile_t profile() const;
+		void display() const noexcept;
+	};
+
+	// Fetch the raw SFDP region of the targeted chip, in as few transfers as its parameter headers allow
+	[[nodiscard]] std::optional<std::vector<uint8_t>> fetch(const usbDeviceHandle_t &device, usbDataSource_t dataSource);
+	// Parse a raw SFDP region into a model, failing if it is not a valid one
+	[[nodiscard]] std::optional<model_t> parse(const std::vector<uint8_t> &data);
+	/*!
+	 * Read and parse the SFDP data of the targeted chip, going to the chip-state cache for it first
+	 * when the chip can be identified, and storing it there when it had to be fetched
+	 */
+	[[nodiscard]] std::optional<model_t> read(const usbDeviceHandle_t &device, usbDataSource_t dataSource,
+		const std::optional<flashprog::cache::chipKey_t> &chip);
 	bool readAndDisplay(const usbDeviceHandle_t &device, usbDataSource_t dataSource);
 } // namespace sfdp
 
@@ -5,9 +5,13 @@
 #include <cstdint>
 #include <cstddef>
 #include <array>
+#include <chrono>
 
 namespace sfdp
 {
+	using namespace std::literals::chrono_literals;
+	using std::chrono::microseconds;
+
 	enum struct accessProtocol_t : uint8_t
 	{
 		xspiNANDClass1 = 0xF0U,
@@ -38,8 +42,8 @@ namespace sfdp
 	struct sfdpHeader_t
 	{
 		std::array<char, 4> magic{};
-		uint8_t versionMajor{};
 		uint8_t versionMinor{};
+		uint8_t versionMajor{};
 		uint8_t rawParameterHeadersCount{};
 		accessProtocol_t accessProtocol{accessProtocol_t::legacyJESD216B};
 
@@ -49,8 +53,8 @@ namespace sfdp
 	struct parameterTableHeader_t
 	{
 		uint8_t jedecParameterIDLow{};
-		uint8_t versionMajor{};
 		uint8_t versionMinor{};
+		uint8_t versionMajor{};
 		uint8_t tableLengthInU32s{};
 		uint24_t tableAddress{};
 		uint8_t jedecParameterIDHigh{};
@@ -90,6 +94,9 @@ namespace sfdp
 	{
 		uint8_t timings{};
 		uint8_t opcode{};
+
+		[[nodiscard]] uint8_t waitStates() const noexcept { return timings & 0x1FU; }
+		[[nodiscard]] uint8_t modeClocks() const noexcept { return timings >> 5U; }
 	};
 
 	struct [[gnu::packed]] eraseParameters_t
@@ -100,6 +107,22 @@ namespace sfdp
 		[[nodiscard]] size_t eraseSize() const noexcept { return 1U << eraseSizeExponent; }
 	};
 
+	struct eraseTiming_t
+	{
+		uint32_t data{};
+
+		[[nodiscard]] bool valid() const noexcept { return data != 0U; }
+		// Maximum erase times are given as a multiple of the typical times
+		[[nodiscard]] uint32_t maximumMultiplier() const noexcept { return 2U * ((data & 0x0FU) + 1U); }
+
+		[[nodiscard]] microseconds typical(const size_t eraseType) const noexcept
+		{
+			constexpr std::array<microseconds, 4> units{{1ms, 16ms, 128ms, 1s}};
+			const auto value{data >> (4U + (eraseType * 7U))};
+			return ((value & 0x1FU) + 1U) * units[(value >> 5U) & 0x03U];
+		}
+	};
+
 	struct programmingAndChipEraseTiming_t
 	{
 		uint8_t programmingTimingRatioAndPageSize{};
@@ -110,12 +133,53 @@ namespace sfdp
 			const uint8_t pageSizeExponent = programmingTimingRatioAndPageSize >> 4U;
 			return 1U << pageSizeExponent;
 		}
+
+		// Maximum program times are given as a multiple of the typical times
+		[[nodiscard]] uint32_t programMaximumMultiplier() const noexcept
+			{ return 2U * ((programmingTimingRatioAndPageSize & 0x0FU) + 1U); }
+
+		[[nodiscard]] microseconds pageProgramTypical() const noexcept
+		{
+			const auto units{(eraseTimings[0] & 0x20U) ? 64us : 8us};
+			return ((eraseTimings[0] & 0x1FU) + 1U) * units;
+		}
+
+		[[nodiscard]] microseconds chipEraseTypical() const noexcept
+		{
+			constexpr std::array<microseconds, 4> units{{16ms, 256ms, 4s, 64s}};
+			return ((eraseTimings[2] & 0x1FU) + 1U) * units[(eraseTimings[2] >> 5U) & 0x03U];
+		}
+	};
+
+	struct suspendLatencies_t
+	{
+		uint32_t data{};
+
+		// Unlike most of the table, this bit is set when the chip does *not* support the feature
+		[[nodiscard]] bool supported() const noexcept { return !(data & 0x80000000U); }
+
+		[[nodiscard]] microseconds programResumeToSuspend() const noexcept
+			{ return (((data >> 9U) & 0x0FU) + 1U) * 64us; }
+		[[nodiscard]] microseconds eraseResumeToSuspend() const noexcept
+			{ return (((data >> 20U) & 0x0FU) + 1U) * 64us; }
+		[[nodiscard]] microseconds programSuspendLatency() const noexcept { return latency(data >> 13U); }
+		[[nodiscard]] microseconds eraseSuspendLatency() const noexcept { return latency(data >> 24U); }
+
+	private:
+		[[nodiscard]] static microseconds latency(const uint32_t value) noexcept
+		{
+			constexpr std::array<std::chrono::nanoseconds, 4> units{{128ns, 1us, 8us, 64us}};
+			return std::chrono::ceil<microseconds>(((value & 0x1FU) + 1U) * units[(value >> 5U) & 0x03U]);
+		}
 	};
 
 	struct deepPowerDown_t
 	{
 		std::array<uint8_t, 3> data{};
 
+		// As with suspend and resume, this bit is set when the chip does *not* support deep power down
+		[[nodiscard]] bool supported() const noexcept { return !(data[2] & 0x80U); }
+
 		[[nodiscard]] uint8_t enterInstruction() const noexcept
 		{
 			const auto value{(uint16_t{data[2]} << 8U) | uint16_t{data[1]}};
@@ -129,6 +193,30 @@ namespace sfdp
 		}
 	};
 
+	// How a chip goes into and out of 4-byte addressing, from DWord 16 of the basic parameter table
+	namespace fourByteEntry
+	{
+		constexpr static uint8_t instructionB7{1U << 0U};
+		constexpr static uint8_t writeEnableThenB7{1U << 1U};
+		constexpr static uint8_t extendedAddressRegister{1U << 2U};
+		constexpr static uint8_t bankRegister{1U << 3U};
+		constexpr static uint8_t nonvolatileConfigRegister{1U << 4U};
+		constexpr static uint8_t dedicatedInstructions{1U << 5U};
+		constexpr static uint8_t always4Byte{1U << 6U};
+	} // namespace fourByteEntry
+
+	namespace fourByteExit
+	{
+		constexpr static uint16_t instructionE9{1U << 0U};
+		constexpr static uint16_t writeEnableThenE9{1U << 1U};
+		constexpr static uint16_t extendedAddressRegister{1U << 2U};
+		constexpr static uint16_t bankRegister{1U << 3U};
+		constexpr static uint16_t nonvolatileConfigRegister{1U << 4U};
+		constexpr static uint16_t hardwareReset{1U << 5U};
+		constexpr static uint16_t softwareReset{1U << 6U};
+		constexpr static uint16_t powerCycle{1U << 7U};
+	} // namespace fourByteExit
+
 	struct basicParameterTable_t
 	{
 		uint8_t value1{};
@@ -146,10 +234,9 @@ namespace sfdp
 		std::array<uint8_t, 2> reserved3{};
 		timingsAndOpcode_t fastQuadQPI{};
 		std::array<eraseParameters_t, 4> eraseTypes{};
-		uint32_t eraseTiming{};
+		eraseTiming_t eraseTiming{};
 		programmingAndChipEraseTiming_t programmingAndChipEraseTiming{};
-		uint8_t operationalProhibitions{};
-		std::array<uint8_t, 3> suspendLatencySpecs{};
+		suspendLatencies_t suspendResume{};
 		uint8_t programResumeOpcode{};
 		uint8_t programSuspendOpcode{};
 		uint8_t resumeOpcode{};
@@ -159,6 +246,54 @@ namespace sfdp
 		std::array<uint8_t, 3> dualAndQuadMode{};
 		uint8_t reserved4{};
 		uint32_t statusAndAddressingMode{};
+		timingsAndOpcode_t fastOctalOutput{};
+		timingsAndOpcode_t fastOctalIO{};
+		// DWords 18 through 23, which describe the xSPI DTR and octal modes flashprog does not drive
+		std::array<uint32_t, 6> xspiModes{};
+
+		// 0 for 3-byte addressing only, 1 for either 3- or 4-byte, and 2 for 4-byte only
+		[[nodiscard]] uint8_t addressBytes() const noexcept { return (value2 >> 1U) & 0x03U; }
+		[[nodiscard]] bool supportsDTR() const noexcept { return value2 & 0x08U; }
+		[[nodiscard]] bool supportsDualOutput() const noexcept { return value2 & 0x01U; }
+		[[nodiscard]] bool supportsDualIO() const noexcept { return value2 & 0x10U; }
+		[[nodiscard]] bool supportsQuadIO() const noexcept { return value2 & 0x20U; }
+		[[nodiscard]] bool supportsQuadOutput() const noexcept { return value2 & 0x40U; }
+		[[nodiscard]] bool supportsDPI() const noexcept { return fastSupportFlags & 0x01U; }
+		[[nodiscard]] bool supportsQPI() const noexcept { return fastSupportFlags & 0x10U; }
+		// The 3-bit code from DWord 15 for where the chip's quad enable bit is and how to set it
+		[[nodiscard]] uint8_t quadEnableRequirements() const noexcept { return (dualAndQuadMode[2] >> 4U) & 0x07U; }
+		[[nodiscard]] uint8_t fourByteEntryMethods() const noexcept
+			{ return static_cast<uint8_t>(statusAndAddressingMode >> 24U); }
+		[[nodiscard]] uint16_t fourByteExitMethods() const noexcept
+			{ return static_cast<uint16_t>((statusAndAddressingMode >> 14U) & 0x03FFU); }
+	};
+
+	// The JEDEC 4-byte address instruction table, which says which dedicated 4-byte address instructions a chip has
+	struct fourByteInstructionTable_t
+	{
+		uint32_t support{};
+		std::array<uint8_t, 4> eraseOpcodes{};
+	};
+
+	// The descriptors the sector map table is made up of, each either a configuration detection command or a map
+	struct sectorMapDescriptor_t
+	{
+		uint32_t data{};
+
+		[[nodiscard]] bool last() const noexcept { return data & 0x01U; }
+		[[nodiscard]] bool isMap() const noexcept { return data & 0x02U; }
+		// For maps, the configuration the map applies to and how many region DWords follow
+		[[nodiscard]] uint8_t configurationID() const noexcept { return static_cast<uint8_t>(data >> 8U); }
+		[[nodiscard]] size_t regionCount() const noexcept { return ((data >> 16U) & 0xFFU) + 1U; }
+	};
+
+	struct sectorMapRegion_t
+	{
+		uint32_t data{};
+
+		// Which of the basic table's erase types work on the region, bit n for erase type n + 1
+		[[nodiscard]] uint8_t eraseTypes() const noexcept { return data & 0x0FU; }
+		[[nodiscard]] size_t size() const noexcept { return ((data >> 8U) + 1U) * 256U; }
 	};
 
 	static_assert(sizeof(uint24_t) == 3);
@@ -166,8 +301,11 @@ namespace sfdp
 	static_assert(sizeof(parameterTableHeader_t) == 8);
 	static_assert(sizeof(memoryDensity_t) == 4);
 	static_assert(sizeof(timingsAndOpcode_t) == 2);
+	static_assert(sizeof(eraseTiming_t) == 4);
 	static_assert(sizeof(programmingAndChipEraseTiming_t) == 4);
-	static_assert(sizeof(basicParameterTable_t) == 64);
+	static_assert(sizeof(suspendLatencies_t) == 4);
+	static_assert(sizeof(basicParameterTable_t) == 92);
+	static_assert(sizeof(fourByteInstructionTable_t) == 8);
 } // namespace sfdp
 
 #endif /*SFDP_INTERNAL_HXX*/
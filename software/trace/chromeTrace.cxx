@@ -0,0 +1,186 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <substrate/console>
+#include <substrate/fd>
+#include <fmt/core.h>
+#include "chromeTrace.hxx"
+#include "profile.hxx"
+
+using namespace std::literals::string_view_literals;
+using substrate::console;
+using flashProto::messages_t;
+using flashProto::eventType_t;
+using flashProto::responses::event_t;
+using flashProto::responses::events_t;
+
+namespace flashprog::trace
+{
+	constexpr static uint32_t hostProcess{1U};
+	constexpr static uint32_t deviceProcess{2U};
+
+	constexpr static uint32_t transportThread{1U};
+	constexpr static uint32_t protocolThread{1U};
+	constexpr static uint32_t flashThread{2U};
+	constexpr static uint32_t busyThread{3U};
+
+	void chromeTrace_t::addTransactions(const std::vector<transaction_t> &transactions)
+	{
+		// Anything the programmer logged before the trace started is stale, so skip it
+		horizon = std::chrono::nanoseconds{};
+		for (const auto &transaction : transactions)
+		{
+			const auto &record{transaction.record};
+			auto arguments{fmt::format(R"("length":{},"result":{})"sv, record.length, record.result)};
+			if (record.kind == transferKind_t::control)
+				arguments += fmt::format(R"(,"value":{},"index":{})"sv, record.value, record.index);
+			events.push_back({'X', 0, std::string{transactionName(record)}, hostProcess, transportThread,
+				transaction.startTime(), transaction.duration(), std::move(arguments)});
+
+			// If this transaction drained the programmer's event log, unpack the events it returned,
+			// taking the middle of the transfer as the moment the programmer took the chunk
+			if (record.kind == transferKind_t::control && transaction.directionIn() && record.result &&
+				record.request == static_cast<uint8_t>(messages_t::events) &&
+				transaction.payload.size() == sizeof(events_t))
+			{
+				events_t chunk{};
+				std::memcpy(&chunk, transaction.payload.data(), sizeof(events_t));
+				addDeviceEvents(chunk, transaction.startTime() + transaction.duration() / 2);
+			}
+		}
+	}
+
+	void chromeTrace_t::addDeviceEvents(const events_t &chunk, const std::chrono::nanoseconds chunkTime)
+	{
+		if (chunk.dropped)
+			console.warning("Programmer event log overflowed, "sv, chunk.dropped,
+				chunk.dropped == UINT8_MAX ? " or more"sv : ""sv, " events were lost"sv);
+		const auto count{std::min<size_t>(chunk.count, chunk.events.size())};
+		for (size_t idx{}; idx < count; ++idx)
+		{
+			const auto &event{chunk.events[idx]};
+			// The programmer's clock is a wrapping microsecond counter, so work relative to when the chunk was taken
+			const std::chrono::microseconds age{uint32_t(chunk.timestamp - event.timestamp)};
+			addDeviceEvent(event, chunkTime - age);
+		}
+	}
+
+	void chromeTrace_t::addDeviceEvent(const event_t &event, const std::chrono::nanoseconds timestamp)
+	{
+		if (timestamp < horizon)
+			return;
+		++deviceEventCount;
+		const auto request{messageName(event.argument)};
+		const auto add
+		{
+			[&](const char phase, const std::string_view name, const uint32_t thread, std::string arguments = {},
+				const char scope = 't')
+			{
+				events.push_back({phase, phase == 'i' ? scope : char{}, std::string{name}, deviceProcess, thread,
+					timestamp, {}, std::move(arguments)});
+			}
+		};
+
+		switch (event.type)
+		{
+			case eventType_t::controlRequest:
+				add('i', request, protocolThread, fmt::format(R"("value":{})"sv, event.value));
+				break;
+			case eventType_t::readSetup:
+				add('i', "readSetup"sv, protocolThread,
+					fmt::format(R"("request":"{}","count":{})"sv, request, event.value));
+				break;
+			case eventType_t::readBegin:
+				add('B', "read"sv, flashThread, fmt::format(R"("request":"{}","page":{})"sv, request, event.value));
+				break;
+			case eventType_t::readComplete:
+				add('E', "read"sv, flashThread);
+				break;
+			case eventType_t::writeSetup:
+				add('i', "writeSetup"sv, protocolThread,
+					fmt::format(R"("verify":{},"count":{})"sv, bool(event.argument), event.value));
+				break;
+			case eventType_t::writeBegin:
+				add('B', "write"sv, flashThread, fmt::format(R"("page":{})"sv, event.value));
+				break;
+			case eventType_t::pageProgrammed:
+				add('i', "pageProgrammed"sv, flashThread, fmt::format(R"("page":{})"sv, event.value));
+				break;
+			case eventType_t::writeComplete:
+				add('E', "write"sv, flashThread, fmt::format(R"("writeOK":{})"sv, bool(event.argument)));
+				break;
+			case eventType_t::eraseSetup:
+				add('i', "eraseSetup"sv, protocolThread, fmt::format(R"("operation":{})"sv, event.argument));
+				break;
+			case eventType_t::eraseIssue:
+				add('i', "eraseIssue"sv, flashThread, fmt::format(R"("range":{},"sector":{})"sv, event.argument, event.value));
+				break;
+			case eventType_t::eraseComplete:
+				add('i', "eraseComplete"sv, flashThread);
+				break;
+			case eventType_t::busyBegin:
+				add('B', "busy"sv, busyThread);
+				break;
+			case eventType_t::busyEnd:
+				add('E', "busy"sv, busyThread, fmt::format(R"("polls":{})"sv, event.value));
+				break;
+			case eventType_t::abort:
+				add('i', "abort"sv, protocolThread, {}, 'p');
+				break;
+			case eventType_t::error:
+				add('i', "error"sv, protocolThread,
+					fmt::format(R"("request":"{}","value":{})"sv, request, event.value), 'p');
+				break;
+			default:
+				add('i', "unknown"sv, protocolThread, fmt::format(R"("type":{})"sv, uint8_t(event.type)));
+		}
+	}
+
+	static double toMicroseconds(const std::chrono::nanoseconds time) noexcept
+		{ return std::chrono::duration<double, std::micro>{time}.count(); }
+
+	bool chromeTrace_t::write(const std::filesystem::path &fileName) const noexcept try
+	{
+		// Shift the timeline so it starts at the earliest event we have
+		std::chrono::nanoseconds origin{};
+		for (const auto &event : events)
+			origin = std::min(origin, event.timestamp);
+
+		std::string json{R"({"displayTimeUnit":"ms","traceEvents":[)"};
+		json += fmt::format(R"({{"name":"process_name","ph":"M","pid":{},"args":{{"name":"host"}}}},)"
+			R"({{"name":"thread_name","ph":"M","pid":{},"tid":{},"args":{{"name":"USB transport"}}}},)"
+			R"({{"name":"process_name","ph":"M","pid":{},"args":{{"name":"programmer"}}}},)"
+			R"({{"name":"thread_name","ph":"M","pid":{},"tid":{},"args":{{"name":"protocol"}}}},)"
+			R"({{"name":"thread_name","ph":"M","pid":{},"tid":{},"args":{{"name":"flash"}}}},)"
+			R"({{"name":"thread_name","ph":"M","pid":{},"tid":{},"args":{{"name":"busy-wait"}}}})"sv,
+			hostProcess, hostProcess, transportThread, deviceProcess, deviceProcess, protocolThread,
+			deviceProcess, flashThread, deviceProcess, busyThread);
+		for (const auto &event : events)
+		{
+			json += fmt::format(R"(,{{"name":"{}","ph":"{}","pid":{},"tid":{},"ts":{:.3f})"sv,
+				event.name, event.phase, event.process, event.thread, toMicroseconds(event.timestamp - origin));
+			if (event.phase == 'X')
+				json += fmt::format(R"(,"dur":{:.3f})"sv, toMicroseconds(event.duration));
+			if (event.scope)
+				json += fmt::format(R"(,"s":"{}")"sv, event.scope);
+			if (!event.arguments.empty())
+				json += fmt::format(R"(,"args":{{{}}})"sv, event.arguments);
+			json += '}';
+		}
+		json += "]}\n"sv;
+
+		const substrate::fd_t file{fileName, O_WRONLY | O_CREAT | O_TRUNC | O_NOCTTY, substrate::normalMode};
+		if (!file.valid() || !file.write(json.data(), json.size()))
+		{
+			console.error("Failed to write Chrome trace file '"sv, fileName.u8string(), "'"sv);
+			return false;
+		}
+		return true;
+	}
+	catch (const std::bad_alloc &)
+	{
+		console.error("Failed to allocate enough memory to build the Chrome trace"sv);
+		return false;
+	}
+} // namespace flashprog::trace
@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#ifndef TRACE_CHROME_TRACE_HXX
+#define TRACE_CHROME_TRACE_HXX
+
+#include <cstdint>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <filesystem>
+#include "usbProtocol.hxx"
+#include "traceFile.hxx"
+
+namespace flashprog::trace
+{
+	/*!
+	 * Builds a Chrome trace-event format JSON file (as loaded by chrome://tracing and Perfetto)
+	 * from the host's USB transactions and the programmer's event log, placed on a common timeline.
+	 */
+	struct chromeTrace_t final
+	{
+	private:
+		struct traceEvent_t final
+		{
+			char phase{};
+			// The scope of instant events - thread or process
+			char scope{};
+			std::string name{};
+			uint32_t process{};
+			uint32_t thread{};
+			// Relative to the start of the host's trace
+			std::chrono::nanoseconds timestamp{};
+			std::chrono::nanoseconds duration{};
+			// Pre-formatted JSON object members, without the enclosing braces
+			std::string arguments{};
+		};
+
+		std::vector<traceEvent_t> events{};
+		uint32_t deviceEventCount{};
+		// Programmer events from before this point on the timeline are discarded
+		std::chrono::nanoseconds horizon{std::chrono::nanoseconds::min()};
+
+		void addDeviceEvent(const flashProto::responses::event_t &event, std::chrono::nanoseconds timestamp);
+
+	public:
+		void addTransactions(const std::vector<transaction_t> &transactions);
+		/*!
+		 * Adds the events from a chunk of the programmer's event log. chunkTime is the time on the host's
+		 * timeline the chunk was taken at, and is used to translate the programmer's timestamps.
+		 */
+		void addDeviceEvents(const flashProto::responses::events_t &chunk, std::chrono::nanoseconds chunkTime);
+		[[nodiscard]] uint32_t deviceEvents() const noexcept { return deviceEventCount; }
+		[[nodiscard]] bool write(const std::filesystem::path &fileName) const noexcept;
+	};
+} // namespace flashprog::trace
+
+#endif /*TRACE_CHROME_TRACE_HXX*/
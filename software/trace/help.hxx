@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#ifndef TRACE_HELP_HXX
+#define TRACE_HELP_HXX
+
+#include <string_view>
+
+using namespace std::literals::string_view_literals;
+
+namespace flashprog::trace
+{
+	constexpr static auto helpString{R"(flashtrace - flashprog USB traffic trace analysis utility
+
+Usage:
+	flashtrace [options]
+	flashtrace {operation} <[options] trace>
+
+Traces are recorded by running flashprog with --record file.
+
+Options:
+	--version       Print the version information for flashtrace
+	-h, --help      Prints this help message
+
+Operations:
+	report          Summarises where the time in a trace was spent, by operation
+	replay          Drives the operations in a trace against the emulated programmer and compares
+	                the timing of the replay against the trace
+	compare         Compares the timing of a trace against a baseline trace
+	chrome          Converts a trace, along with any programmer event log captured in it, into
+	                Chrome trace-event JSON for viewing in chrome://tracing or Perfetto
+
+Options for replay:
+	--emulate file  The file to back the emulated programmer's target Flash chip with
+	--output file   Write the trace of the replay to the given file
+
+Options for replay and compare:
+	--tolerance N   How many percent slower the total transport time may be than the baseline
+	                before the comparison is considered to have failed (defaults to 5)
+
+Options for compare:
+	baseline        The trace file to use as the baseline
+
+Options for chrome:
+	output          The Chrome trace-event JSON file to write
+
+Options for report, replay, compare and chrome:
+	trace           The trace file to operate on
+
+This utility is licensed under BSD-3-Clase
+Report bugs using https://github.com/bad-alloc-heavy-industries/flashprog/issues)"sv
+	};
+} // namespace flashprog::trace
+
+#endif /*TRACE_HELP_HXX*/
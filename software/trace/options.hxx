@@ -0,0 +1,102 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#include <substrate/command_line/options>
+
+namespace flashprog::trace
+{
+	using namespace std::literals::string_view_literals;
+	using namespace substrate::commandLine;
+
+	constexpr static auto traceOption
+	{
+		option_t{optionValue_t{"trace"sv}, "The trace file to operate on"sv}
+			.valueType(optionValueType_t::path).required()
+	};
+
+	constexpr static auto toleranceOption
+	{
+		option_t
+		{
+			"--tolerance"sv,
+			"How many percent slower the total transport time may be than the baseline before\n"
+			"the comparison is considered to have failed (defaults to 5)"sv
+		}.takesParameter(optionValueType_t::unsignedInt)
+	};
+
+	constexpr static auto reportOptions{options(traceOption)};
+
+	constexpr static auto replayOptions
+	{
+		options
+		(
+			traceOption,
+			toleranceOption,
+			option_t
+			{
+				"--emulate"sv,
+				"The file to back the emulated programmer's target Flash chip with for the replay"sv
+			}.takesParameter(optionValueType_t::path),
+			option_t{"--output"sv, "Write the trace of the replay to the given file"sv}
+				.takesParameter(optionValueType_t::path)
+		)
+	};
+
+	constexpr static auto compareOptions
+	{
+		options
+		(
+			option_t{optionValue_t{"baseline"sv}, "The trace file to use as the baseline"sv}
+				.valueType(optionValueType_t::path).required(),
+			traceOption,
+			toleranceOption
+		)
+	};
+
+	constexpr static auto chromeOptions
+	{
+		options
+		(
+			traceOption,
+			option_t{optionValue_t{"output"sv}, "The Chrome trace-event JSON file to write"sv}
+				.valueType(optionValueType_t::path).required()
+		)
+	};
+
+	constexpr static auto actions
+	{
+		optionAlternations
+		({
+			{
+				"report"sv,
+				"Summarises where the time in a trace was spent, by operation"sv,
+				reportOptions,
+			},
+			{
+				"replay"sv,
+				"Drives the operations in a trace against the emulated programmer and compares\n"
+				"the timing of the replay against the trace"sv,
+				replayOptions,
+			},
+			{
+				"compare"sv,
+				"Compares the timing of a trace against a baseline trace"sv,
+				compareOptions,
+			},
+			{
+				"chrome"sv,
+				"Converts a trace, along with any programmer event log captured in it, into\n"
+				"Chrome trace-event JSON for viewing in chrome://tracing or Perfetto"sv,
+				chromeOptions,
+			},
+		})
+	};
+
+	constexpr static auto programOptions
+	{
+		options
+		(
+			option_t{optionFlagPair_t{"-h"sv, "--help"sv}, "Display this help message and exit"sv},
+			option_t{"--version"sv, "Display the version information for flashtrace and exit"sv},
+			optionSet_t{"action"sv, actions}
+		)
+	};
+} // namespace flashprog::trace
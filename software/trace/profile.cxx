@@ -0,0 +1,163 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#include <string>
+#include <set>
+#include <substrate/console>
+#include <fmt/core.h>
+#include "usbProtocol.hxx"
+#include "profile.hxx"
+
+using namespace std::literals::string_view_literals;
+using substrate::console;
+using flashProto::messages_t;
+
+namespace flashprog::trace
+{
+	std::string_view messageName(const uint8_t request) noexcept
+	{
+		switch (static_cast<messages_t>(request))
+		{
+			case messages_t::deviceCount:
+				return "deviceCount"sv;
+			case messages_t::listDevice:
+				return "listDevice"sv;
+			case messages_t::targetDevice:
+				return "targetDevice"sv;
+			case messages_t::erase:
+				return "erase"sv;
+			case messages_t::read:
+				return "read"sv;
+			case messages_t::write:
+				return "write"sv;
+			case messages_t::verifiedWrite:
+				return "verifiedWrite"sv;
+			case messages_t::resetTarget:
+				return "resetTarget"sv;
+			case messages_t::status:
+				return "status"sv;
+			case messages_t::abort:
+				return "abort"sv;
+			case messages_t::sfdp:
+				return "sfdp"sv;
+			case messages_t::readRange:
+				return "readRange"sv;
+			case messages_t::stats:
+				return "stats"sv;
+			case messages_t::events:
+				return "events"sv;
+			case messages_t::benchmark:
+				return "benchmark"sv;
+			case messages_t::busClock:
+				return "busClock"sv;
+			case messages_t::fill:
+				return "fill"sv;
+			case messages_t::blankCheck:
+				return "blankCheck"sv;
+			case messages_t::compressedWrite:
+				return "compressedWrite"sv;
+			case messages_t::compressedRead:
+				return "compressedRead"sv;
+			case messages_t::uniqueID:
+				return "uniqueID"sv;
+			case messages_t::checksum:
+				return "checksum"sv;
+			case messages_t::badBlocks:
+				return "badBlocks"sv;
+		}
+		return "unknown request"sv;
+	}
+
+	std::string_view transactionName(const traceRecord_t &record) noexcept
+	{
+		const auto directionIn{bool(record.endpoint & 0x80U)};
+		switch (record.kind)
+		{
+			case transferKind_t::claimInterface:
+				return "claimInterface"sv;
+			case transferKind_t::releaseInterface:
+				return "releaseInterface"sv;
+			case transferKind_t::interrupt:
+				return directionIn ? "interrupt IN"sv : "interrupt OUT"sv;
+			case transferKind_t::bulk:
+				return directionIn ? "bulk IN"sv : "bulk OUT"sv;
+			case transferKind_t::control:
+				return messageName(record.request);
+		}
+		return "unknown"sv;
+	}
+
+	profile_t buildProfile(const std::vector<transaction_t> &transactions)
+	{
+		profile_t profile{};
+		for (const auto &transaction : transactions)
+		{
+			auto &entry{profile.entries[transactionName(transaction.record)]};
+			++entry.count;
+			if (!transaction.record.result)
+				++entry.failures;
+			entry.bytes += transaction.record.length;
+			entry.time += transaction.duration();
+			profile.transportTime += transaction.duration();
+		}
+		if (!transactions.empty())
+			profile.traceTime = transactions.back().endTime() - transactions.front().startTime();
+		return profile;
+	}
+
+	static double toMilliseconds(const std::chrono::nanoseconds time) noexcept
+		{ return std::chrono::duration<double, std::milli>{time}.count(); }
+
+	void displayProfile(const profile_t &profile) noexcept
+	{
+		console.info(fmt::format("{:<18} {:>8} {:>8} {:>12} {:>12} {:>10} {:>6}"sv,
+			"Operation"sv, "Count"sv, "Failed"sv, "Bytes"sv, "Total (ms)"sv, "Mean (us)"sv, "Share"sv));
+		for (const auto &[name, entry] : profile.entries)
+		{
+			const auto share{profile.transportTime.count() ?
+				(double(entry.time.count()) * 100.0) / double(profile.transportTime.count()) : 0.0};
+			console.info(fmt::format("{:<18} {:>8} {:>8} {:>12} {:>12.3f} {:>10.1f} {:>5.1f}%"sv,
+				name, entry.count, entry.failures, entry.bytes, toMilliseconds(entry.time),
+				toMilliseconds(entry.time) * 1000.0 / entry.count, share));
+		}
+		console.info(fmt::format("Time spent in the transport: {:.3f}ms of {:.3f}ms traced"sv,
+			toMilliseconds(profile.transportTime), toMilliseconds(profile.traceTime)));
+	}
+
+	static double percentageChange(const std::chrono::nanoseconds baseline, const std::chrono::nanoseconds current) noexcept
+	{
+		if (!baseline.count())
+			return current.count() ? 100.0 : 0.0;
+		return (double(current.count() - baseline.count()) * 100.0) / double(baseline.count());
+	}
+
+	bool compareProfiles(const profile_t &baseline, const profile_t &current, const uint32_t tolerance) noexcept
+	{
+		console.info(fmt::format("{:<18} {:>8} {:>8} {:>14} {:>14} {:>9}"sv,
+			"Operation"sv, "Count"sv, "(was)"sv, "Total (ms)"sv, "(was)"sv, "Change"sv));
+		// Walk the union of the operations in both profiles
+		std::set<std::string_view> names{};
+		for (const auto &entry : baseline.entries)
+			names.insert(entry.first);
+		for (const auto &entry : current.entries)
+			names.insert(entry.first);
+		for (const auto &name : names)
+		{
+			const auto before{baseline.entries.find(name)};
+			const auto after{current.entries.find(name)};
+			const auto &was{before == baseline.entries.end() ? profileEntry_t{} : before->second};
+			const auto &now{after == current.entries.end() ? profileEntry_t{} : after->second};
+			console.info(fmt::format("{:<18} {:>8} {:>8} {:>14.3f} {:>14.3f} {:>+8.1f}%"sv,
+				name, now.count, was.count, toMilliseconds(now.time), toMilliseconds(was.time),
+				percentageChange(was.time, now.time)));
+		}
+
+		const auto change{percentageChange(baseline.transportTime, current.transportTime)};
+		console.info(fmt::format("Time spent in the transport: {:.3f}ms, was {:.3f}ms ({:+.1f}%)"sv,
+			toMilliseconds(current.transportTime), toMilliseconds(baseline.transportTime), change));
+		if (change > double(tolerance))
+		{
+			console.error("Transport time regressed by more than the allowed "sv, tolerance, '%');
+			return false;
+		}
+		return true;
+	}
+} // namespace flashprog::trace
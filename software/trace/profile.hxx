@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#ifndef TRACE_PROFILE_HXX
+#define TRACE_PROFILE_HXX
+
+#include <cstdint>
+#include <chrono>
+#include <map>
+#include <vector>
+#include <string_view>
+#include "traceFile.hxx"
+
+namespace flashprog::trace
+{
+	struct profileEntry_t final
+	{
+		uint32_t count{};
+		uint32_t failures{};
+		uint64_t bytes{};
+		std::chrono::nanoseconds time{};
+	};
+
+	/*!
+	 * Summarises a trace by how many operations of each kind it contains, how much data they
+	 * moved and how long they spent in the transport. Control transfers are broken down by
+	 * their flashProto::messages_t request.
+	 */
+	struct profile_t final
+	{
+		std::map<std::string_view, profileEntry_t> entries{};
+		// Total time spent in the transport, and the wall-clock length of the trace
+		std::chrono::nanoseconds transportTime{};
+		std::chrono::nanoseconds traceTime{};
+	};
+
+	[[nodiscard]] std::string_view messageName(uint8_t request) noexcept;
+	[[nodiscard]] std::string_view transactionName(const traceRecord_t &record) noexcept;
+	[[nodiscard]] profile_t buildProfile(const std::vector<transaction_t> &transactions);
+	void displayProfile(const profile_t &profile) noexcept;
+	/*!
+	 * Displays the change in each entry between two profiles, returning false if the
+	 * total transport time of the current profile regressed by more than tolerance percent.
+	 */
+	[[nodiscard]] bool compareProfiles(const profile_t &baseline, const profile_t &current,
+		uint32_t tolerance) noexcept;
+} // namespace flashprog::trace
+
+#endif /*TRACE_PROFILE_HXX*/
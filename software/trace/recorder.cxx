@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#include <substrate/console>
+#include <substrate/utility>
+#include "recorder.hxx"
+
+using namespace std::literals::string_view_literals;
+using substrate::console;
+using std::chrono::steady_clock;
+
+namespace flashprog::trace
+{
+	recordingTransport_t::recordingTransport_t(std::unique_ptr<usbTransport_t> &&transport_,
+		const std::filesystem::path &fileName) noexcept : transport{std::move(transport_)}, writer{fileName} { }
+
+	bool recordingTransport_t::claimInterface(const int32_t interfaceNumber) noexcept
+	{
+		const auto startTime{steady_clock::now()};
+		const auto result{transport->claimInterface(interfaceNumber)};
+		const auto endTime{steady_clock::now()};
+		traceRecord_t record{};
+		record.kind = transferKind_t::claimInterface;
+		record.value = uint16_t(interfaceNumber);
+		record.result = result;
+		writer.append(record, startTime, endTime, nullptr);
+		return result;
+	}
+
+	bool recordingTransport_t::releaseInterface(const int32_t interfaceNumber) noexcept
+	{
+		const auto startTime{steady_clock::now()};
+		const auto result{transport->releaseInterface(interfaceNumber)};
+		const auto endTime{steady_clock::now()};
+		traceRecord_t record{};
+		record.kind = transferKind_t::releaseInterface;
+		record.value = uint16_t(interfaceNumber);
+		record.result = result;
+		writer.append(record, startTime, endTime, nullptr);
+		return result;
+	}
+
+	bool recordingTransport_t::interruptTransfer(const uint8_t endpoint, void *const bufferPtr,
+		const int32_t bufferLen) noexcept
+	{
+		const auto startTime{steady_clock::now()};
+		const auto result{transport->interruptTransfer(endpoint, bufferPtr, bufferLen)};
+		const auto endTime{steady_clock::now()};
+		traceRecord_t record{};
+		record.kind = transferKind_t::interrupt;
+		record.endpoint = endpoint;
+		record.length = uint32_t(bufferLen);
+		record.result = result;
+		writer.append(record, startTime, endTime, bufferPtr);
+		return result;
+	}
+
+	bool recordingTransport_t::bulkTransfer(const uint8_t endpoint, void *const bufferPtr,
+		const int32_t bufferLen) noexcept
+	{
+		const auto startTime{steady_clock::now()};
+		const auto result{transport->bulkTransfer(endpoint, bufferPtr, bufferLen)};
+		const auto endTime{steady_clock::now()};
+		traceRecord_t record{};
+		record.kind = transferKind_t::bulk;
+		record.endpoint = endpoint;
+		record.length = uint32_t(bufferLen);
+		record.result = result;
+		writer.append(record, startTime, endTime, bufferPtr);
+		return result;
+	}
+
+	bool recordingTransport_t::controlTransfer(const requestType_t requestType, const uint8_t request,
+		const uint16_t value, const uint16_t index, void *const bufferPtr, const uint16_t bufferLen) noexcept
+	{
+		const auto startTime{steady_clock::now()};
+		const auto result{transport->controlTransfer(requestType, request, value, index, bufferPtr, bufferLen)};
+		const auto endTime{steady_clock::now()};
+		traceRecord_t record{};
+		record.kind = transferKind_t::control;
+		record.endpoint = requestType;
+		record.request = request;
+		record.value = value;
+		record.index = index;
+		record.length = bufferLen;
+		record.result = result;
+		writer.append(record, startTime, endTime, bufferPtr);
+		return result;
+	}
+
+	usbDeviceHandle_t record(usbDeviceHandle_t &&device, const std::filesystem::path &fileName) noexcept
+	{
+		auto transport{substrate::make_unique_nothrow<recordingTransport_t>(device.releaseTransport(), fileName)};
+		if (!transport || !transport->valid())
+			return {};
+		console.info("Recording programmer traffic to '"sv, fileName.u8string(), "'"sv);
+		return {std::move(transport)};
+	}
+} // namespace flashprog::trace
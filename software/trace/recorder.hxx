@@ -0,0 +1,44 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#ifndef TRACE_RECORDER_HXX
+#define TRACE_RECORDER_HXX
+
+#include <memory>
+#include <filesystem>
+#include "usbDevice.hxx"
+#include "traceFile.hxx"
+
+namespace flashprog::trace
+{
+	/*!
+	 * Wraps another transport, passing every operation through to it while logging the operation,
+	 * how long it took, its result and any data moved to a trace file.
+	 */
+	struct recordingTransport_t final : usbTransport_t
+	{
+	private:
+		std::unique_ptr<usbTransport_t> transport;
+		traceWriter_t writer;
+
+	public:
+		recordingTransport_t(std::unique_ptr<usbTransport_t> &&transport_,
+			const std::filesystem::path &fileName) noexcept;
+		recordingTransport_t(const recordingTransport_t &) = delete;
+		recordingTransport_t(recordingTransport_t &&) = delete;
+		~recordingTransport_t() noexcept final = default;
+		recordingTransport_t &operator =(const recordingTransport_t &) = delete;
+		recordingTransport_t &operator =(recordingTransport_t &&) = delete;
+
+		[[nodiscard]] bool valid() const noexcept { return transport && writer.valid(); }
+
+		[[nodiscard]] bool claimInterface(int32_t interfaceNumber) noexcept final;
+		[[nodiscard]] bool releaseInterface(int32_t interfaceNumber) noexcept final;
+		[[nodiscard]] bool interruptTransfer(uint8_t endpoint, void *bufferPtr, int32_t bufferLen) noexcept final;
+		[[nodiscard]] bool bulkTransfer(uint8_t endpoint, void *bufferPtr, int32_t bufferLen) noexcept final;
+		[[nodiscard]] bool controlTransfer(requestType_t requestType, uint8_t request, uint16_t value,
+			uint16_t index, void *bufferPtr, uint16_t bufferLen) noexcept final;
+	};
+
+	[[nodiscard]] usbDeviceHandle_t record(usbDeviceHandle_t &&device, const std::filesystem::path &fileName) noexcept;
+} // namespace flashprog::trace
+
+#endif /*TRACE_RECORDER_HXX*/
@@ -0,0 +1,182 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#include <cstring>
+#include <new>
+#include <thread>
+#include <substrate/console>
+#include <substrate/utility>
+#include "replay.hxx"
+
+using namespace std::literals::string_view_literals;
+using substrate::console;
+using std::chrono::steady_clock;
+
+namespace flashprog::trace
+{
+	replayTransport_t::replayTransport_t(std::vector<transaction_t> &&transactions_) noexcept :
+		transactions{std::move(transactions_)} { }
+
+	replayTransport_t::~replayTransport_t() noexcept
+	{
+		if (position != transactions.size())
+			console.warning("Host stopped after "sv, position, " of "sv, transactions.size(), " recorded operations"sv);
+	}
+
+	bool replayTransport_t::replay(const traceRecord_t &expected, void *const bufferPtr) noexcept
+	{
+		if (position == transactions.size())
+		{
+			console.error("Host issued more operations than were recorded in the trace"sv);
+			return false;
+		}
+
+		const auto &transaction{transactions[position]};
+		const auto &record{transaction.record};
+		if (record.kind != expected.kind ||
+			record.endpoint != expected.endpoint ||
+			record.request != expected.request ||
+			record.value != expected.value ||
+			record.index != expected.index ||
+			record.length != expected.length ||
+			// The data phase of controller out control transfers must match too, bulk data is allowed to differ
+			(record.kind == transferKind_t::control && !transaction.directionIn() && record.length &&
+				std::memcmp(transaction.payload.data(), bufferPtr, record.length) != 0))
+		{
+			console.error("Host diverged from the trace at operation "sv, position);
+			return false;
+		}
+		++position;
+
+		std::this_thread::sleep_for(transaction.duration());
+		if (transaction.directionIn() && record.length)
+			std::memcpy(bufferPtr, transaction.payload.data(), record.length);
+		return record.result;
+	}
+
+	bool replayTransport_t::claimInterface(const int32_t interfaceNumber) noexcept
+	{
+		traceRecord_t record{};
+		record.kind = transferKind_t::claimInterface;
+		record.value = uint16_t(interfaceNumber);
+		return replay(record, nullptr);
+	}
+
+	bool replayTransport_t::releaseInterface(const int32_t interfaceNumber) noexcept
+	{
+		traceRecord_t record{};
+		record.kind = transferKind_t::releaseInterface;
+		record.value = uint16_t(interfaceNumber);
+		return replay(record, nullptr);
+	}
+
+	bool replayTransport_t::interruptTransfer(const uint8_t endpoint, void *const bufferPtr,
+		const int32_t bufferLen) noexcept
+	{
+		traceRecord_t record{};
+		record.kind = transferKind_t::interrupt;
+		record.endpoint = endpoint;
+		record.length = uint32_t(bufferLen);
+		return replay(record, bufferPtr);
+	}
+
+	bool replayTransport_t::bulkTransfer(const uint8_t endpoint, void *const bufferPtr,
+		const int32_t bufferLen) noexcept
+	{
+		traceRecord_t record{};
+		record.kind = transferKind_t::bulk;
+		record.endpoint = endpoint;
+		record.length = uint32_t(bufferLen);
+		return replay(record, bufferPtr);
+	}
+
+	bool replayTransport_t::controlTransfer(const requestType_t requestType, const uint8_t request,
+		const uint16_t value, const uint16_t index, void *const bufferPtr, const uint16_t bufferLen) noexcept
+	{
+		traceRecord_t record{};
+		record.kind = transferKind_t::control;
+		record.endpoint = requestType;
+		record.request = request;
+		record.value = value;
+		record.index = index;
+		record.length = bufferLen;
+		return replay(record, bufferPtr);
+	}
+
+	usbDeviceHandle_t openReplay(const std::filesystem::path &fileName) noexcept
+	{
+		auto transactions{readTrace(fileName)};
+		if (!transactions)
+			return {};
+		console.info("Replaying "sv, transactions->size(), " recorded operations from '"sv,
+			fileName.u8string(), "'"sv);
+		return {substrate::make_unique_nothrow<replayTransport_t>(std::move(*transactions))};
+	}
+
+	std::optional<std::vector<transaction_t>> replayAgainst(usbTransport_t &transport,
+		const std::vector<transaction_t> &transactions) noexcept try
+	{
+		std::vector<transaction_t> result{};
+		result.reserve(transactions.size());
+		std::vector<uint8_t> buffer{};
+		size_t mismatches{};
+		const auto traceStart{steady_clock::now()};
+		auto previousEnd{transactions.empty() ? std::chrono::nanoseconds{} : transactions.front().startTime()};
+
+		for (const auto &transaction : transactions)
+		{
+			const auto &record{transaction.record};
+			// Preserve the time the host spent doing other things between the recorded operations
+			if (const auto hostTime{transaction.startTime() - previousEnd}; hostTime.count() > 0)
+				std::this_thread::sleep_for(hostTime);
+			previousEnd = transaction.endTime();
+
+			buffer = transaction.payload;
+			const auto startTime{steady_clock::now()};
+			const auto success
+			{
+				[&]()
+				{
+					switch (record.kind)
+					{
+						case transferKind_t::claimInterface:
+							return transport.claimInterface(record.value);
+						case transferKind_t::releaseInterface:
+							return transport.releaseInterface(record.value);
+						case transferKind_t::interrupt:
+							return transport.interruptTransfer(record.endpoint, buffer.data(), int32_t(buffer.size()));
+						case transferKind_t::bulk:
+							return transport.bulkTransfer(record.endpoint, buffer.data(), int32_t(buffer.size()));
+						case transferKind_t::control:
+						{
+							requestType_t requestType{};
+							requestType.recipient(static_cast<recipient_t>(record.endpoint & 0x1FU));
+							requestType.type(static_cast<request_t>(record.endpoint & 0x60U));
+							requestType.dir(static_cast<endpointDir_t>(record.endpoint & 0x80U));
+							return transport.controlTransfer(requestType, record.request, record.value, record.index,
+								buffer.empty() ? nullptr : buffer.data(), uint16_t(buffer.size()));
+						}
+					}
+					return false;
+				}()
+			};
+			const auto endTime{steady_clock::now()};
+
+			auto &replayed{result.emplace_back()};
+			replayed.record = record;
+			replayed.record.result = success;
+			replayed.record.startTime = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(startTime - traceStart).count());
+			replayed.record.duration = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count());
+			replayed.payload = buffer;
+			if (success != bool(record.result))
+				++mismatches;
+		}
+
+		if (mismatches)
+			console.warning(mismatches, " operations had a different outcome on replay to when recorded"sv);
+		return result;
+	}
+	catch (const std::bad_alloc &)
+	{
+		console.error("Failed to allocate enough memory to replay the trace"sv);
+		return std::nullopt;
+	}
+} // namespace flashprog::trace
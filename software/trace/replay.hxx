@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#ifndef TRACE_REPLAY_HXX
+#define TRACE_REPLAY_HXX
+
+#include <cstddef>
+#include <vector>
+#include <optional>
+#include <filesystem>
+#include "usbDevice.hxx"
+#include "traceFile.hxx"
+
+namespace flashprog::trace
+{
+	/*!
+	 * Plays the device side of a recorded trace back to the host, checking that the host issues
+	 * exactly the same sequence of operations as were recorded and answering them with the
+	 * recorded results. Each operation takes as long to complete as it did when recorded, so the
+	 * host code can be timed against a fixed device.
+	 */
+	struct replayTransport_t final : usbTransport_t
+	{
+	private:
+		std::vector<transaction_t> transactions;
+		size_t position{};
+
+		[[nodiscard]] bool replay(const traceRecord_t &expected, void *bufferPtr) noexcept;
+
+	public:
+		replayTransport_t(std::vector<transaction_t> &&transactions_) noexcept;
+		replayTransport_t(const replayTransport_t &) = delete;
+		replayTransport_t(replayTransport_t &&) = delete;
+		~replayTransport_t() noexcept final;
+		replayTransport_t &operator =(const replayTransport_t &) = delete;
+		replayTransport_t &operator =(replayTransport_t &&) = delete;
+
+		[[nodiscard]] bool claimInterface(int32_t interfaceNumber) noexcept final;
+		[[nodiscard]] bool releaseInterface(int32_t interfaceNumber) noexcept final;
+		[[nodiscard]] bool interruptTransfer(uint8_t endpoint, void *bufferPtr, int32_t bufferLen) noexcept final;
+		[[nodiscard]] bool bulkTransfer(uint8_t endpoint, void *bufferPtr, int32_t bufferLen) noexcept final;
+		[[nodiscard]] bool controlTransfer(requestType_t requestType, uint8_t request, uint16_t value,
+			uint16_t index, void *bufferPtr, uint16_t bufferLen) noexcept final;
+	};
+
+	[[nodiscard]] usbDeviceHandle_t openReplay(const std::filesystem::path &fileName) noexcept;
+
+	/*!
+	 * Drives the host side of a recorded trace against a transport, preserving the time the host
+	 * spent between operations, and returns the resulting trace as seen from this run.
+	 */
+	[[nodiscard]] std::optional<std::vector<transaction_t>> replayAgainst(usbTransport_t &transport,
+		const std::vector<transaction_t> &transactions) noexcept;
+} // namespace flashprog::trace
+
+#endif /*TRACE_REPLAY_HXX*/
@@ -0,0 +1,99 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#include <new>
+#include <substrate/console>
+#include "traceFile.hxx"
+
+using namespace std::literals::string_view_literals;
+using substrate::console;
+
+namespace flashprog::trace
+{
+	traceWriter_t::traceWriter_t(const std::filesystem::path &fileName) noexcept :
+		file{fileName, O_WRONLY | O_CREAT | O_TRUNC | O_NOCTTY, substrate::normalMode}
+	{
+		if (!file.valid() || !file.write(traceHeader_t{}))
+		{
+			console.error("Failed to create trace file '"sv, fileName.u8string(), "'"sv);
+			file = {};
+		}
+	}
+
+	bool traceWriter_t::append(traceRecord_t record, const std::chrono::steady_clock::time_point startTime,
+		const std::chrono::steady_clock::time_point endTime, const void *const payload) noexcept
+	{
+		if (!file.valid())
+			return false;
+		record.startTime = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(startTime - traceStart).count());
+		record.duration = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count());
+		if (!file.write(record) ||
+			(record.length && !file.write(payload, record.length)))
+		{
+			console.error("Failed to write transaction to trace file, disabling tracing"sv);
+			file = {};
+			return false;
+		}
+		return true;
+	}
+
+	std::optional<std::vector<transaction_t>> readTrace(const std::filesystem::path &fileName) noexcept try
+	{
+		const substrate::fd_t file{fileName, O_RDONLY | O_NOCTTY};
+		if (!file.valid())
+		{
+			console.error("Failed to open trace file '"sv, fileName.u8string(), "'"sv);
+			return std::nullopt;
+		}
+
+		traceHeader_t header{};
+		if (!file.read(header) || header.magic != traceMagic || header.version != traceVersion)
+		{
+			console.error("'"sv, fileName.u8string(), "' is not a flashprog trace, or is of an unsupported version"sv);
+			return std::nullopt;
+		}
+
+		const auto fileLength{file.length()};
+		std::vector<transaction_t> transactions{};
+		while (file.tell() < fileLength)
+		{
+			auto &transaction{transactions.emplace_back()};
+			if (!file.read(transaction.record))
+			{
+				console.error("Trace file truncated in transaction "sv, transactions.size() - 1U);
+				return std::nullopt;
+			}
+			transaction.payload.resize(transaction.record.length);
+			if (!file.read(transaction.payload.data(), transaction.payload.size()))
+			{
+				console.error("Trace file truncated in the payload for transaction "sv, transactions.size() - 1U);
+				return std::nullopt;
+			}
+		}
+		return transactions;
+	}
+	catch (const std::bad_alloc &)
+	{
+		console.error("Failed to allocate enough memory to hold the trace"sv);
+		return std::nullopt;
+	}
+
+	bool writeTrace(const std::filesystem::path &fileName, const std::vector<transaction_t> &transactions) noexcept
+	{
+		const substrate::fd_t file{fileName, O_WRONLY | O_CREAT | O_TRUNC | O_NOCTTY, substrate::normalMode};
+		if (!file.valid() || !file.write(traceHeader_t{}))
+		{
+			console.error("Failed to create trace file '"sv, fileName.u8string(), "'"sv);
+			return false;
+		}
+		for (const auto &transaction : transactions)
+		{
+			if (!file.write(transaction.record) ||
+				(!transaction.payload.empty() &&
+					!file.write(transaction.payload.data(), transaction.payload.size())))
+			{
+				console.error("Failed to write transaction to trace file '"sv, fileName.u8string(), "'"sv);
+				return false;
+			}
+		}
+		return true;
+	}
+} // namespace flashprog::trace
@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: BSD-3-Clause
+#ifndef TRACE_TRACE_FILE_HXX
+#define TRACE_TRACE_FILE_HXX
+
+#include <cstdint>
+#include <array>
+#include <vector>
+#include <chrono>
+#include <optional>
+#include <filesystem>
+#include <substrate/fd>
+
+namespace flashprog::trace
+{
+	/*!
+	 * Traces are a header followed by a sequence of records, one per transport operation, each
+	 * immediately followed by the record's payload. All values are stored in host byte order.
+	 */
+	constexpr static std::array<char, 4> traceMagic{{'F', 'P', 'T', 'R'}};
+	constexpr static uint16_t traceVersion{1U};
+
+	enum class transferKind_t : uint8_t
+	{
+		claimInterface,
+		releaseInterface,
+		interrupt,
+		bulk,
+		control
+	};
+
+	struct traceHeader_t final
+	{
+		std::array<char, 4> magic{traceMagic};
+		uint16_t version{traceVersion};
+		uint16_t reserved{};
+	};
+
+	struct traceRecord_t final
+	{
+		transferKind_t kind{};
+		// The endpoint address for interrupt and bulk transfers, the request type for control transfers
+		uint8_t endpoint{};
+		uint8_t request{};
+		uint8_t result{};
+		// The interface number for claim and release operations
+		uint16_t value{};
+		uint16_t index{};
+		// Number of bytes in the payload following this record
+		uint32_t length{};
+		uint32_t reserved{};
+		// When the operation was started relative to the start of the trace, and how long it took, in ns
+		uint64_t startTime{};
+		uint64_t duration{};
+	};
+	static_assert(sizeof(traceRecord_t) == 32U);
+
+	struct transaction_t final
+	{
+		traceRecord_t record{};
+		// The data sent for controller out transfers, or received for controller in transfers
+		std::vector<uint8_t> payload{};
+
+		[[nodiscard]] bool directionIn() const noexcept { return record.endpoint & 0x80U; }
+		[[nodiscard]] std::chrono::nanoseconds startTime() const noexcept
+			{ return std::chrono::nanoseconds{record.startTime}; }
+		[[nodiscard]] std::chrono::nanoseconds duration() const noexcept
+			{ return std::chrono::nanoseconds{record.duration}; }
+		[[nodiscard]] std::chrono::nanoseconds endTime() const noexcept { return startTime() + duration(); }
+	};
+
+	struct traceWriter_t final
+	{
+	private:
+		substrate::fd_t file{};
+		std::chrono::steady_clock::time_point traceStart{std::chrono::steady_clock::now()};
+
+	public:
+		traceWriter_t(const std::filesystem::path &fileName) noexcept;
+
+		[[nodiscard]] bool valid() const noexcept { return file.valid(); }
+		[[nodiscard]] std::chrono::steady_clock::time_point start() const noexcept { return traceStart; }
+		bool append(traceRecord_t record, std::chrono::steady_clock::time_point startTime,
+			std::chrono::steady_clock::time_point endTime, const void *payload) noexcept;
+	};
+
+	[[nodiscard]] std::optional<std::vector<transaction_t>> readTrace(const std::filesystem::path &fileName) noexcept;
+	[[nodiscard]] bool writeTrace(const std::filesystem::path &fileName,
+		const std::vector<transaction_t> &transactions) noexcept;
+} // namespace flashprog::trace
+
+#endif /*TRACE_TRACE_FILE_HXX*/